@@ -10,5 +10,9 @@ REM Compile the vertex shader
 REM Compile the fragment shader
 "%GLSLC%" "%SHADER_DIR%\simple_shader.frag" -o "%SHADER_DIR%\simple_shader.frag.spv"
 
+REM Compile the GPU culling compute shaders
+"%GLSLC%" "%SHADER_DIR%\gpu_cull.comp" -o "%SHADER_DIR%\gpu_cull.comp.spv"
+"%GLSLC%" "%SHADER_DIR%\hiz_downsample.comp" -o "%SHADER_DIR%\hiz_downsample.comp.spv"
+
 echo Shader compilation complete.
 pause
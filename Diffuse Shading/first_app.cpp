@@ -2,13 +2,17 @@
 #include "simple_render_system.hpp"
 #include "lve_camera.hpp"
 #include "keyboard_movement_controller.hpp"
+#include "lve_gpu_culling.hpp"
 
 // std
 #include <stdexcept>
 #include <array>
 #include <cassert>
 #include <chrono>
+#include <cstdio>
 #include <iostream>
+#include <memory>
+#include <string>
 
 // libs
 #define GLM_FORCE_RADIANS // forces in radians and not degrees
@@ -17,6 +21,29 @@
 #include <glm/gtc/constants.hpp>
 
 namespace lve {
+
+	namespace {
+
+		// " | gpu avg / p99 ms" of the whole frame, nothing until the profiler has measured something
+		std::string gpuTimeStatus(const LveGpuProfiler& profiler) {
+			const LveGpuProfiler::Stats stats = profiler.getStats("frame");
+			if (stats.samples == 0)
+				return "";
+
+			char status[64];
+			std::snprintf(status, sizeof(status), " | gpu %.2f / %.2f ms", stats.avgMs, stats.p99Ms);
+			return status;
+
+		} // gpuTimeStatus
+
+		// " | visible / culled" objects of the last frame
+		std::string cullStatus(const SimpleRenderSystem::CullStats& stats) {
+			return " | " + std::to_string(stats.visible) + " visible / " + std::to_string(stats.culled) + " culled";
+
+		} // cullStatus
+
+	} // namespace
+
 	FirstApp::FirstApp() {
 		loadGameObjects();
 
@@ -26,6 +53,13 @@ namespace lve {
 	void FirstApp::run() {
 
 		SimpleRenderSystem simpleRenderSystem(lveDevice, lveRenderer.getSwapChainRenderPass());
+
+		// culls and picks LODs in compute shaders where the device can start indirect draws at any instance,
+		// the CPU paths below are the fallback
+		std::unique_ptr<LveGpuCulling> gpuCulling = LveGpuCulling::create(lveDevice);
+		if (gpuCulling)
+			gpuCulling->setScene(gameObjects);
+
 		LveCamera camera{};
 		camera.setViewTarget(glm::vec3(-1.f, -2.f, 2.f), glm::vec3(0.f, 0.f, 2.5f));
 
@@ -35,6 +69,10 @@ namespace lve {
 
 		auto currentTime = std::chrono::high_resolution_clock::now();
 
+		// P cycles through the present policies, the title shows what the surface gave us, how fast it runs and what got culled
+		bool presentKeyWasDown = false;
+		float titleTimer = 0.f;
+
 		while (!lveWindow.shouldClose()) { // the condition checks if they have noc closed it
 
 			auto newTime = std::chrono::high_resolution_clock::now();
@@ -48,25 +86,76 @@ namespace lve {
 
 			glfwPollEvents(); // a window processing events call
 
+			const bool presentKeyDown = glfwGetKey(lveWindow.getGLFWwindow(), GLFW_KEY_P) == GLFW_PRESS;
+			if (presentKeyDown && !presentKeyWasDown) {
+				const int policy = (static_cast<int>(lveRenderer.getSwapChainConfig().presentPolicy) + 1) % 4;
+				lveRenderer.setPresentPolicy(static_cast<LvePresentPolicy>(policy));
+
+			} // if
+
+			presentKeyWasDown = presentKeyDown;
+
+			titleTimer += frameTime;
+			if (titleTimer >= 1.f) {
+				titleTimer = 0.f;
+				lveWindow.setTitleStatus(std::string{ LveSwapChain::presentModeName(lveRenderer.getPresentMode()) } + " | "
+					+ std::to_string(static_cast<int>(lveRenderer.getFramesPerSecond() + 0.5f)) + " fps" + gpuTimeStatus(lveRenderer.getGpuProfiler())
+					+ (gpuCulling ? " | culled on the gpu" : cullStatus(simpleRenderSystem.getCullStats())));
+
+			} // if
+
 			float aspect = lveRenderer.getAspectRatio();
 			camera.setPerspectiveProjection(glm::radians(50.f), aspect, 0.1f, 10.f);
 
+			// hands finished models to the GPU and flips the ones whose uploads are done to resident
+			modelLoader.update();
+
 			if (auto commandBuffer = lveRenderer.beginFrame()) {
-				lveRenderer.beginSwapChainRenderPass(commandBuffer);
-				simpleRenderSystem.renderGameObjects(commandBuffer, gameObjects, camera);
+				const uint32_t frameIndex = static_cast<uint32_t>(lveRenderer.getFrameIndex());
+				// compute work has to stay outside the render pass
+				if (gpuCulling) {
+					LveGpuProfiler::Scope gpuScope{ lveRenderer.getGpuProfiler(), commandBuffer, "gpu culling" };
+					gpuCulling->cull(commandBuffer, frameIndex, camera);
+
+				} // if
+
+				if (gpuCulling) {
+					lveRenderer.beginSwapChainRenderPass(commandBuffer);
+					simpleRenderSystem.renderGameObjectsGpuCulled(commandBuffer, frameIndex, *gpuCulling);
+
+				} else if (gameObjects.size() >= SimpleRenderSystem::MIN_OBJECTS_PER_SLICE * 2) {
+					// big scenes are recorded on every core, a single slice would only add the cost of a secondary command buffer
+					lveRenderer.beginSwapChainRenderPass(commandBuffer, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+					simpleRenderSystem.renderGameObjectsParallel(lveRenderer, commandBuffer, gameObjects, camera, recordWorkers);
+
+				} else {
+
+					lveRenderer.beginSwapChainRenderPass(commandBuffer);
+					LveGpuProfiler::Scope gpuScope{ lveRenderer.getGpuProfiler(), commandBuffer, "simple render system" };
+					simpleRenderSystem.renderGameObjectsIndirect(commandBuffer, frameIndex, gameObjects, camera);
+
+				} // else
+
 				lveRenderer.endSwapChainRenderPass(commandBuffer);
+
+				// next frame tests its objects against what this one drew
+				if (gpuCulling)
+					gpuCulling->buildDepthPyramid(commandBuffer, frameIndex, lveRenderer.getDepthImageView(), lveRenderer.getExtent());
+
 				lveRenderer.endFrame();
 
 			} // if
 
 		} // while
 
-		vkDeviceWaitIdle(lveDevice.device());
+		lveDevice.waitIdle();
 
 	} // run
 
 	void FirstApp::loadGameObjects() {
-		std::shared_ptr<LveModel> lveModel = LveModel::createModelFromFile(lveDevice, "models/Snorlax.obj");
+		// returns right away, the object is not drawn until the model is resident so the first frame does not wait for it
+		// every other object asking the registry for the same file gets this same model and its buffers
+		std::shared_ptr<LveModel> lveModel = modelRegistry.getModel("models/Snorlax.obj");
 
 		// we need to make sure our objects are within a Viewing Volume,
 		// Viewing Volume: only what is inside the viewing volume is displayed
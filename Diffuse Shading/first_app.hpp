@@ -4,6 +4,9 @@
 #include "lve_device.hpp"
 #include "lve_renderer.hpp"
 #include "lve_game_object.hpp"
+#include "lve_model_loader.hpp"
+#include "lve_model_registry.hpp"
+#include "lve_thread_pool.hpp"
 
 // std
 #include <memory>
@@ -29,6 +32,9 @@ namespace lve {
         LveWindow lveWindow{ WIDTH, HEIGHT, "Hello Vulkan!" };
         LveDevice lveDevice{ lveWindow };
         LveRenderer lveRenderer{ lveWindow, lveDevice };
+        LveModelLoader modelLoader{ lveDevice };
+        LveModelRegistry modelRegistry{ modelLoader };
+        LveThreadPool recordWorkers{}; // records slices of big scenes into secondary command buffers
         std::unique_ptr<LveModel> lveModel;
 
         std::vector<LveGameObject> gameObjects;
@@ -0,0 +1,479 @@
+#include "lve_benchmark.hpp"
+#include "lve_model.hpp"
+#include "lve_mesh_cache.hpp"
+#include "lve_mesh_optimizer.hpp"
+#include "lve_obj_parser.hpp"
+#include "lve_vertex_weld.hpp"
+#include "lve_device.hpp"
+#include "lve_renderer.hpp"
+#include "lve_model_loader.hpp"
+#include "lve_camera.hpp"
+#include "lve_game_object.hpp"
+#include "simple_render_system.hpp"
+#include "lve_thread_pool.hpp"
+#include "lve_gpu_culling.hpp"
+
+// libs
+// tinyobj is only kept around as the baseline to compare our own parser against
+#define TINYOBJLOADER_IMPLEMENTATION
+#include <tiny_obj_loader.h>
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace lve {
+
+	// runs the function a few times and keeps the fastest run, the slower ones are mostly noise from the OS
+	static double bestOfMilliseconds(int iterations, const std::function<void()>& function) {
+		double best = std::numeric_limits<double>::max();
+		for (int i = 0; i < iterations; i++) {
+			auto start = std::chrono::high_resolution_clock::now();
+			function();
+			auto end = std::chrono::high_resolution_clock::now();
+			best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+
+		} // for
+
+		return best;
+
+	} // bestOfMilliseconds
+
+	static std::vector<std::string> findModels(const std::string& modelDirectory) {
+		std::vector<std::string> models{};
+		for (const auto& entry : std::filesystem::directory_iterator(modelDirectory)) {
+			if (entry.is_regular_file() && entry.path().extension() == ".obj")
+				models.push_back(entry.path().string());
+
+		} // for
+
+		std::sort(models.begin(), models.end());
+		return models;
+
+	} // findModels
+
+	void LveBenchmark::modelLoading(const std::string& modelDirectory, int iterations) {
+		std::cout << "model loading, best of " << iterations << " runs\n";
+		std::cout << std::left << std::setw(28) << "model" << std::right
+			<< std::setw(12) << "vertices" << std::setw(12) << "indices"
+			<< std::setw(14) << "cold (ms)" << std::setw(14) << "cached (ms)" << std::setw(10) << "speedup" << "\n";
+
+		for (const auto& path : findModels(modelDirectory)) {
+			LveModel::Builder builder{};
+
+			// cold: what every launch used to pay, text parsing, vertex dedup and the default optimization passes
+			const LveModel::ImportOptions options{};
+			double coldMs = bestOfMilliseconds(iterations, [&]() {
+				builder.loadModel(path, options.weldMethod);
+				if (options.maxLodCount > 1)
+					builder.generateLods(options.maxLodCount);
+
+				if (options.optimizeVertexCache)
+					builder.optimizeVertexCache();
+
+				if (options.vertexFormat == LveModel::VertexFormat::Packed)
+					builder.packVertices();
+
+			}); // bestOfMilliseconds
+
+			const std::string cachePath = LveMeshCache::cachePathFor(path);
+			const uint32_t importFlags = LveMeshCache::importFlagsFor(options);
+			LveMeshCache::write(cachePath, LveMeshCache::stampFile(path), LveMeshCache::hashFile(path), importFlags, builder);
+
+			// cached: stat the source, map the cache and copy it out like the staging upload would
+			std::vector<std::byte> staging(builder.vertices.size() * sizeof(LveModel::Vertex) + builder.indices.size() * sizeof(uint32_t)); // big enough for either layout
+			double cachedMs = bestOfMilliseconds(iterations, [&]() {
+				auto cache = LveMeshCache::open(cachePath, path, LveMeshCache::stampFile(path), importFlags);
+				if (cache == nullptr)
+					return;
+
+				std::memcpy(staging.data(), cache->vertexData().data(), cache->vertexData().size_bytes());
+				std::memcpy(staging.data() + cache->vertexData().size_bytes(), cache->indices().data(), cache->indices().size_bytes());
+
+			}); // bestOfMilliseconds
+
+			std::cout << std::left << std::setw(28) << std::filesystem::path(path).filename().string() << std::right
+				<< std::setw(12) << builder.vertices.size() << std::setw(12) << builder.indices.size()
+				<< std::fixed << std::setprecision(3)
+				<< std::setw(14) << coldMs << std::setw(14) << cachedMs
+				<< std::setprecision(1) << std::setw(9) << coldMs / std::max(cachedMs, 1e-6) << "x\n";
+
+		} // for
+
+	} // modelLoading
+
+	void LveBenchmark::objParsing(const std::string& modelDirectory, int iterations) {
+		// 1, 2, 4, ... up to every hardware thread, always ending on the full count
+		std::vector<unsigned int> threadCounts{};
+		const unsigned int hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+		for (unsigned int threads = 1; threads < hardwareThreads; threads *= 2)
+			threadCounts.push_back(threads);
+
+		threadCounts.push_back(hardwareThreads);
+
+		std::cout << "obj parsing, best of " << iterations << " runs (parse + triangulate only, no dedup)\n";
+		std::cout << std::left << std::setw(28) << "model" << std::right << std::setw(12) << "corners" << std::setw(14) << "tinyobj (ms)";
+		for (unsigned int threads : threadCounts)
+			std::cout << std::setw(12) << (std::to_string(threads) + "t (ms)");
+
+		std::cout << std::setw(10) << "speedup" << "\n";
+
+		for (const auto& path : findModels(modelDirectory)) {
+			size_t tinyobjCorners = 0;
+			double tinyobjMs = bestOfMilliseconds(iterations, [&]() {
+				tinyobj::attrib_t attrib;
+				std::vector<tinyobj::shape_t> shapes;
+				std::vector<tinyobj::material_t> materials;
+				std::string warn, err;
+
+				if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path.c_str()))
+					throw std::runtime_error(warn + err);
+
+				tinyobjCorners = 0;
+				for (const auto& shape : shapes)
+					tinyobjCorners += shape.mesh.indices.size();
+
+			}); // bestOfMilliseconds
+
+			std::cout << std::left << std::setw(28) << std::filesystem::path(path).filename().string() << std::right
+				<< std::setw(12) << tinyobjCorners << std::fixed << std::setprecision(3) << std::setw(14) << tinyobjMs;
+
+			double bestMs = std::numeric_limits<double>::max();
+			for (unsigned int threads : threadCounts) {
+				size_t corners = 0;
+				double ms = bestOfMilliseconds(iterations, [&]() { corners = LveObjParser::parseTriangleCorners(path, threads).size(); });
+				if (corners != tinyobjCorners)
+					std::cout << " (corner mismatch: " << corners << ")";
+
+				bestMs = std::min(bestMs, ms);
+				std::cout << std::setw(12) << ms;
+
+			} // for
+
+			std::cout << std::setprecision(1) << std::setw(9) << tinyobjMs / std::max(bestMs, 1e-6) << "x\n";
+
+		} // for
+
+	} // objParsing
+
+	void LveBenchmark::vertexWelding(const std::string& modelDirectory, int iterations) {
+		struct Method {
+			const char* name;
+			LveModel::WeldMethod method;
+
+		}; // Method
+
+		const Method methods[] = {
+			{ "unordered_map", LveModel::WeldMethod::UnorderedMap },
+			{ "flat hash", LveModel::WeldMethod::FlatHash },
+			{ "radix sort", LveModel::WeldMethod::RadixSort }
+
+		}; // methods
+
+		std::cout << "vertex welding, best of " << iterations << " runs (ms)\n";
+		std::cout << std::left << std::setw(28) << "model" << std::right << std::setw(12) << "corners" << std::setw(12) << "vertices";
+		for (const auto& method : methods)
+			std::cout << std::setw(16) << method.name;
+
+		std::cout << "\n";
+
+		for (const auto& path : findModels(modelDirectory)) {
+			const std::vector<LveModel::Vertex> corners = LveObjParser::parseTriangleCorners(path);
+
+			// the old map is the reference, every other method has to match it exactly
+			std::vector<LveModel::Vertex> expectedVertices{};
+			std::vector<uint32_t> expectedIndices{};
+			LveVertexWeld::weldUnorderedMap(corners, expectedVertices, expectedIndices);
+
+			std::cout << std::left << std::setw(28) << std::filesystem::path(path).filename().string() << std::right
+				<< std::setw(12) << corners.size() << std::setw(12) << expectedVertices.size() << std::fixed << std::setprecision(3);
+
+			for (const auto& method : methods) {
+				std::vector<LveModel::Vertex> vertices{};
+				std::vector<uint32_t> indices{};
+				double ms = bestOfMilliseconds(iterations, [&]() { LveVertexWeld::weld(corners, method.method, vertices, indices); });
+
+				if (vertices != expectedVertices || indices != expectedIndices)
+					std::cout << std::setw(16) << "MISMATCH";
+				else
+					std::cout << std::setw(16) << ms;
+
+			} // for
+
+			std::cout << "\n";
+
+		} // for
+
+	} // vertexWelding
+
+	void LveBenchmark::vertexCacheOptimization(const std::string& modelDirectory, int iterations) {
+		std::cout << "vertex cache optimization, FIFO of " << LveMeshOptimizer::DEFAULT_CACHE_SIZE << ", best of " << iterations << " runs\n";
+		std::cout << std::left << std::setw(28) << "model" << std::right << std::setw(12) << "triangles"
+			<< std::setw(14) << "ACMR before" << std::setw(14) << "ACMR after"
+			<< std::setw(14) << "ATVR before" << std::setw(14) << "ATVR after" << std::setw(12) << "time (ms)" << "\n";
+
+		for (const auto& path : findModels(modelDirectory)) {
+			LveModel::Builder loaded{};
+			loaded.loadModel(path);
+
+			LveModel::Builder builder{};
+			LveModel::VertexCacheReport report{};
+			double ms = bestOfMilliseconds(iterations, [&]() {
+				builder = loaded;
+				report = builder.optimizeVertexCache();
+
+			}); // bestOfMilliseconds
+
+			std::cout << std::left << std::setw(28) << std::filesystem::path(path).filename().string() << std::right
+				<< std::setw(12) << loaded.indices.size() / 3 << std::fixed << std::setprecision(3)
+				<< std::setw(14) << report.before.acmr << std::setw(14) << report.after.acmr
+				<< std::setw(14) << report.before.atvr << std::setw(14) << report.after.atvr << std::setw(12) << ms << "\n";
+
+		} // for
+
+	} // vertexCacheOptimization
+
+	void LveBenchmark::vertexPacking(const std::string& modelDirectory, int iterations) {
+		std::cout << "vertex packing, " << sizeof(LveModel::Vertex) << " -> " << sizeof(LveModel::PackedVertex) << " bytes per vertex, best of " << iterations << " runs\n";
+		std::cout << std::left << std::setw(28) << "model" << std::right << std::setw(12) << "vertices"
+			<< std::setw(12) << "full (KB)" << std::setw(14) << "packed (KB)" << std::setw(10) << "ratio"
+			<< std::setw(18) << "max pos error" << std::setw(18) << "max normal (deg)" << std::setw(12) << "time (ms)" << "\n";
+
+		for (const auto& path : findModels(modelDirectory)) {
+			LveModel::Builder builder{};
+			builder.loadModel(path);
+			double ms = bestOfMilliseconds(iterations, [&]() { builder.packVertices(); });
+
+			// decode on the CPU exactly like the vertex fetch + shader would and measure the worst case
+			float maxPositionError = 0.f;
+			float maxNormalDegrees = 0.f;
+			for (size_t i = 0; i < builder.vertices.size(); i++) {
+				const auto& vertex = builder.vertices[i];
+				const auto& packed = builder.packedVertices[i];
+
+				const glm::vec3 unorm{ packed.position[0] / 65535.f, packed.position[1] / 65535.f, packed.position[2] / 65535.f };
+				const glm::vec3 position = builder.quantization.offset + builder.quantization.scale * unorm;
+				maxPositionError = std::max(maxPositionError, glm::length(position - vertex.position));
+
+				if (glm::length(vertex.normal) > 0.f) {
+					glm::vec3 normal{ std::max(packed.normal[0] / 127.f, -1.f), std::max(packed.normal[1] / 127.f, -1.f), 0.f };
+					normal.z = 1.f - std::abs(normal.x) - std::abs(normal.y);
+					const float t = std::max(-normal.z, 0.f);
+					normal.x += normal.x >= 0.f ? -t : t;
+					normal.y += normal.y >= 0.f ? -t : t;
+
+					const float cosine = glm::dot(glm::normalize(normal), glm::normalize(vertex.normal));
+					maxNormalDegrees = std::max(maxNormalDegrees, glm::degrees(std::acos(std::clamp(cosine, -1.f, 1.f))));
+
+				} // if
+
+			} // for
+
+			const size_t fullBytes = builder.vertices.size() * sizeof(LveModel::Vertex);
+			const size_t packedBytes = builder.packedVertices.size() * sizeof(LveModel::PackedVertex);
+			std::cout << std::left << std::setw(28) << std::filesystem::path(path).filename().string() << std::right
+				<< std::setw(12) << builder.vertices.size() << std::fixed << std::setprecision(1)
+				<< std::setw(12) << fullBytes / 1024.0 << std::setw(14) << packedBytes / 1024.0
+				<< std::setw(9) << static_cast<double>(fullBytes) / std::max<size_t>(packedBytes, 1) << "x"
+				<< std::setprecision(6) << std::setw(18) << maxPositionError
+				<< std::setprecision(3) << std::setw(18) << maxNormalDegrees << std::setw(12) << ms << "\n";
+
+		} // for
+
+	} // vertexPacking
+
+	void LveBenchmark::lodGeneration(const std::string& modelDirectory, int iterations) {
+		const LveModel::ImportOptions options{};
+		std::cout << "LOD generation, up to " << options.maxLodCount << " LODs, best of " << iterations << " runs\n";
+		std::cout << std::left << std::setw(28) << "model" << std::right << std::setw(32) << "triangles per LOD"
+			<< std::setw(40) << "error per LOD (% of radius)" << std::setw(12) << "time (ms)" << "\n";
+
+		for (const auto& path : findModels(modelDirectory)) {
+			LveModel::Builder source{};
+			source.loadModel(path);
+
+			LveModel::Builder builder{};
+			double ms = bestOfMilliseconds(iterations, [&]() {
+				builder.vertices = source.vertices;
+				builder.indices = source.indices;
+				builder.generateLods(options.maxLodCount);
+
+			}); // bestOfMilliseconds
+
+			// errors relative to the bounding sphere say more than model units, which differ from file to file
+			glm::vec3 boundsMin = source.vertices[0].position;
+			glm::vec3 boundsMax = source.vertices[0].position;
+			for (const auto& vertex : source.vertices) {
+				boundsMin = glm::min(boundsMin, vertex.position);
+				boundsMax = glm::max(boundsMax, vertex.position);
+
+			} // for
+
+			const float radius = std::max(glm::length(boundsMax - boundsMin) * 0.5f, 1e-12f);
+
+			std::string triangles{};
+			std::ostringstream errors{};
+			errors << std::fixed << std::setprecision(2);
+			for (size_t i = 0; i < builder.lods.size(); i++) {
+				triangles += (i > 0 ? " / " : "") + std::to_string(builder.lods[i].indexCount / 3);
+				errors << (i > 0 ? " / " : "") << builder.lods[i].error / radius * 100.f;
+
+			} // for
+
+			std::cout << std::left << std::setw(28) << std::filesystem::path(path).filename().string() << std::right
+				<< std::setw(32) << triangles << std::setw(40) << errors.str()
+				<< std::fixed << std::setprecision(3) << std::setw(12) << ms << "\n";
+
+		} // for
+
+	} // lodGeneration
+
+	void LveBenchmark::headlessRendering(const std::string& modelPath, int frames, int objectCount) {
+		LveDevice device{};
+		LveRenderer renderer{ device, VkExtent2D{ 1280, 720 } };
+		LveModelLoader loader{ device };
+		LveThreadPool recordWorkers{};
+		SimpleRenderSystem renderSystem{ device, renderer.getSwapChainRenderPass() };
+
+		// a square grid of copies in front of the camera, they all share the one model
+		std::shared_ptr<LveModel> model = loader.loadModel(modelPath);
+		std::vector<LveGameObject> gameObjects{};
+		const int columns = std::max(1, static_cast<int>(std::ceil(std::sqrt(static_cast<float>(objectCount)))));
+		const float spacing = 3.f / columns;
+		for (int i = 0; i < objectCount; i++) {
+			auto gameObject = LveGameObject::createGameObject();
+			gameObject.model = model;
+			gameObject.transform.translation = { (i % columns - (columns - 1) * 0.5f) * spacing, (i / columns - (columns - 1) * 0.5f) * spacing, 4.f };
+			gameObject.transform.scale = glm::vec3{ 3.f, 1.5f, 3.f } / static_cast<float>(columns);
+			gameObjects.push_back(std::move(gameObject));
+
+		} // for
+
+		loader.waitIdle();
+
+		LveCamera camera{};
+		camera.setViewTarget(glm::vec3(-1.f, -2.f, 2.f), glm::vec3(0.f, 0.f, 2.5f));
+		camera.setPerspectiveProjection(glm::radians(50.f), renderer.getAspectRatio(), 0.1f, 10.f);
+
+		const VkExtent2D extent = renderer.getExtent();
+		std::cout << "headless rendering, " << frames << " frames of " << objectCount << " objects at " << extent.width << "x" << extent.height
+			<< " on " << device.properties.deviceName << "\n";
+		std::cout << std::left << std::setw(28) << "recording" << std::right << std::setw(12) << "fps" << std::setw(14) << "record (ms)" << std::setw(10) << "visible" << std::setw(10) << "culled" << "\n";
+
+		// the scene never moves, so the GPU culling snapshot is taken once up front and costs nothing per frame
+		std::unique_ptr<LveGpuCulling> gpuCulling = LveGpuCulling::create(device);
+		if (gpuCulling)
+			gpuCulling->setScene(gameObjects);
+
+		enum class Recording { Direct, Indirect, Parallel, GpuCulled };
+		auto run = [&](const char* label, Recording recording) {
+			double recordMs = 0.0;
+			auto renderFrame = [&]() {
+				VkCommandBuffer commandBuffer = renderer.beginFrame();
+				auto recordStart = std::chrono::high_resolution_clock::now();
+				if (recording == Recording::GpuCulled) {
+					const uint32_t frameIndex = static_cast<uint32_t>(renderer.getFrameIndex());
+					{
+						LveGpuProfiler::Scope gpuScope{ renderer.getGpuProfiler(), commandBuffer, "gpu culling" };
+						gpuCulling->cull(commandBuffer, frameIndex, camera);
+
+					}
+
+					renderer.beginSwapChainRenderPass(commandBuffer);
+					{
+						LveGpuProfiler::Scope gpuScope{ renderer.getGpuProfiler(), commandBuffer, "simple render system gpu culled" };
+						renderSystem.renderGameObjectsGpuCulled(commandBuffer, frameIndex, *gpuCulling);
+
+					}
+
+					renderer.endSwapChainRenderPass(commandBuffer);
+					gpuCulling->buildDepthPyramid(commandBuffer, frameIndex, renderer.getDepthImageView(), extent);
+
+				} else if (recording == Recording::Parallel) {
+					renderer.beginSwapChainRenderPass(commandBuffer, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+					renderSystem.renderGameObjectsParallel(renderer, commandBuffer, gameObjects, camera, recordWorkers);
+
+				} else {
+
+					renderer.beginSwapChainRenderPass(commandBuffer);
+					const uint32_t frameIndex = static_cast<uint32_t>(renderer.getFrameIndex());
+					if (recording == Recording::Indirect) {
+						LveGpuProfiler::Scope gpuScope{ renderer.getGpuProfiler(), commandBuffer, "simple render system indirect" };
+						renderSystem.renderGameObjectsIndirect(commandBuffer, frameIndex, gameObjects, camera);
+
+					} else {
+
+						LveGpuProfiler::Scope gpuScope{ renderer.getGpuProfiler(), commandBuffer, "simple render system" };
+						renderSystem.renderGameObjects(commandBuffer, frameIndex, gameObjects, camera);
+
+					} // else
+
+				} // else
+
+				if (recording != Recording::GpuCulled)
+					renderer.endSwapChainRenderPass(commandBuffer);
+
+				recordMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - recordStart).count();
+				renderer.endFrame();
+
+			}; // renderFrame
+
+			// pipelines, pools and query pools are all created on the first frames, they are not part of the measurement
+			for (uint32_t i = 0; i < renderer.getFramesInFlight() * 2; i++)
+				renderFrame();
+
+			recordMs = 0.0;
+			auto start = std::chrono::high_resolution_clock::now();
+			for (int i = 0; i < frames; i++)
+				renderFrame();
+
+			device.waitIdle();
+			const double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+			std::cout << std::left << std::setw(28) << label << std::right << std::fixed
+				<< std::setprecision(1) << std::setw(12) << frames / std::max(seconds, 1e-9)
+				<< std::setprecision(3) << std::setw(14) << recordMs / std::max(frames, 1);
+
+			// what the GPU culled never comes back to the CPU
+			if (recording == Recording::GpuCulled) {
+				std::cout << std::setw(10) << "-" << std::setw(10) << "-" << "\n";
+
+			} else {
+
+				const SimpleRenderSystem::CullStats cullStats = renderSystem.getCullStats();
+				std::cout << std::setw(10) << cullStats.visible << std::setw(10) << cullStats.culled << "\n";
+
+			} // else
+
+		}; // run
+
+		run("1 thread", Recording::Direct);
+		run("1 thread, indirect", Recording::Indirect);
+		run((std::to_string(recordWorkers.getThreadCount() + 1) + " threads").c_str(), Recording::Parallel);
+		if (gpuCulling)
+			run("gpu culled", Recording::GpuCulled);
+
+		std::cout << std::left << std::setw(28) << "gpu scope" << std::right
+			<< std::setw(12) << "min (ms)" << std::setw(12) << "avg (ms)" << std::setw(12) << "p99 (ms)" << "\n";
+
+		for (const auto& [name, stats] : renderer.getGpuProfiler().getAllStats()) {
+			std::cout << std::left << std::setw(28) << name << std::right << std::setprecision(3)
+				<< std::setw(12) << stats.minMs << std::setw(12) << stats.avgMs << std::setw(12) << stats.p99Ms << "\n";
+
+		} // for
+
+	} // headlessRendering
+
+} // lve
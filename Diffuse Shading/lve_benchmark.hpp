@@ -0,0 +1,38 @@
+#pragma once
+
+// std
+#include <string>
+
+namespace lve {
+
+	// CPU side benchmarks that do not need a window or a GPU
+	// run with: OpeningAWindow.exe --benchmark-models [directory]
+	// headlessRendering is the exception, it needs a GPU but no display, a software driver like lavapipe will do
+	// run with: OpeningAWindow.exe --benchmark-headless [model] [frames] [objects]
+	class LveBenchmark {
+	public:
+		// times every .obj in the directory: cold load (parse + dedup + LODs + default optimizations) against the memory mapped mesh cache
+		static void modelLoading(const std::string& modelDirectory, int iterations = 5);
+
+		// times tinyobj against LveObjParser at 1, 2, 4, ... threads on every .obj in the directory
+		static void objParsing(const std::string& modelDirectory, int iterations = 5);
+
+		// times every LveModel::WeldMethod on the parsed corners of every .obj in the directory and checks they agree
+		static void vertexWelding(const std::string& modelDirectory, int iterations = 5);
+
+		// ACMR / ATVR of every .obj in the directory before and after LveModel::Builder::optimizeVertexCache
+		static void vertexCacheOptimization(const std::string& modelDirectory, int iterations = 5);
+
+		// memory saved by LveModel::PackedVertex and the worst position / normal error it introduces
+		static void vertexPacking(const std::string& modelDirectory, int iterations = 5);
+
+		// triangle counts and errors of the LOD chain LveModel::Builder::generateLods builds for every .obj in the directory
+		static void lodGeneration(const std::string& modelDirectory, int iterations = 5);
+
+		// renders a grid of objectCount copies of the model with SimpleRenderSystem into an offscreen target as fast as the GPU goes,
+		// recorded on one thread directly, with indirect draws and then on every core, prints frames per second, CPU recording time and the GPU profiler scopes
+		static void headlessRendering(const std::string& modelPath, int frames = 1000, int objectCount = 1);
+
+	}; // LveBenchmark
+
+} // lve
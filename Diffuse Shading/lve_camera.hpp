@@ -1,5 +1,7 @@
 #pragma once
 
+#include "lve_frustum.hpp"
+
 // libs
 #define GLM_FORCE_RADIANS // forces in radians and not degrees
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE // Vulkan uses 0 to 1, openGL uses 1 to 1
@@ -23,6 +25,9 @@ namespace lve {
 		const glm::mat4& getProjection() const { return projectionMatrix; } // getProjection
 		const glm::mat4& getView() const { return viewMatrix; } // getView
 
+		// world space planes of what the camera sees, from projection * view
+		LveFrustum getFrustum() const { return LveFrustum::fromMatrix(projectionMatrix * viewMatrix); } // getFrustum
+
 
 	}; // lveCamera
 
@@ -0,0 +1,161 @@
+#include "lve_command_pools.hpp"
+
+// std
+#include <stdexcept>
+
+namespace lve {
+
+	LveCommandPools::LveCommandPools(VkDevice device, uint32_t queueFamily) : device{ device }, queueFamily{ queueFamily } {
+
+	} // LveCommandPools
+
+	LveCommandPools::~LveCommandPools() {
+		// destroying a pool frees every command buffer that came from it
+		for (auto& [thread, pools] : threads) {
+			if (pools->oneShotPool != VK_NULL_HANDLE)
+				vkDestroyCommandPool(device, pools->oneShotPool, nullptr);
+
+			for (auto& framePool : pools->framePools) {
+				if (framePool.pool != VK_NULL_HANDLE)
+					vkDestroyCommandPool(device, framePool.pool, nullptr);
+
+			} // for
+
+		} // for
+
+	} // ~LveCommandPools
+
+	VkCommandPool LveCommandPools::createPool(VkCommandPoolCreateFlags flags) {
+		VkCommandPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.queueFamilyIndex = queueFamily;
+		poolInfo.flags = flags;
+
+		VkCommandPool pool;
+		if (vkCreateCommandPool(device, &poolInfo, nullptr, &pool) != VK_SUCCESS)
+			throw std::runtime_error("failed to create command pool!");
+
+		return pool;
+
+	} // createPool
+
+	LveCommandPools::ThreadPools& LveCommandPools::threadPools() {
+		std::lock_guard<std::mutex> lock{ mutex };
+
+		auto& pools = threads[std::this_thread::get_id()];
+		if (pools == nullptr)
+			pools = std::make_unique<ThreadPools>();
+
+		// the map may rehash, but the ThreadPools itself never moves
+		return *pools;
+
+	} // threadPools
+
+	VkCommandBuffer LveCommandPools::allocateFrameCommandBuffer(uint32_t frameIndex, VkCommandBufferLevel level) {
+		ThreadPools& pools = threadPools();
+
+		// resetFrame walks every thread's frame pools, so they only change shape under the lock
+		FramePool* framePool;
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			if (pools.framePools.size() <= frameIndex)
+				pools.framePools.resize(frameIndex + 1);
+
+			framePool = &pools.framePools[frameIndex];
+
+			// no RESET_COMMAND_BUFFER flag, the buffers are only ever reset together with the pool
+			if (framePool->pool == VK_NULL_HANDLE)
+				framePool->pool = createPool(VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+
+		} // lock
+
+		const int kind = level == VK_COMMAND_BUFFER_LEVEL_PRIMARY ? 0 : 1;
+		auto& commandBuffers = framePool->commandBuffers[kind];
+		uint32_t& used = framePool->used[kind];
+
+		if (used == commandBuffers.size()) {
+			VkCommandBufferAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.level = level;
+			allocInfo.commandPool = framePool->pool;
+			allocInfo.commandBufferCount = 1;
+
+			VkCommandBuffer commandBuffer;
+			if (vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer) != VK_SUCCESS)
+				throw std::runtime_error("failed to allocate frame command buffer!");
+
+			commandBuffers.push_back(commandBuffer);
+
+		} // if
+
+		return commandBuffers[used++];
+
+	} // allocateFrameCommandBuffer
+
+	void LveCommandPools::resetFrame(uint32_t frameIndex) {
+		std::lock_guard<std::mutex> lock{ mutex };
+
+		for (auto& [thread, pools] : threads) {
+			if (pools->framePools.size() <= frameIndex || pools->framePools[frameIndex].pool == VK_NULL_HANDLE)
+				continue;
+
+			FramePool& framePool = pools->framePools[frameIndex];
+			vkResetCommandPool(device, framePool.pool, 0);
+			framePool.used[0] = 0;
+			framePool.used[1] = 0;
+
+		} // for
+
+	} // resetFrame
+
+	VkCommandBuffer LveCommandPools::allocateOneShot() {
+		ThreadPools& pools = threadPools();
+
+		if (pools.freeOneShots.empty()) {
+			std::lock_guard<std::mutex> lock{ mutex };
+			pools.freeOneShots.swap(pools.returnedOneShots);
+
+		} // if
+
+		if (!pools.freeOneShots.empty()) {
+			// the RESET_COMMAND_BUFFER flag lets vkBeginCommandBuffer reset it for us
+			VkCommandBuffer commandBuffer = pools.freeOneShots.back();
+			pools.freeOneShots.pop_back();
+			return commandBuffer;
+
+		} // if
+
+		if (pools.oneShotPool == VK_NULL_HANDLE) {
+			VkCommandPool pool = createPool(VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
+			std::lock_guard<std::mutex> lock{ mutex };
+			pools.oneShotPool = pool;
+
+		} // if
+
+		VkCommandBufferAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandPool = pools.oneShotPool;
+		allocInfo.commandBufferCount = 1;
+
+		VkCommandBuffer commandBuffer;
+		if (vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer) != VK_SUCCESS)
+			throw std::runtime_error("failed to allocate one shot command buffer!");
+
+		return commandBuffer;
+
+	} // allocateOneShot
+
+	void LveCommandPools::freeOneShot(VkCommandBuffer commandBuffer) {
+		threadPools().freeOneShots.push_back(commandBuffer);
+
+	} // freeOneShot
+
+	void LveCommandPools::freeOneShot(VkCommandBuffer commandBuffer, std::thread::id owner) {
+		// the owner may be recording into its pool right now, so the buffer only goes back on its list, the pool is not touched
+		std::lock_guard<std::mutex> lock{ mutex };
+		threads.at(owner)->returnedOneShots.push_back(commandBuffer);
+
+	} // freeOneShot
+
+} // lve
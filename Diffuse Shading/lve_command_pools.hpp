@@ -0,0 +1,69 @@
+#pragma once
+
+// libs
+#include <vulkan/vulkan.h>
+
+// std
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace lve {
+
+	// command pools are not thread safe and a command buffer belongs to the pool it came from,
+	// so every thread that records gets pools of its own
+	// frame pools: one per thread and frame in flight, everything in them is thrown away at once with vkResetCommandPool
+	// when that frame comes around again, and the command buffers are kept to be handed out again instead of being freed
+	// one shot pools: TRANSIENT, for short lived work like LveDevice::beginSingleTimeCommands, freed buffers are kept for reuse
+	class LveCommandPools {
+	public:
+		LveCommandPools(VkDevice device, uint32_t queueFamily);
+		~LveCommandPools();
+
+		LveCommandPools(const LveCommandPools&) = delete;
+		LveCommandPools& operator=(const LveCommandPools&) = delete;
+
+		// a command buffer from the calling thread's pool for frameIndex, valid until resetFrame(frameIndex)
+		VkCommandBuffer allocateFrameCommandBuffer(uint32_t frameIndex, VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+
+		// resets every thread's pool for frameIndex, call it once the fence of the last submission using them has signalled
+		// and while no thread is recording into them
+		void resetFrame(uint32_t frameIndex);
+
+		// from the calling thread's TRANSIENT pool, hand it back with freeOneShot on the same thread once the GPU is done with it
+		VkCommandBuffer allocateOneShot();
+		void freeOneShot(VkCommandBuffer commandBuffer);
+		// from any thread, e.g. an upload retired by whoever checked on it, owner gets it back in its next allocateOneShot
+		void freeOneShot(VkCommandBuffer commandBuffer, std::thread::id owner);
+
+	private:
+		struct FramePool {
+			VkCommandPool pool = VK_NULL_HANDLE;
+			std::vector<VkCommandBuffer> commandBuffers[2]{}; // primary and secondary, every one handed out since the last reset is in use
+			uint32_t used[2]{};
+
+		}; // FramePool
+
+		struct ThreadPools {
+			VkCommandPool oneShotPool = VK_NULL_HANDLE;
+			std::vector<VkCommandBuffer> freeOneShots{};
+			std::vector<VkCommandBuffer> returnedOneShots{}; // freed on other threads, guarded by mutex
+			std::vector<FramePool> framePools{}; // by frame index, grown on demand
+
+		}; // ThreadPools
+
+		ThreadPools& threadPools();
+		VkCommandPool createPool(VkCommandPoolCreateFlags flags);
+
+		VkDevice device;
+		uint32_t queueFamily;
+
+		std::mutex mutex; // only guards the map, what is in it belongs to its thread (apart from resetFrame and returnedOneShots)
+		std::unordered_map<std::thread::id, std::unique_ptr<ThreadPools>> threads{};
+
+	}; // LveCommandPools
+
+} // lve
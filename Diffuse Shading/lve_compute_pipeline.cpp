@@ -0,0 +1,57 @@
+#include "lve_compute_pipeline.hpp"
+#include "lve_pipline.hpp"
+
+// std
+#include <cassert>
+#include <stdexcept>
+
+namespace lve {
+
+	LveComputePipeline::LveComputePipeline(
+		LveDevice& device,
+		const std::string& compFilePath,
+		VkPipelineLayout pipelineLayout,
+		const VkSpecializationInfo* specializationInfo) : lveDevice{ device } {
+		assert(pipelineLayout != VK_NULL_HANDLE && "Cannot create compute pipeline:: no pipeline layout provided");
+
+		auto compCode = LvePipeline::readFile(compFilePath);
+
+		VkShaderModuleCreateInfo moduleInfo{};
+		moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+		moduleInfo.codeSize = compCode.size();
+		moduleInfo.pCode = reinterpret_cast<const uint32_t*>(compCode.data());
+
+		VkShaderModule compShaderModule;
+		if (vkCreateShaderModule(lveDevice.device(), &moduleInfo, nullptr, &compShaderModule) != VK_SUCCESS)
+			throw std::runtime_error("failed to create shader module");
+
+		VkComputePipelineCreateInfo pipelineInfo{};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		pipelineInfo.stage.module = compShaderModule;
+		pipelineInfo.stage.pName = "main";
+		pipelineInfo.stage.pSpecializationInfo = specializationInfo;
+		pipelineInfo.layout = pipelineLayout;
+
+		const VkResult result = vkCreateComputePipelines(lveDevice.device(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &computePipeline);
+
+		// the pipeline keeps what it needs, unlike LvePipeline there is nothing to hold on to
+		vkDestroyShaderModule(lveDevice.device(), compShaderModule, nullptr);
+
+		if (result != VK_SUCCESS)
+			throw std::runtime_error("failed to create compute pipeline");
+
+	} // LveComputePipeline
+
+	LveComputePipeline::~LveComputePipeline() {
+		vkDestroyPipeline(lveDevice.device(), computePipeline, nullptr);
+
+	} // ~LveComputePipeline
+
+	void LveComputePipeline::bind(VkCommandBuffer commandBuffer) {
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipeline);
+
+	} // bind
+
+} // lve
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "lve_device.hpp"
+
+// std
+#include <string>
+
+namespace lve {
+
+	// the compute counterpart to LvePipeline, one shader and whatever layout the caller made for its descriptor sets
+	class LveComputePipeline {
+	public:
+		// specializationInfo sets the shader's constant_id values, so one shader can become several pipelines
+		LveComputePipeline(
+			LveDevice& device,
+			const std::string& compFilePath,
+			VkPipelineLayout pipelineLayout,
+			const VkSpecializationInfo* specializationInfo = nullptr);
+		~LveComputePipeline();
+
+		LveComputePipeline(const LveComputePipeline&) = delete;
+		LveComputePipeline& operator=(const LveComputePipeline&) = delete;
+
+		void bind(VkCommandBuffer commandBuffer);
+
+	private:
+		LveDevice& lveDevice;
+		VkPipeline computePipeline = VK_NULL_HANDLE;
+
+	}; // LveComputePipeline
+
+} // lve
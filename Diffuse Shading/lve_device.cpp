@@ -1,8 +1,10 @@
 #include "lve_device.hpp"
 
 // std headers
+#include <algorithm>
 #include <cstring>
 #include <iostream>
+#include <iterator>
 #include <set>
 #include <unordered_set>
 
@@ -50,18 +52,49 @@ namespace lve {
     } // DestroyDebugUtilsMessengerEXT
 
     // class member functions
-    LveDevice::LveDevice(LveWindow& window) : window{ window } {
+    LveDevice::LveDevice(LveWindow& window) : window{ &window } {
+        init();
+
+    } // LveDevice
+
+    LveDevice::LveDevice() {
+        deviceExtensions.clear();
+        init();
+
+    } // LveDevice
+
+    void LveDevice::init() {
         createInstance();
         setupDebugMessenger(); // Vulkan has very little error checking, we need to make our own
         createSurface(); 
         pickPhysicalDevice(); // physical device is the GPU in the system
         createLogicalDevice(); 
+        createMemoryAllocator(); // every buffer and image gets its memory from here
         createCommandPool();
+        createGeometryArena(); // the shared vertex and index buffers, nothing is allocated until the first model
+        createStagingRing(); // every upload is written through this
 
-    } // LveDevice 
+    } // init
 
     LveDevice::~LveDevice() {
+        // uploads nobody waited for are still allowed to be running, their command buffers go with the pools
+        waitIdle();
+        for (auto& deferred : deferredReleases)
+            deferred.release();
+
+        deferredReleases.clear();
+        for (const auto& transfer : transfers)
+            vkDestroyFence(device_, transfer.fence, nullptr);
+
+        for (const auto& acquire : acquires)
+            vkDestroyFence(device_, acquire.fence, nullptr);
+
+        commandPools_.reset();
+        transferPools_.reset();
         vkDestroyCommandPool(device_, commandPool, nullptr);
+        stagingRing_.reset();
+        arena.reset();
+        allocator.reset();
         vkDestroyDevice(device_, nullptr);
 
         if (enableValidationLayers) {
@@ -69,7 +102,9 @@ namespace lve {
 
         } // if
 
-        vkDestroySurfaceKHR(instance, surface_, nullptr);
+        if (surface_ != VK_NULL_HANDLE)
+            vkDestroySurfaceKHR(instance, surface_, nullptr);
+
         vkDestroyInstance(instance, nullptr);
 
     } // ~LveDevice
@@ -148,7 +183,7 @@ namespace lve {
         QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
 
         std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-        std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily, indices.presentFamily };
+        std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily, indices.presentFamily, indices.transferFamily };
 
         float queuePriority = 1.0f;
         for (uint32_t queueFamily : uniqueQueueFamilies) {
@@ -160,8 +195,21 @@ namespace lve {
             queueCreateInfos.push_back(queueCreateInfo);
         }
 
+        VkPhysicalDeviceFeatures supportedFeatures;
+        vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+
         VkPhysicalDeviceFeatures deviceFeatures = {};
         deviceFeatures.samplerAnisotropy = VK_TRUE;
+        // for the indirect draw path, several draws per vkCmdDrawIndexedIndirect and per draw instance offsets,
+        // it falls back to plain draws without them
+        deviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+        deviceFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+
+        // the instance is Vulkan 1.0, so the draw count in a buffer comes from the extension rather than 1.2 core
+        std::vector<const char*> enabledExtensions = deviceExtensions;
+        const bool drawIndirectCount = isDeviceExtensionSupported(physicalDevice, VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+        if (drawIndirectCount)
+            enabledExtensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
 
         VkDeviceCreateInfo createInfo = {};
         createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -170,8 +218,8 @@ namespace lve {
         createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
         createInfo.pEnabledFeatures = &deviceFeatures;
-        createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-        createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+        createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+        createInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
         // might not really be necessary anymore because device specific validation layers
         // have been deprecated
@@ -189,8 +237,34 @@ namespace lve {
 
         vkGetDeviceQueue(device_, indices.graphicsFamily, 0, &graphicsQueue_);
         vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
+        vkGetDeviceQueue(device_, indices.transferFamily, 0, &transferQueue_);
+        graphicsFamily_ = indices.graphicsFamily;
+        transferFamily_ = indices.transferFamily;
+
+        enabledFeatures_ = deviceFeatures;
+        if (drawIndirectCount) {
+            cmdDrawIndexedIndirectCount_ = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCountKHR>(
+                vkGetDeviceProcAddr(device_, "vkCmdDrawIndexedIndirectCountKHR"));
+        }
     }
 
+    void LveDevice::createMemoryAllocator() {
+        VkPhysicalDeviceMemoryProperties memProperties;
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+        allocator = std::make_unique<LveMemoryAllocator>(memProperties, LveMemoryAllocator::vulkanBackend(device_));
+
+    } // createMemoryAllocator
+
+    void LveDevice::createGeometryArena() {
+        arena = std::make_unique<LveGeometryArena>(*this);
+
+    } // createGeometryArena
+
+    void LveDevice::createStagingRing() {
+        stagingRing_ = std::make_unique<LveStagingRing>(*this);
+
+    } // createStagingRing
+
     void LveDevice::createCommandPool() {
         QueueFamilyIndices queueFamilyIndices = findPhysicalQueueFamilies();
 
@@ -203,17 +277,28 @@ namespace lve {
         if (vkCreateCommandPool(device_, &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
             throw std::runtime_error("failed to create command pool!");
         }
+
+        // the pools everything else records into, one per thread, created the first time a thread asks
+        commandPools_ = std::make_unique<LveCommandPools>(device_, queueFamilyIndices.graphicsFamily);
+
+        // command buffers can only be submitted to queues of the family their pool was made for
+        transferPools_ = std::make_unique<LveCommandPools>(device_, queueFamilyIndices.transferFamily);
     }
 
-    void LveDevice::createSurface() { window.createWindowSurface(instance, &surface_); }
+    void LveDevice::createSurface() {
+        if (window != nullptr)
+            window->createWindowSurface(instance, &surface_);
+
+    } // createSurface
 
     bool LveDevice::isDeviceSuitable(VkPhysicalDevice device) {
         QueueFamilyIndices indices = findQueueFamilies(device);
 
         bool extensionsSupported = checkDeviceExtensionSupport(device);
 
-        bool swapChainAdequate = false;
-        if (extensionsSupported) {
+        // headless has nothing to present to, any device that draws will do
+        bool swapChainAdequate = isHeadless();
+        if (extensionsSupported && !isHeadless()) {
             SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
             swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
         }
@@ -273,9 +358,11 @@ namespace lve {
     }
 
     std::vector<const char*> LveDevice::getRequiredExtensions() {
+        // glfw is not even initialized when headless, and without a surface none of its extensions are needed
         uint32_t glfwExtensionCount = 0;
-        const char** glfwExtensions;
-        glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+        const char** glfwExtensions = nullptr;
+        if (!isHeadless())
+            glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
 
         std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
 
@@ -309,6 +396,22 @@ namespace lve {
         }
     }
 
+    bool LveDevice::isDeviceExtensionSupported(VkPhysicalDevice device, const char* extension) {
+        uint32_t extensionCount;
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+
+        std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
+
+        for (const auto& available : availableExtensions) {
+            if (std::string(available.extensionName) == extension)
+                return true;
+        }
+
+        return false;
+
+    } // isDeviceExtensionSupported
+
     bool LveDevice::checkDeviceExtensionSupport(VkPhysicalDevice device) {
         uint32_t extensionCount;
         vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
@@ -344,8 +447,13 @@ namespace lve {
                 indices.graphicsFamily = i;
                 indices.graphicsFamilyHasValue = true;
             }
+            // headless presents nowhere, the graphics family stands in so the present queue is just the graphics queue
             VkBool32 presentSupport = false;
-            vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+            if (surface_ != VK_NULL_HANDLE)
+                vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+            else
+                presentSupport = (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0;
+
             if (queueFamily.queueCount > 0 && presentSupport) {
                 indices.presentFamily = i;
                 indices.presentFamilyHasValue = true;
@@ -357,6 +465,24 @@ namespace lve {
             i++;
         }
 
+        // a family that can copy but not draw is a separate copy engine, one that can not run compute either is the pure DMA one
+        // graphics queues can always copy, so they are the fallback
+        indices.transferFamily = indices.graphicsFamily;
+        int bestTransferScore = 0;
+        for (uint32_t family = 0; family < queueFamilyCount; family++) {
+            const VkQueueFlags flags = queueFamilies[family].queueFlags;
+            if (queueFamilies[family].queueCount == 0 || !(flags & VK_QUEUE_TRANSFER_BIT) || (flags & VK_QUEUE_GRAPHICS_BIT))
+                continue;
+
+            const int score = (flags & VK_QUEUE_COMPUTE_BIT) ? 1 : 2;
+            if (score > bestTransferScore) {
+                indices.transferFamily = family;
+                bestTransferScore = score;
+
+            } // if
+
+        } // for
+
         return indices;
     }
 
@@ -421,7 +547,7 @@ namespace lve {
         VkBufferUsageFlags usage,
         VkMemoryPropertyFlags properties,
         VkBuffer& buffer,
-        VkDeviceMemory& bufferMemory) {
+        LveAllocation& bufferMemory) {
         VkBufferCreateInfo bufferInfo{};
         bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
         bufferInfo.size = size;
@@ -435,27 +561,19 @@ namespace lve {
         VkMemoryRequirements memRequirements;
         vkGetBufferMemoryRequirements(device_, buffer, &memRequirements);
 
-        VkMemoryAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+        bufferMemory = allocator->allocate(memRequirements, properties, true);
+        vkBindBufferMemory(device_, buffer, bufferMemory.memory, bufferMemory.offset);
+    }
 
-        if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
-            throw std::runtime_error("failed to allocate vertex buffer memory!");
-        }
+    void LveDevice::destroyBuffer(VkBuffer buffer, const LveAllocation& bufferMemory) {
+        vkDestroyBuffer(device_, buffer, nullptr);
+        allocator->free(bufferMemory);
 
-        vkBindBufferMemory(device_, buffer, bufferMemory, 0);
-    }
+    } // destroyBuffer
 
     VkCommandBuffer LveDevice::beginSingleTimeCommands() {
-        VkCommandBufferAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-        allocInfo.commandPool = commandPool;
-        allocInfo.commandBufferCount = 1;
-
-        VkCommandBuffer commandBuffer;
-        vkAllocateCommandBuffers(device_, &allocInfo, &commandBuffer);
+        // a reused buffer from this thread's TRANSIENT pool, so any thread can do this without sharing a pool
+        VkCommandBuffer commandBuffer = commandPools_->allocateOneShot();
 
         VkCommandBufferBeginInfo beginInfo{};
         beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -473,24 +591,353 @@ namespace lve {
         submitInfo.commandBufferCount = 1;
         submitInfo.pCommandBuffers = &commandBuffer;
 
-        vkQueueSubmit(graphicsQueue_, 1, &submitInfo, VK_NULL_HANDLE);
-        vkQueueWaitIdle(graphicsQueue_);
+        // a fence only waits for this submission, vkQueueWaitIdle would also wait for every frame in flight
+        VkFenceCreateInfo fenceInfo{};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+        VkFence fence;
+        if (vkCreateFence(device_, &fenceInfo, nullptr, &fence) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create fence!");
+        }
 
-        vkFreeCommandBuffers(device_, commandPool, 1, &commandBuffer);
+        {
+            auto queueLock = lockQueue(graphicsQueue_);
+            vkQueueSubmit(graphicsQueue_, 1, &submitInfo, fence);
+
+        } // lock
+
+        vkWaitForFences(device_, 1, &fence, VK_TRUE, UINT64_MAX);
+
+        vkDestroyFence(device_, fence, nullptr);
+        commandPools_->freeOneShot(commandBuffer);
     }
 
-    void LveDevice::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) {
-        VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+    void LveDevice::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize dstOffset) {
+        VkCommandBuffer commandBuffer = beginTransferCommands();
 
         VkBufferCopy copyRegion{};
         copyRegion.srcOffset = 0;  // Optional
-        copyRegion.dstOffset = 0;  // Optional
+        copyRegion.dstOffset = dstOffset;
         copyRegion.size = size;
         vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
 
-        endSingleTimeCommands(commandBuffer);
+        const TransferRegion region{ dstBuffer, dstOffset, size };
+        waitForTransfer(submitTransfer(commandBuffer, { &region, 1 }));
     }
 
+    VkCommandBuffer LveDevice::beginTransferCommands() {
+        // a pool of this thread's own, recording never shares a pool with another loader thread or with retireTransfers
+        VkCommandBuffer commandBuffer = transferPools_->allocateOneShot();
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+        vkBeginCommandBuffer(commandBuffer, &beginInfo);
+        return commandBuffer;
+
+    } // beginTransferCommands
+
+    uint64_t LveDevice::submitTransfer(
+        VkCommandBuffer commandBuffer,
+        std::span<const TransferRegion> regions,
+        std::span<const TransferImage> images,
+        VkPipelineStageFlags dstStageMask,
+        VkAccessFlags dstAccessMask) {
+        Transfer transfer{};
+        transfer.commandBuffer = commandBuffer;
+        transfer.owner = std::this_thread::get_id();
+        transfer.dstStageMask = dstStageMask;
+
+        // images are read by shaders or transitioned to another layout, not fetched as vertices
+        constexpr VkPipelineStageFlags imageStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+        if (!images.empty()) {
+            transfer.dstStageMask |= imageStageMask;
+            dstStageMask |= imageStageMask;
+            dstAccessMask |= VK_ACCESS_SHADER_READ_BIT;
+
+        } // if
+
+        if (hasDedicatedTransferQueue()) {
+            // buffers are exclusive to one queue family, the transfer queue releases what it wrote and the graphics queue
+            // acquires it with a matching barrier, the first half is recorded here and the second once the copies are done
+            std::vector<VkBufferMemoryBarrier> releaseBarriers{};
+            for (const auto& region : regions) {
+                VkBufferMemoryBarrier barrier{};
+                barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+                barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+                barrier.dstAccessMask = 0; // ignored on release
+                barrier.srcQueueFamilyIndex = transferFamily_;
+                barrier.dstQueueFamilyIndex = graphicsFamily_;
+                barrier.buffer = region.buffer;
+                barrier.offset = region.offset;
+                barrier.size = region.size;
+                releaseBarriers.push_back(barrier);
+
+                barrier.srcAccessMask = 0; // ignored on acquire
+                barrier.dstAccessMask = dstAccessMask;
+                transfer.acquireBarriers.push_back(barrier);
+
+            } // for
+
+            std::vector<VkImageMemoryBarrier> imageReleaseBarriers{};
+            for (const auto& image : images) {
+                VkImageMemoryBarrier barrier{};
+                barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+                barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+                barrier.dstAccessMask = 0;
+                barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+                barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+                barrier.srcQueueFamilyIndex = transferFamily_;
+                barrier.dstQueueFamilyIndex = graphicsFamily_;
+                barrier.image = image.image;
+                barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, image.layerCount };
+                imageReleaseBarriers.push_back(barrier);
+
+                barrier.srcAccessMask = 0;
+                barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+                transfer.imageAcquireBarriers.push_back(barrier);
+
+            } // for
+
+            vkCmdPipelineBarrier(
+                commandBuffer,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                0,
+                0, nullptr,
+                static_cast<uint32_t>(releaseBarriers.size()), releaseBarriers.data(),
+                static_cast<uint32_t>(imageReleaseBarriers.size()), imageReleaseBarriers.data()
+
+            ); // vkCmdPipelineBarrier
+
+        } // if
+        else {
+            // same queue as the draws, a plain barrier makes the copies visible to everything submitted after them
+            VkMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = dstAccessMask;
+            vkCmdPipelineBarrier(
+                commandBuffer,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                dstStageMask,
+                0,
+                1, &barrier,
+                0, nullptr,
+                0, nullptr
+
+            ); // vkCmdPipelineBarrier
+
+        } // else
+
+        if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+            throw std::runtime_error("failed to record transfer command buffer!");
+        }
+
+        VkFenceCreateInfo fenceInfo{};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        if (vkCreateFence(device_, &fenceInfo, nullptr, &transfer.fence) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create transfer fence!");
+        }
+
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &commandBuffer;
+
+        std::lock_guard<std::mutex> lock{ transferMutex };
+        auto queueLock = lockQueue(transferQueue_);
+        if (vkQueueSubmit(transferQueue_, 1, &submitInfo, transfer.fence) != VK_SUCCESS) {
+            throw std::runtime_error("failed to submit transfer command buffer!");
+        }
+
+        transfer.ticket = nextTicket++;
+        transfers.push_back(std::move(transfer));
+        return transfers.back().ticket;
+
+    } // submitTransfer
+
+    bool LveDevice::isTransferComplete(uint64_t ticket) {
+        std::lock_guard<std::mutex> lock{ transferMutex };
+        retireTransfers();
+        return completedTicket >= ticket;
+
+    } // isTransferComplete
+
+    void LveDevice::waitForTransfer(uint64_t ticket) {
+        // a fence signals only after everything submitted to the queue before it, so the last transfer up to ticket is all we wait on
+        VkFence fence = VK_NULL_HANDLE;
+        uint64_t waitedTicket = 0;
+        {
+            std::lock_guard<std::mutex> lock{ transferMutex };
+            retireTransfers();
+
+            auto last = std::find_if(transfers.rbegin(), transfers.rend(), [ticket](const Transfer& transfer) { return transfer.ticket <= ticket; });
+            if (last == transfers.rend())
+                return;
+
+            // keeps retireTransfers from destroying the fence while we wait on it
+            last->waiters++;
+            fence = last->fence;
+            waitedTicket = last->ticket;
+
+        } // lock
+
+        // without the lock, so other loader threads keep submitting and the render thread keeps polling while the copy runs
+        vkWaitForFences(device_, 1, &fence, VK_TRUE, UINT64_MAX);
+
+        std::lock_guard<std::mutex> lock{ transferMutex };
+        auto waited = std::find_if(transfers.begin(), transfers.end(), [waitedTicket](const Transfer& transfer) { return transfer.ticket == waitedTicket; });
+        waited->waiters--;
+        retireTransfers();
+
+    } // waitForTransfer
+
+    std::unique_lock<std::mutex> LveDevice::lockQueue(VkQueue queue) {
+        // the same VkQueue always lands on the first mutex it matches
+        if (queue == graphicsQueue_)
+            return std::unique_lock<std::mutex>{ queueMutexes[0] };
+
+        if (queue == presentQueue_)
+            return std::unique_lock<std::mutex>{ queueMutexes[1] };
+
+        return std::unique_lock<std::mutex>{ queueMutexes[2] };
+
+    } // lockQueue
+
+    void LveDevice::waitIdle() {
+        // always taken in this order, nothing holds one queue lock while asking for another
+        std::scoped_lock lock{ queueMutexes[0], queueMutexes[1], queueMutexes[2] };
+        vkDeviceWaitIdle(device_);
+
+    } // waitIdle
+
+    void LveDevice::deferRelease(std::function<void()> release) {
+        {
+            std::lock_guard<std::mutex> lock{ releaseMutex };
+            if (tracksFrames) {
+                deferredReleases.push_back({ recordingFrame, std::move(release) });
+                return;
+
+            } // if
+
+        }
+
+        release();
+
+    } // deferRelease
+
+    void LveDevice::advanceFrame(uint64_t frameNumber, uint64_t completed) {
+        std::vector<DeferredRelease> ready;
+
+        {
+            std::lock_guard<std::mutex> lock{ releaseMutex };
+            tracksFrames = true;
+            recordingFrame = frameNumber;
+            completedFrames = std::max(completedFrames, completed);
+
+            // queued in frame order, released outside the lock since they take the arena's and allocator's locks
+            auto firstBusy = std::find_if(deferredReleases.begin(), deferredReleases.end(), [this](const DeferredRelease& deferred) {
+                return deferred.frameNumber >= completedFrames;
+
+            }); // find_if
+
+            ready.assign(std::make_move_iterator(deferredReleases.begin()), std::make_move_iterator(firstBusy));
+            deferredReleases.erase(deferredReleases.begin(), firstBusy);
+
+        }
+
+        for (auto& deferred : ready)
+            deferred.release();
+
+    } // advanceFrame
+
+    void LveDevice::retireTransfers() {
+        // fences on one queue signal in submission order, so we can stop at the first one that is still busy,
+        // or that someone is still waiting on, it is retired by the last of them
+        size_t finished = 0;
+        while (finished < transfers.size() && transfers[finished].waiters == 0 && vkGetFenceStatus(device_, transfers[finished].fence) == VK_SUCCESS) {
+            Transfer& transfer = transfers[finished];
+            transferPools_->freeOneShot(transfer.commandBuffer, transfer.owner);
+            vkDestroyFence(device_, transfer.fence, nullptr);
+
+            // the graphics queue acquire is submitted after the host saw the copies finish, which is all the ordering it needs,
+            // so nothing on the graphics queue ever waits on the GPU for an upload
+            if (!transfer.acquireBarriers.empty() || !transfer.imageAcquireBarriers.empty())
+                submitAcquire(transfer);
+
+            completedTicket = transfer.ticket;
+            finished++;
+
+        } // while
+
+        transfers.erase(transfers.begin(), transfers.begin() + finished);
+
+        finished = 0;
+        while (finished < acquires.size() && vkGetFenceStatus(device_, acquires[finished].fence) == VK_SUCCESS) {
+            vkFreeCommandBuffers(device_, commandPool, 1, &acquires[finished].commandBuffer);
+            vkDestroyFence(device_, acquires[finished].fence, nullptr);
+            finished++;
+
+        } // while
+
+        acquires.erase(acquires.begin(), acquires.begin() + finished);
+
+    } // retireTransfers
+
+    void LveDevice::submitAcquire(const Transfer& transfer) {
+        Transfer acquire{};
+        acquire.ticket = transfer.ticket;
+
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandPool = commandPool;
+        allocInfo.commandBufferCount = 1;
+        if (vkAllocateCommandBuffers(device_, &allocInfo, &acquire.commandBuffer) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate acquire command buffer!");
+        }
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vkBeginCommandBuffer(acquire.commandBuffer, &beginInfo);
+
+        vkCmdPipelineBarrier(
+            acquire.commandBuffer,
+            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+            transfer.dstStageMask,
+            0,
+            0, nullptr,
+            static_cast<uint32_t>(transfer.acquireBarriers.size()), transfer.acquireBarriers.data(),
+            static_cast<uint32_t>(transfer.imageAcquireBarriers.size()), transfer.imageAcquireBarriers.data()
+
+        ); // vkCmdPipelineBarrier
+
+        if (vkEndCommandBuffer(acquire.commandBuffer) != VK_SUCCESS) {
+            throw std::runtime_error("failed to record acquire command buffer!");
+        }
+
+        VkFenceCreateInfo fenceInfo{};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        if (vkCreateFence(device_, &fenceInfo, nullptr, &acquire.fence) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create acquire fence!");
+        }
+
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &acquire.commandBuffer;
+        auto queueLock = lockQueue(graphicsQueue_);
+        if (vkQueueSubmit(graphicsQueue_, 1, &submitInfo, acquire.fence) != VK_SUCCESS) {
+            throw std::runtime_error("failed to submit acquire command buffer!");
+        }
+
+        acquires.push_back(std::move(acquire));
+
+    } // submitAcquire
+
     void LveDevice::copyBufferToImage(
         VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount) {
         VkCommandBuffer commandBuffer = beginSingleTimeCommands();
@@ -522,7 +969,7 @@ namespace lve {
         const VkImageCreateInfo& imageInfo,
         VkMemoryPropertyFlags properties,
         VkImage& image,
-        VkDeviceMemory& imageMemory) {
+        LveAllocation& imageMemory) {
         if (vkCreateImage(device_, &imageInfo, nullptr, &image) != VK_SUCCESS) {
             throw std::runtime_error("failed to create image!");
         }
@@ -530,18 +977,17 @@ namespace lve {
         VkMemoryRequirements memRequirements;
         vkGetImageMemoryRequirements(device_, image, &memRequirements);
 
-        VkMemoryAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+        imageMemory = allocator->allocate(memRequirements, properties, imageInfo.tiling == VK_IMAGE_TILING_LINEAR);
 
-        if (vkAllocateMemory(device_, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
-            throw std::runtime_error("failed to allocate image memory!");
-        }
-
-        if (vkBindImageMemory(device_, image, imageMemory, 0) != VK_SUCCESS) {
+        if (vkBindImageMemory(device_, image, imageMemory.memory, imageMemory.offset) != VK_SUCCESS) {
             throw std::runtime_error("failed to bind image memory!");
         }
     }
 
+    void LveDevice::destroyImage(VkImage image, const LveAllocation& imageMemory) {
+        vkDestroyImage(device_, image, nullptr);
+        allocator->free(imageMemory);
+
+    } // destroyImage
+
 }  // namespace lve
\ No newline at end of file
@@ -1,9 +1,19 @@
 #pragma once
 
 #include "lve_window.hpp"
+#include "lve_command_pools.hpp"
+#include "lve_memory_allocator.hpp"
+#include "lve_geometry_arena.hpp"
+#include "lve_staging_ring.hpp"
 
 // std lib headers
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
 #include <string>
+#include <thread>
 #include <vector>
 
 namespace lve {
@@ -17,6 +27,7 @@ namespace lve {
     struct QueueFamilyIndices {
         uint32_t graphicsFamily;
         uint32_t presentFamily;
+        uint32_t transferFamily; // a family that copies but does not draw if the GPU has one, the graphics family otherwise
         bool graphicsFamilyHasValue = false;
         bool presentFamilyHasValue = false;
         bool isComplete() { return graphicsFamilyHasValue && presentFamilyHasValue; }
@@ -31,6 +42,9 @@ namespace lve {
 #endif
 
         LveDevice(LveWindow& window);
+        // headless, no surface and no present or swap chain extensions, render into an LveOffscreenTarget instead
+        // works with software drivers and on machines without a display
+        LveDevice();
         ~LveDevice();
 
         // Not copyable or movable
@@ -39,28 +53,50 @@ namespace lve {
         LveDevice(LveDevice&&) = delete;
         LveDevice& operator=(LveDevice&&) = delete;
 
+        // device internal work only, record through commandPools() so each thread and frame has pools of its own
         VkCommandPool getCommandPool() { return commandPool; }
+        LveCommandPools& commandPools() { return *commandPools_; }
         VkDevice device() { return device_; }
         VkSurfaceKHR surface() { return surface_; }
+        bool isHeadless() const { return window == nullptr; } // isHeadless
         VkQueue graphicsQueue() { return graphicsQueue_; }
         VkQueue presentQueue() { return presentQueue_; }
+        VkQueue transferQueue() { return transferQueue_; }
+        bool hasDedicatedTransferQueue() const { return transferFamily_ != graphicsFamily_; } // hasDedicatedTransferQueue
+
+        // a queue takes one vkQueueSubmit or vkQueuePresentKHR at a time, and loader threads submit uploads to the queues
+        // the renderer draws and presents on (without a dedicated copy engine the transfer queue is the graphics queue),
+        // so hold this around every submit and present, queues that are the same VkQueue share the lock
+        std::unique_lock<std::mutex> lockQueue(VkQueue queue);
+        // vkDeviceWaitIdle, with every queue locked as it needs
+        void waitIdle();
 
         SwapChainSupportDetails getSwapChainSupport() { return querySwapChainSupport(physicalDevice); }
         uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
         QueueFamilyIndices findPhysicalQueueFamilies() { return findQueueFamilies(physicalDevice); }
+        VkPhysicalDevice getPhysicalDevice() { return physicalDevice; }
+        // what createLogicalDevice turned on, optional features are only set when the GPU has them
+        const VkPhysicalDeviceFeatures& enabledFeatures() const { return enabledFeatures_; }
+        // vkCmdDrawIndexedIndirectCountKHR, nullptr without VK_KHR_draw_indirect_count
+        PFN_vkCmdDrawIndexedIndirectCountKHR cmdDrawIndexedIndirectCount() const { return cmdDrawIndexedIndirectCount_; }
         VkFormat findSupportedFormat(
             const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
 
         // Buffer Helper Functions
+        // memory comes out of the LveMemoryAllocator and usually shares its VkDeviceMemory with other resources,
+        // so never vkMapMemory or vkFreeMemory it: host visible memory is already mapped at bufferMemory.mapped,
+        // and destroyBuffer / destroyImage hand the range back
         void createBuffer(
             VkDeviceSize size,
             VkBufferUsageFlags usage,
             VkMemoryPropertyFlags properties,
             VkBuffer& buffer,
-            VkDeviceMemory& bufferMemory);
+            LveAllocation& bufferMemory);
+        void destroyBuffer(VkBuffer buffer, const LveAllocation& bufferMemory);
         VkCommandBuffer beginSingleTimeCommands();
         void endSingleTimeCommands(VkCommandBuffer commandBuffer);
-        void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
+        // runs on the transfer queue but still waits for the copy, use submitTransfer to keep going while it runs
+        void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize dstOffset = 0);
         void copyBufferToImage(
             VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount);
 
@@ -68,18 +104,92 @@ namespace lve {
             const VkImageCreateInfo& imageInfo,
             VkMemoryPropertyFlags properties,
             VkImage& image,
-            VkDeviceMemory& imageMemory);
+            LveAllocation& imageMemory);
+        void destroyImage(VkImage image, const LveAllocation& imageMemory);
+
+        // Transfer Helper Functions
+        // copies recorded into a command buffer from beginTransferCommands run on the transfer queue, so on GPUs with
+        // a dedicated copy engine they overlap with rendering instead of queueing up behind it
+        // submitTransfer returns right away with a ticket, tickets count up in submission order like a timeline semaphore
+        // and a finished ticket means every earlier one has finished too
+        struct TransferRegion {
+            VkBuffer buffer;
+            VkDeviceSize offset;
+            VkDeviceSize size;
+
+        }; // TransferRegion
+
+        // the color mip 0 copyBufferToImage writes, it stays in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+        // and is handed over ready for the fragment shader or a layout transition
+        struct TransferImage {
+            VkImage image;
+            uint32_t layerCount;
+
+        }; // TransferImage
+
+        // from the calling thread's transfer pool, so threads record uploads side by side, submit it on the same thread
+        VkCommandBuffer beginTransferCommands();
+
+        // regions are what the copies wrote, they are handed over to the graphics queue family for dstStageMask / dstAccessMask
+        // once the ticket is complete the graphics queue can use them, staging buffers can be released at that point too
+        uint64_t submitTransfer(
+            VkCommandBuffer commandBuffer,
+            std::span<const TransferRegion> regions,
+            std::span<const TransferImage> images = {},
+            VkPipelineStageFlags dstStageMask = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+            VkAccessFlags dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT);
+        bool isTransferComplete(uint64_t ticket);
+        void waitForTransfer(uint64_t ticket);
+
+        // Deferred Release
+        // a resource the frames in flight may still be reading is released once they have finished on the GPU,
+        // the renderer tells us from beginFrame how far it has got, without a renderer nothing is in flight and it goes right away
+        void deferRelease(std::function<void()> release);
+        // frameNumber is the frame about to be recorded, every frame before completedFrames has finished
+        void advanceFrame(uint64_t frameNumber, uint64_t completedFrames);
+
+        LveMemoryAllocator& memoryAllocator() { return *allocator; }
+        LveGeometryArena& geometryArena() { return *arena; }
+        LveStagingRing& stagingRing() { return *stagingRing_; }
 
         VkPhysicalDeviceProperties properties;
 
     private:
+        void init();
         void createInstance();
         void setupDebugMessenger();
         void createSurface();
         void pickPhysicalDevice();
         void createLogicalDevice();
+        void createMemoryAllocator();
+        void createGeometryArena();
+        void createStagingRing();
         void createCommandPool();
 
+        // a submission that has not been retired yet, on the transfer queue with the graphics acquire still to come,
+        // or the acquire itself on the graphics queue
+        struct Transfer {
+            uint64_t ticket;
+            VkCommandBuffer commandBuffer;
+            std::thread::id owner; // the thread whose transferPools_ it came from
+            VkFence fence;
+            uint32_t waiters = 0; // threads in waitForTransfer on the fence outside the lock, it is not retired until they are done
+            VkPipelineStageFlags dstStageMask;
+            std::vector<VkBufferMemoryBarrier> acquireBarriers;
+            std::vector<VkImageMemoryBarrier> imageAcquireBarriers;
+
+        }; // Transfer
+
+        struct DeferredRelease {
+            uint64_t frameNumber; // the frame being recorded when it was let go of, the last one that can be using it
+            std::function<void()> release;
+
+        }; // DeferredRelease
+
+        // transferMutex has to be held for these
+        void retireTransfers();
+        void submitAcquire(const Transfer& transfer);
+
         // helper functions
         bool isDeviceSuitable(VkPhysicalDevice device);
         std::vector<const char*> getRequiredExtensions();
@@ -88,21 +198,45 @@ namespace lve {
         void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo);
         void hasGflwRequiredInstanceExtensions();
         bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+        bool isDeviceExtensionSupported(VkPhysicalDevice device, const char* extension);
         SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device);
 
         VkInstance instance;
         VkDebugUtilsMessengerEXT debugMessenger;
         VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
-        LveWindow& window;
-        VkCommandPool commandPool;
+        LveWindow* window = nullptr; // nullptr when headless
+        VkCommandPool commandPool; // graphics queue acquires, transferMutex has to be held
+        std::unique_ptr<LveCommandPools> commandPools_;
+        std::unique_ptr<LveCommandPools> transferPools_; // for the transfer queue's family
+        std::unique_ptr<LveMemoryAllocator> allocator;
+        std::unique_ptr<LveGeometryArena> arena;
+        std::unique_ptr<LveStagingRing> stagingRing_;
 
         VkDevice device_;
-        VkSurfaceKHR surface_;
+        VkSurfaceKHR surface_ = VK_NULL_HANDLE;
         VkQueue graphicsQueue_;
         VkQueue presentQueue_;
+        VkQueue transferQueue_;
+        uint32_t graphicsFamily_;
+        uint32_t transferFamily_;
+        VkPhysicalDeviceFeatures enabledFeatures_{};
+        PFN_vkCmdDrawIndexedIndirectCountKHR cmdDrawIndexedIndirectCount_ = nullptr;
+
+        std::mutex queueMutexes[3]; // graphics, present, transfer, see lockQueue
+        std::mutex transferMutex; // models are loaded on worker threads, guards the transfers and acquires below
+        std::vector<Transfer> transfers{}; // on the transfer queue, in submission order
+        std::vector<Transfer> acquires{}; // on the graphics queue, only with a dedicated transfer queue
+        uint64_t nextTicket = 1;
+        uint64_t completedTicket = 0;
+
+        std::mutex releaseMutex; // models are let go of on whatever thread drops the last reference
+        std::vector<DeferredRelease> deferredReleases{};
+        bool tracksFrames = false; // set by the first advanceFrame
+        uint64_t recordingFrame = 0;
+        uint64_t completedFrames = 0;
 
         const std::vector<const char*> validationLayers = { "VK_LAYER_KHRONOS_validation" };
-        const std::vector<const char*> deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+        std::vector<const char*> deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME }; // none when headless
     };
 
 }  // namespace Lve
\ No newline at end of file
@@ -0,0 +1,135 @@
+#include "lve_file_mapping.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace lve {
+
+	LveFileMapping::~LveFileMapping() {
+		unmap();
+
+	} // ~LveFileMapping
+
+#ifdef _WIN32
+
+	bool LveFileMapping::map(const std::string& filepath) {
+		unmap();
+
+		HANDLE file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER fileSize{};
+		if (!GetFileSizeEx(file, &fileSize)) {
+			CloseHandle(file);
+			return false;
+
+		} // if
+
+		fileHandle = file;
+		size_ = static_cast<size_t>(fileSize.QuadPart);
+		mapped = true;
+
+		// windows refuses to create a mapping of a zero byte file, there is nothing to read anyway
+		if (size_ == 0)
+			return true;
+
+		mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mappingHandle == nullptr) {
+			unmap();
+			return false;
+
+		} // if
+
+		data_ = static_cast<const std::byte*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+		if (data_ == nullptr) {
+			unmap();
+			return false;
+
+		} // if
+
+		return true;
+
+	} // map
+
+	void LveFileMapping::unmap() {
+		if (data_ != nullptr)
+			UnmapViewOfFile(data_);
+
+		if (mappingHandle != nullptr)
+			CloseHandle(mappingHandle);
+
+		if (fileHandle != nullptr)
+			CloseHandle(fileHandle);
+
+		data_ = nullptr;
+		size_ = 0;
+		mapped = false;
+		mappingHandle = nullptr;
+		fileHandle = nullptr;
+
+	} // unmap
+
+#else
+
+	bool LveFileMapping::map(const std::string& filepath) {
+		unmap();
+
+		int fd = open(filepath.c_str(), O_RDONLY);
+		if (fd < 0)
+			return false;
+
+		struct stat fileInfo {};
+		if (fstat(fd, &fileInfo) != 0) {
+			close(fd);
+			return false;
+
+		} // if
+
+		fileDescriptor = fd;
+		size_ = static_cast<size_t>(fileInfo.st_size);
+		mapped = true;
+
+		// mmap rejects a length of zero
+		if (size_ == 0)
+			return true;
+
+		void* view = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (view == MAP_FAILED) {
+			unmap();
+			return false;
+
+		} // if
+
+		// we read front to back, so let the kernel read ahead aggressively
+		madvise(view, size_, MADV_SEQUENTIAL);
+		data_ = static_cast<const std::byte*>(view);
+		return true;
+
+	} // map
+
+	void LveFileMapping::unmap() {
+		if (data_ != nullptr)
+			munmap(const_cast<std::byte*>(data_), size_);
+
+		if (fileDescriptor >= 0)
+			close(fileDescriptor);
+
+		data_ = nullptr;
+		size_ = 0;
+		mapped = false;
+		fileDescriptor = -1;
+
+	} // unmap
+
+#endif
+
+} // lve
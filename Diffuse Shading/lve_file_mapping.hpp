@@ -0,0 +1,43 @@
+#pragma once
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace lve {
+
+	// read only view of a whole file mapped into our address space
+	// the OS pages the file in on demand, so opening a mapping costs almost nothing and reading it costs what the bytes cost
+	class LveFileMapping {
+	public:
+		LveFileMapping() = default;
+		~LveFileMapping();
+
+		// the mapping owns OS handles, copying it would unmap the memory twice
+		LveFileMapping(const LveFileMapping&) = delete;
+		LveFileMapping& operator=(const LveFileMapping&) = delete;
+
+		// returns false if the file does not exist or could not be mapped, an empty file maps fine but has no data
+		bool map(const std::string& filepath);
+		void unmap();
+
+		bool isMapped() const { return mapped; } // isMapped
+		const std::byte* data() const { return data_; } // data
+		size_t size() const { return size_; } // size
+
+	private:
+		const std::byte* data_ = nullptr;
+		size_t size_ = 0;
+		bool mapped = false;
+
+#ifdef _WIN32
+		void* fileHandle = nullptr;
+		void* mappingHandle = nullptr;
+#else
+		int fileDescriptor = -1;
+#endif
+
+	}; // LveFileMapping
+
+} // lve
@@ -0,0 +1,133 @@
+#include "lve_frustum.hpp"
+
+// std
+#include <algorithm>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define LVE_FRUSTUM_SSE
+#endif
+
+namespace lve {
+
+	void LveBoundingSpheres::clear() {
+		x.clear();
+		y.clear();
+		z.clear();
+		radius.clear();
+		count = 0;
+
+	} // clear
+
+	void LveBoundingSpheres::reserve(size_t sphereCount) {
+		const size_t padded = (sphereCount + 3) & ~size_t{ 3 };
+		x.reserve(padded);
+		y.reserve(padded);
+		z.reserve(padded);
+		radius.reserve(padded);
+
+	} // reserve
+
+	void LveBoundingSpheres::push_back(const glm::vec3& center, float sphereRadius) {
+		// a new group of four starts out as padding, cullSpheres loads it but never looks at its result
+		if (count % 4 == 0) {
+			x.insert(x.end(), 4, 0.f);
+			y.insert(y.end(), 4, 0.f);
+			z.insert(z.end(), 4, 0.f);
+			radius.insert(radius.end(), 4, 0.f);
+
+		} // if
+
+		x[count] = center.x;
+		y[count] = center.y;
+		z[count] = center.z;
+		radius[count] = sphereRadius;
+		count++;
+
+	} // push_back
+
+	LveFrustum LveFrustum::fromMatrix(const glm::mat4& projectionView) {
+		// glm is column major, row i is m[0][i], m[1][i], m[2][i], m[3][i]
+		auto row = [&](int i) {
+			return glm::vec4{ projectionView[0][i], projectionView[1][i], projectionView[2][i], projectionView[3][i] };
+
+		}; // row
+
+		// a clip space point is inside when -w <= x <= w, -w <= y <= w and 0 <= z <= w
+		LveFrustum frustum{};
+		frustum.planes[Left] = row(3) + row(0);
+		frustum.planes[Right] = row(3) - row(0);
+		frustum.planes[Bottom] = row(3) + row(1);
+		frustum.planes[Top] = row(3) - row(1);
+		frustum.planes[Near] = row(2);
+		frustum.planes[Far] = row(3) - row(2);
+
+		// the sphere tests compare distances with radii, so the normals have to be unit length
+		for (auto& plane : frustum.planes) {
+			const float length = glm::length(glm::vec3{ plane });
+			if (length > 0.f)
+				plane = plane / length;
+
+		} // for
+
+		return frustum;
+
+	} // fromMatrix
+
+	bool LveFrustum::intersectsSphere(const glm::vec3& center, float radius) const {
+		for (const auto& plane : planes) {
+			if (glm::dot(glm::vec3{ plane }, center) + plane.w < -radius)
+				return false;
+
+		} // for
+
+		return true;
+
+	} // intersectsSphere
+
+	size_t LveFrustum::cullSpheres(const LveBoundingSpheres& spheres, std::vector<uint8_t>& visible) const {
+		visible.resize(spheres.size());
+		size_t visibleCount = 0;
+
+#ifdef LVE_FRUSTUM_SSE
+		// the padding fills the last group of four, so every load is whole
+		for (size_t first = 0; first < spheres.size(); first += 4) {
+			const __m128 x = _mm_loadu_ps(&spheres.x[first]);
+			const __m128 y = _mm_loadu_ps(&spheres.y[first]);
+			const __m128 z = _mm_loadu_ps(&spheres.z[first]);
+			const __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&spheres.radius[first]));
+
+			// a lane stays set while its sphere is not completely behind any plane, all set to start with
+			__m128 inside = _mm_cmpeq_ps(_mm_setzero_ps(), _mm_setzero_ps());
+			for (const auto& plane : planes) {
+				__m128 distance = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(plane.x)), _mm_set1_ps(plane.w));
+				distance = _mm_add_ps(distance, _mm_mul_ps(y, _mm_set1_ps(plane.y)));
+				distance = _mm_add_ps(distance, _mm_mul_ps(z, _mm_set1_ps(plane.z)));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+
+			} // for
+
+			const int mask = _mm_movemask_ps(inside);
+			const size_t lanes = std::min<size_t>(4, spheres.size() - first);
+			for (size_t lane = 0; lane < lanes; lane++) {
+				const uint8_t isVisible = (mask >> lane) & 1;
+				visible[first + lane] = isVisible;
+				visibleCount += isVisible;
+
+			} // for
+
+		} // for
+#else
+		for (size_t i = 0; i < spheres.size(); i++) {
+			const uint8_t isVisible = intersectsSphere({ spheres.x[i], spheres.y[i], spheres.z[i] }, spheres.radius[i]) ? 1 : 0;
+			visible[i] = isVisible;
+			visibleCount += isVisible;
+
+		} // for
+#endif
+
+		return visibleCount;
+
+	} // cullSpheres
+
+} // lve
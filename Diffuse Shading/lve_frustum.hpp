@@ -0,0 +1,60 @@
+#pragma once
+
+// libs
+#define GLM_FORCE_RADIANS // forces in radians and not degrees
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE // Vulkan uses 0 to 1, openGL uses 1 to 1
+#include <glm/glm.hpp>
+
+// std
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace lve {
+
+	// world space bounding spheres as one array per component instead of one struct per sphere,
+	// so four of them load straight into SSE registers
+	// the arrays are padded to a multiple of four
+	class LveBoundingSpheres {
+	public:
+		void clear();
+		void reserve(size_t sphereCount);
+		void push_back(const glm::vec3& center, float sphereRadius);
+		size_t size() const { return count; } // size
+
+	private:
+		friend class LveFrustum;
+
+		std::vector<float> x{};
+		std::vector<float> y{};
+		std::vector<float> z{};
+		std::vector<float> radius{};
+		size_t count = 0;
+
+	}; // LveBoundingSpheres
+
+	// the six planes of a camera's view volume, normalized with the normals pointing inwards
+	class LveFrustum {
+	public:
+		enum Plane { Left, Right, Bottom, Top, Near, Far };
+
+		// Gribb and Hartmann, straight from the rows of projection * view with Vulkan's 0 to 1 depth
+		// in world space when given projection * view, in model space when given projection * view * model
+		static LveFrustum fromMatrix(const glm::mat4& projectionView);
+
+		// false only when the sphere is completely outside one of the planes, a sphere near a corner can pass while still being outside
+		bool intersectsSphere(const glm::vec3& center, float radius) const;
+
+		// visible[i] is 1 for every sphere that intersects the frustum and 0 otherwise, returns how many do
+		// tests four spheres per instruction with SSE where the compiler has it, one at a time otherwise
+		size_t cullSpheres(const LveBoundingSpheres& spheres, std::vector<uint8_t>& visible) const;
+
+		const glm::vec4& getPlane(Plane plane) const { return planes[plane]; } // getPlane
+
+	private:
+		std::array<glm::vec4, 6> planes{}; // xyz the normal, w the distance, inside when dot(normal, p) + w >= 0
+
+	}; // LveFrustum
+
+} // lve
@@ -0,0 +1,85 @@
+#include "lve_geometry_arena.hpp"
+#include "lve_device.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+
+namespace lve {
+
+	LveGeometryArena::LveGeometryArena(LveDevice& device, VkDeviceSize bufferSize) : lveDevice{ device }, bufferSize{ bufferSize } {
+
+	} // LveGeometryArena
+
+	LveGeometryArena::~LveGeometryArena() {
+		for (auto& pool : pools) {
+			assert(pool.elements.isEmpty() && "Every model must be destroyed before the geometry arena");
+			lveDevice.destroyBuffer(pool.buffer, pool.memory);
+
+		} // for
+
+	} // ~LveGeometryArena
+
+	std::optional<LveGeometryArena::Range> LveGeometryArena::allocate(VkBufferUsageFlags usage, uint32_t stride, uint32_t count) {
+		assert(stride > 0 && count > 0 && "Ranges need a stride and a count");
+
+		std::lock_guard<std::mutex> lock{ mutex };
+
+		// the oldest buffers first, so a small scene keeps everything in one buffer and binds it once
+		for (auto& pool : pools) {
+			if (pool.usage != usage || pool.stride != stride)
+				continue;
+
+			const uint64_t first = pool.elements.allocate(count);
+			if (first != LveRangeAllocator::INVALID_OFFSET)
+				return Range{ pool.buffer, stride, static_cast<uint32_t>(first), count };
+
+		} // for
+
+		// every buffer for this usage and stride is full, so the arena grows by another one
+		// a range bigger than a whole buffer would leave most of a new one unused, those get a buffer of their own from the caller
+		const uint64_t capacity = bufferSize / stride;
+		if (count > capacity)
+			return std::nullopt;
+
+		Pool created{ usage, stride, VK_NULL_HANDLE, {}, LveRangeAllocator{ capacity } };
+		lveDevice.createBuffer(
+			created.elements.getCapacity() * stride,
+			usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			created.buffer,
+			created.memory
+
+		); // createBuffer
+
+		const uint64_t first = created.elements.allocate(count);
+		pools.push_back(std::move(created));
+		return Range{ pools.back().buffer, stride, static_cast<uint32_t>(first), count };
+
+	} // allocate
+
+	void LveGeometryArena::free(const Range& range) {
+		std::lock_guard<std::mutex> lock{ mutex };
+
+		auto pool = std::find_if(pools.begin(), pools.end(), [&](const Pool& pool) { return pool.buffer == range.buffer; });
+		assert(pool != pools.end() && "Range does not belong to this arena");
+		pool->elements.free(range.first, range.count);
+
+	} // free
+
+	LveGeometryArena::Stats LveGeometryArena::getStats() {
+		std::lock_guard<std::mutex> lock{ mutex };
+
+		Stats stats{};
+		for (const auto& pool : pools) {
+			stats.bufferCount++;
+			stats.capacityBytes += pool.elements.getCapacity() * pool.stride;
+			stats.usedBytes += (pool.elements.getCapacity() - pool.elements.getFreeSize()) * pool.stride;
+
+		} // for
+
+		return stats;
+
+	} // getStats
+
+} // lve
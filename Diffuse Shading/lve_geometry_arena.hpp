@@ -0,0 +1,78 @@
+#pragma once
+
+#include "lve_memory_allocator.hpp"
+#include "lve_range_allocator.hpp"
+
+// libs
+#include <vulkan/vulkan.h>
+
+// std
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace lve {
+
+	class LveDevice;
+
+	// a few big device local buffers that every model's vertices and indices are carved out of
+	// draws then differ only in firstIndex / vertexOffset, so a frame binds its vertex and index buffers once
+	// instead of once per object, and draws of different models can later be merged into one
+	// buffers are per usage and stride, because vertexOffset counts whole vertices, and another one is added when they fill up
+	class LveGeometryArena {
+	public:
+		static constexpr VkDeviceSize DEFAULT_BUFFER_SIZE = 64ull * 1024 * 1024;
+
+		// count elements of stride bytes starting at element first of buffer
+		struct Range {
+			VkBuffer buffer = VK_NULL_HANDLE;
+			uint32_t stride = 0;
+			uint32_t first = 0;
+			uint32_t count = 0;
+
+			VkDeviceSize byteOffset() const { return static_cast<VkDeviceSize>(first) * stride; } // byteOffset
+
+		}; // Range
+
+		struct Stats {
+			uint32_t bufferCount = 0;
+			VkDeviceSize capacityBytes = 0;
+			VkDeviceSize usedBytes = 0;
+			uint32_t rangeCount = 0;
+
+		}; // Stats
+
+		LveGeometryArena(LveDevice& device, VkDeviceSize bufferSize = DEFAULT_BUFFER_SIZE);
+		~LveGeometryArena();
+
+		LveGeometryArena(const LveGeometryArena&) = delete;
+		LveGeometryArena& operator=(const LveGeometryArena&) = delete;
+
+		// usage is VK_BUFFER_USAGE_VERTEX_BUFFER_BIT or VK_BUFFER_USAGE_INDEX_BUFFER_BIT, the buffer for it is created on first use
+		// returns nothing for a range bigger than bufferSize, callers then fall back to a buffer of their own
+		// fill the range with a copy into buffer at byteOffset(), the buffers are TRANSFER_DST
+		std::optional<Range> allocate(VkBufferUsageFlags usage, uint32_t stride, uint32_t count);
+		void free(const Range& range);
+
+		Stats getStats();
+
+	private:
+		struct Pool {
+			VkBufferUsageFlags usage;
+			uint32_t stride;
+			VkBuffer buffer;
+			LveAllocation memory;
+			LveRangeAllocator elements;
+
+		}; // Pool
+
+		LveDevice& lveDevice;
+		VkDeviceSize bufferSize;
+
+		std::mutex mutex; // models are loaded on worker threads
+		std::vector<Pool> pools{};
+
+	}; // LveGeometryArena
+
+} // lve
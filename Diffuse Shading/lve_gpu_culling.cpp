@@ -0,0 +1,715 @@
+#include "lve_gpu_culling.hpp"
+#include "simple_render_system.hpp"
+
+// std
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace lve {
+
+	static_assert(sizeof(glm::mat4) == 64 && sizeof(glm::vec4) == 16, "the shader structs expect tightly packed glm types");
+
+	namespace {
+
+		constexpr uint32_t CULL_GROUP_SIZE = 64; // local_size_x of gpu_cull.comp
+		constexpr uint32_t PYRAMID_GROUP_SIZE = 8; // local_size_x and local_size_y of hiz_downsample.comp
+
+		// keeps tiny scenes from creating zero sized buffers
+		constexpr VkDeviceSize MIN_BUFFER_SIZE = 64;
+
+		// bounds are in model units, a non uniform scale takes its largest axis so they still cover the mesh
+		float maxAxisScale(const glm::mat4& modelMatrix) {
+			return std::max({
+				glm::length(glm::vec3{ modelMatrix[0] }),
+				glm::length(glm::vec3{ modelMatrix[1] }),
+				glm::length(glm::vec3{ modelMatrix[2] }) });
+
+		} // maxAxisScale
+
+		uint32_t groupCountFor(uint32_t count, uint32_t groupSize) {
+			return (count + groupSize - 1) / groupSize;
+
+		} // groupCountFor
+
+		VkDescriptorSetLayoutBinding layoutBinding(uint32_t binding, VkDescriptorType type) {
+			VkDescriptorSetLayoutBinding layoutBinding{};
+			layoutBinding.binding = binding;
+			layoutBinding.descriptorType = type;
+			layoutBinding.descriptorCount = 1;
+			layoutBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+			return layoutBinding;
+
+		} // layoutBinding
+
+	} // namespace
+
+	LveGpuCulling::LveGpuCulling(LveDevice& device) : lveDevice{ device } {
+		// the destructor does not run when we throw, the pipelines clean up after themselves but the raw handles do not
+		// anything not created yet is still VK_NULL_HANDLE, which vkDestroy* ignores
+		try {
+			createDescriptorSetLayouts();
+			createPipelines();
+			createSampler();
+
+		} // try
+		catch (...) {
+			vkDestroySampler(lveDevice.device(), sampler, nullptr);
+			vkDestroyPipelineLayout(lveDevice.device(), cullPipelineLayout, nullptr);
+			vkDestroyPipelineLayout(lveDevice.device(), pyramidPipelineLayout, nullptr);
+			vkDestroyDescriptorSetLayout(lveDevice.device(), cullSetLayout, nullptr);
+			vkDestroyDescriptorSetLayout(lveDevice.device(), pyramidSetLayout, nullptr);
+			throw;
+
+		} // catch
+
+	} // LveGpuCulling
+
+	LveGpuCulling::~LveGpuCulling() {
+		for (auto& frame : frames) {
+			for (FrameBuffer* frameBuffer : { &frame.camera, &frame.objects, &frame.groups, &frame.groupCounts, &frame.instances, &frame.drawCommands, &frame.drawCounts })
+				destroy(*frameBuffer);
+
+			// frees every set that came out of it
+			vkDestroyDescriptorPool(lveDevice.device(), frame.descriptorPool, nullptr);
+
+		} // for
+
+		destroyDepthPyramid(pyramid);
+		for (auto& retired : retiredPyramids)
+			destroyDepthPyramid(retired);
+
+		vkDestroySampler(lveDevice.device(), sampler, nullptr);
+		cullPipeline.reset();
+		compactPipeline.reset();
+		depthCopyPipeline.reset();
+		downsamplePipeline.reset();
+		vkDestroyPipelineLayout(lveDevice.device(), cullPipelineLayout, nullptr);
+		vkDestroyPipelineLayout(lveDevice.device(), pyramidPipelineLayout, nullptr);
+		vkDestroyDescriptorSetLayout(lveDevice.device(), cullSetLayout, nullptr);
+		vkDestroyDescriptorSetLayout(lveDevice.device(), pyramidSetLayout, nullptr);
+
+	} // ~LveGpuCulling
+
+	bool LveGpuCulling::isSupported(LveDevice& device) {
+		return device.enabledFeatures().drawIndirectFirstInstance == VK_TRUE;
+
+	} // isSupported
+
+	std::unique_ptr<LveGpuCulling> LveGpuCulling::create(LveDevice& device) {
+		if (!isSupported(device))
+			return nullptr;
+
+		// a missing .spv or a driver that rejects the shaders only costs us the faster path, not the whole app
+		try {
+			return std::make_unique<LveGpuCulling>(device);
+
+		} // try
+		catch (const std::exception& e) {
+			std::cerr << "GPU culling unavailable, culling on the CPU: " << e.what() << "\n";
+			return nullptr;
+
+		} // catch
+
+	} // create
+
+	void LveGpuCulling::createDescriptorSetLayouts() {
+		// matches the bindings of gpu_cull.comp
+		const std::array<VkDescriptorSetLayoutBinding, 8> cullBindings{
+			layoutBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER),
+			layoutBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER),
+			layoutBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER),
+			layoutBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER),
+			layoutBinding(4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER),
+			layoutBinding(5, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER),
+			layoutBinding(6, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER),
+			layoutBinding(7, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER) };
+
+		// and the ones of hiz_downsample.comp
+		const std::array<VkDescriptorSetLayoutBinding, 3> pyramidBindings{
+			layoutBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER),
+			layoutBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE),
+			layoutBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE) };
+
+		VkDescriptorSetLayoutCreateInfo layoutInfo{};
+		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		layoutInfo.bindingCount = static_cast<uint32_t>(cullBindings.size());
+		layoutInfo.pBindings = cullBindings.data();
+		if (vkCreateDescriptorSetLayout(lveDevice.device(), &layoutInfo, nullptr, &cullSetLayout) != VK_SUCCESS)
+			throw std::runtime_error("failed to create culling descriptor set layout!");
+
+		layoutInfo.bindingCount = static_cast<uint32_t>(pyramidBindings.size());
+		layoutInfo.pBindings = pyramidBindings.data();
+		if (vkCreateDescriptorSetLayout(lveDevice.device(), &layoutInfo, nullptr, &pyramidSetLayout) != VK_SUCCESS)
+			throw std::runtime_error("failed to create depth pyramid descriptor set layout!");
+
+	} // createDescriptorSetLayouts
+
+	void LveGpuCulling::createPipelines() {
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = 1;
+		pipelineLayoutInfo.pSetLayouts = &cullSetLayout;
+		if (vkCreatePipelineLayout(lveDevice.device(), &pipelineLayoutInfo, nullptr, &cullPipelineLayout) != VK_SUCCESS)
+			throw std::runtime_error("failed to create culling pipeline layout!");
+
+		pipelineLayoutInfo.pSetLayouts = &pyramidSetLayout;
+		if (vkCreatePipelineLayout(lveDevice.device(), &pipelineLayoutInfo, nullptr, &pyramidPipelineLayout) != VK_SUCCESS)
+			throw std::runtime_error("failed to create depth pyramid pipeline layout!");
+
+		// both shaders have a single bool specialization constant that picks the pass
+		const VkSpecializationMapEntry entry{ 0, 0, sizeof(VkBool32) };
+		const VkBool32 passes[2] = { VK_FALSE, VK_TRUE };
+		VkSpecializationInfo specializations[2]{};
+		for (int i = 0; i < 2; i++) {
+			specializations[i].mapEntryCount = 1;
+			specializations[i].pMapEntries = &entry;
+			specializations[i].dataSize = sizeof(VkBool32);
+			specializations[i].pData = &passes[i];
+
+		} // for
+
+		const std::string cullShader = "C:\\Users\\suraj\\OneDrive\\Documents\\Visual Studio Projects\\Vulkan Notes\\Diffuse Shading\\gpu_cull.comp.spv";
+		const std::string pyramidShader = "C:\\Users\\suraj\\OneDrive\\Documents\\Visual Studio Projects\\Vulkan Notes\\Diffuse Shading\\hiz_downsample.comp.spv";
+		cullPipeline = std::make_unique<LveComputePipeline>(lveDevice, cullShader, cullPipelineLayout, &specializations[0]);
+		compactPipeline = std::make_unique<LveComputePipeline>(lveDevice, cullShader, cullPipelineLayout, &specializations[1]);
+		downsamplePipeline = std::make_unique<LveComputePipeline>(lveDevice, pyramidShader, pyramidPipelineLayout, &specializations[0]);
+		depthCopyPipeline = std::make_unique<LveComputePipeline>(lveDevice, pyramidShader, pyramidPipelineLayout, &specializations[1]);
+
+	} // createPipelines
+
+	void LveGpuCulling::createSampler() {
+		// the shaders only texelFetch, the sampler is there because combined image samplers need one
+		VkSamplerCreateInfo samplerInfo{};
+		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		samplerInfo.magFilter = VK_FILTER_NEAREST;
+		samplerInfo.minFilter = VK_FILTER_NEAREST;
+		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+		samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.minLod = 0.f;
+		samplerInfo.maxLod = static_cast<float>(MAX_PYRAMID_LEVELS);
+
+		if (vkCreateSampler(lveDevice.device(), &samplerInfo, nullptr, &sampler) != VK_SUCCESS)
+			throw std::runtime_error("failed to create depth pyramid sampler!");
+
+	} // createSampler
+
+	void LveGpuCulling::setScene(std::span<const LveGameObject> gameObjects) {
+		sceneObjects.clear();
+		sceneObjects.reserve(gameObjects.size());
+		for (const auto& obj : gameObjects) {
+			if (obj.model != nullptr)
+				sceneObjects.push_back({ obj.model, obj.transform.mat4() });
+
+		} // for
+
+		rebuildScene();
+
+	} // setScene
+
+	void LveGpuCulling::rebuildScene() {
+		objectData.clear();
+		groupData.clear();
+		batches.clear();
+		pendingModels.clear();
+		instanceCount = 0;
+		sceneVersion++;
+
+		// how many objects use every model that can be drawn right now
+		std::unordered_map<LveModel*, uint32_t> objectsPerModel{};
+		for (const auto& sceneObject : sceneObjects) {
+			LveModel* model = sceneObject.model.get();
+			if (!model->isResident()) {
+				if (std::find(pendingModels.begin(), pendingModels.end(), model) == pendingModels.end())
+					pendingModels.push_back(model);
+
+				continue;
+
+			} // if
+
+			// there is no index buffer to point a draw command at
+			if (!model->isIndexed())
+				continue;
+
+			objectsPerModel[model]++;
+
+		} // for
+
+		// models that bind the same pipeline and buffers end up next to each other, each run becomes one batch
+		std::vector<LveModel*> models{};
+		models.reserve(objectsPerModel.size());
+		for (const auto& [model, count] : objectsPerModel)
+			models.push_back(model);
+
+		std::sort(models.begin(), models.end(), [](LveModel* a, LveModel* b) {
+			if (a->getVertexFormat() != b->getVertexFormat())
+				return a->getVertexFormat() < b->getVertexFormat();
+
+			if (a->getVertexBuffer() != b->getVertexBuffer())
+				return std::less<VkBuffer>{}(a->getVertexBuffer(), b->getVertexBuffer());
+
+			if (a->getIndexBuffer() != b->getIndexBuffer())
+				return std::less<VkBuffer>{}(a->getIndexBuffer(), b->getIndexBuffer());
+
+			return std::less<LveModel*>{}(a, b);
+
+		}); // sort
+
+		// one group per (model, LOD), each with room for every object of its model since the LOD is only picked on the GPU
+		std::unordered_map<LveModel*, uint32_t> firstGroupOf{};
+		for (LveModel* model : models) {
+			const bool sameBatch = !batches.empty() &&
+				batches.back().model->getVertexFormat() == model->getVertexFormat() &&
+				batches.back().model->getVertexBuffer() == model->getVertexBuffer() &&
+				batches.back().model->getIndexBuffer() == model->getIndexBuffer();
+			if (!sameBatch)
+				batches.push_back({ model, static_cast<uint32_t>(groupData.size()), 0 });
+
+			firstGroupOf[model] = static_cast<uint32_t>(groupData.size());
+			const glm::mat4 dequantize = model->getQuantization().matrix();
+			for (uint32_t lod = 0; lod < model->getLodCount(); lod++) {
+				const VkDrawIndexedIndirectCommand command = model->getDrawCommand(lod, 0, instanceCount);
+
+				GroupData group{};
+				group.dequantize = dequantize;
+				group.indexCount = command.indexCount;
+				group.firstIndex = command.firstIndex;
+				group.vertexOffset = command.vertexOffset;
+				group.firstInstance = command.firstInstance;
+				group.batch = static_cast<uint32_t>(batches.size() - 1);
+				group.firstCommand = batches.back().firstCommand;
+				group.lodError = model->getLod(lod).error;
+				groupData.push_back(group);
+
+				batches.back().maxCommandCount++;
+				instanceCount += objectsPerModel[model];
+
+			} // for
+
+		} // for
+
+		objectData.reserve(sceneObjects.size());
+		for (const auto& sceneObject : sceneObjects) {
+			const auto group = firstGroupOf.find(sceneObject.model.get());
+			if (group == firstGroupOf.end())
+				continue;
+
+			const LveModel::Bounds& bounds = sceneObject.model->getBounds();
+
+			ObjectData object{};
+			object.modelMatrix = sceneObject.modelMatrix;
+			object.bounds = glm::vec4{ bounds.center, bounds.radius };
+			object.firstGroup = group->second;
+			object.lodCount = sceneObject.model->getLodCount();
+			object.maxScale = maxAxisScale(sceneObject.modelMatrix);
+			objectData.push_back(object);
+
+		} // for
+
+	} // rebuildScene
+
+	void LveGpuCulling::cull(VkCommandBuffer commandBuffer, uint32_t frameIndex, const LveCamera& camera) {
+		frameCounter++;
+		destroyRetiredPyramids();
+
+		// objects whose model finished loading since the last rebuild join the scene now
+		if (std::any_of(pendingModels.begin(), pendingModels.end(), [](LveModel* model) { return model->isResident(); }))
+			rebuildScene();
+
+		FrameResources& frame = frameFor(frameIndex);
+		if (frame.sceneVersion != sceneVersion)
+			uploadScene(frame);
+
+		// nothing has been drawn yet, a 1x1 pyramid keeps the descriptor valid until the first real one replaces it
+		if (pyramid.image == VK_NULL_HANDLE)
+			createDepthPyramid({ 1, 1 });
+
+		transitionNewPyramid(commandBuffer);
+
+		const glm::mat4& projection = camera.getProjection();
+		const glm::mat4 projectionView = projection * camera.getView();
+		const LveFrustum frustum = LveFrustum::fromMatrix(projectionView);
+		const bool orthographic = projection[2][3] == 0.f;
+
+		// the same screen size estimate as SimpleRenderSystem::selectLod, the shader divides by the distance when it is not orthographic
+		CameraData cameraData{};
+		cameraData.projectionView = projectionView;
+		cameraData.view = camera.getView();
+		cameraData.pyramidProjectionView = pyramidProjectionView;
+		for (int plane = 0; plane < 6; plane++)
+			cameraData.planes[plane] = frustum.getPlane(static_cast<LveFrustum::Plane>(plane));
+
+		cameraData.pyramidSize = { static_cast<float>(pyramid.extent.width), static_cast<float>(pyramid.extent.height) };
+		cameraData.projectionScale = (orthographic ? std::abs(projection[1][1]) : projection[1][1]) * 0.5f;
+		cameraData.orthographic = orthographic ? 1 : 0;
+		cameraData.objectCount = static_cast<uint32_t>(objectData.size());
+		cameraData.groupCount = static_cast<uint32_t>(groupData.size());
+		cameraData.occlusion = pyramidReady ? 1 : 0;
+		cameraData.lodErrorThreshold = SimpleRenderSystem::LOD_ERROR_THRESHOLD;
+		std::memcpy(frame.camera.memory.mapped, &cameraData, sizeof(CameraData));
+
+		// a pyramid is only good for the frame right after the one that built it, a frame that skips buildDepthPyramid
+		// (a resize, a different render path) turns occlusion off until there is a new one
+		pyramidReady = false;
+		cullProjectionView = projectionView;
+
+		// the set of this frame index is free again, its fence has signalled, and the pyramid may have been replaced since
+		writeCullSet(frame);
+
+		// every count starts at zero, and the commands too, so the slots no group fills draw nothing without the count extension
+		vkCmdFillBuffer(commandBuffer, frame.groupCounts.buffer, 0, VK_WHOLE_SIZE, 0);
+		vkCmdFillBuffer(commandBuffer, frame.drawCounts.buffer, 0, VK_WHOLE_SIZE, 0);
+		vkCmdFillBuffer(commandBuffer, frame.drawCommands.buffer, 0, VK_WHOLE_SIZE, 0);
+
+		// the fills, and last frame's pyramid writes, before anything here reads them
+		VkMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		vkCmdPipelineBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullPipelineLayout, 0, 1, &frame.cullSet, 0, nullptr);
+
+		if (!objectData.empty()) {
+			cullPipeline->bind(commandBuffer);
+			vkCmdDispatch(commandBuffer, groupCountFor(cameraData.objectCount, CULL_GROUP_SIZE), 1, 1);
+
+			// every object has added itself to its group before the groups are turned into commands
+			barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+			compactPipeline->bind(commandBuffer);
+			vkCmdDispatch(commandBuffer, groupCountFor(cameraData.groupCount, CULL_GROUP_SIZE), 1, 1);
+
+		} // if
+
+		// the render pass reads the commands and counts as indirect arguments and the instances as vertex input
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+		vkCmdPipelineBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+			0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	} // cull
+
+	void LveGpuCulling::buildDepthPyramid(VkCommandBuffer commandBuffer, uint32_t frameIndex, VkImageView depthImageView, VkExtent2D extent) {
+		if (extent.width == 0 || extent.height == 0)
+			return;
+
+		// after a resize the old pyramid may still be sampled by frames in flight, it goes once they are done
+		if (pyramid.extent.width != extent.width || pyramid.extent.height != extent.height) {
+			pyramid.retiredAtFrame = frameCounter;
+			retiredPyramids.push_back(std::move(pyramid));
+			pyramid = DepthPyramid{};
+			createDepthPyramid(extent);
+
+		} // if
+
+		transitionNewPyramid(commandBuffer);
+
+		// the cull pass of this frame is done reading the pyramid before it gets overwritten
+		VkMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+		FrameResources& frame = frameFor(frameIndex);
+		const uint32_t levelCount = static_cast<uint32_t>(pyramid.levelViews.size());
+
+		// level 0 copies the depth image, every level after reads the one before it
+		std::vector<VkDescriptorImageInfo> depthInfos(levelCount);
+		std::vector<VkDescriptorImageInfo> sourceInfos(levelCount);
+		std::vector<VkDescriptorImageInfo> targetInfos(levelCount);
+		std::vector<VkWriteDescriptorSet> writes{};
+		writes.reserve(levelCount * 3);
+		for (uint32_t level = 0; level < levelCount; level++) {
+			depthInfos[level] = { sampler, depthImageView, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL };
+			// level 0 has no level before it, the copy never reads the source but the descriptor still has to be valid
+			sourceInfos[level] = { VK_NULL_HANDLE, pyramid.levelViews[level == 0 ? 0 : level - 1], VK_IMAGE_LAYOUT_GENERAL };
+			targetInfos[level] = { VK_NULL_HANDLE, pyramid.levelViews[level], VK_IMAGE_LAYOUT_GENERAL };
+
+			const std::array<std::pair<VkDescriptorType, const VkDescriptorImageInfo*>, 3> bindings{ {
+				{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, &depthInfos[level] },
+				{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, &sourceInfos[level] },
+				{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, &targetInfos[level] } } };
+			for (uint32_t binding = 0; binding < bindings.size(); binding++) {
+				VkWriteDescriptorSet write{};
+				write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+				write.dstSet = frame.pyramidSets[level];
+				write.dstBinding = binding;
+				write.descriptorCount = 1;
+				write.descriptorType = bindings[binding].first;
+				write.pImageInfo = bindings[binding].second;
+				writes.push_back(write);
+
+			} // for
+
+		} // for
+
+		vkUpdateDescriptorSets(lveDevice.device(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+		for (uint32_t level = 0; level < levelCount; level++) {
+			(level == 0 ? depthCopyPipeline : downsamplePipeline)->bind(commandBuffer);
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pyramidPipelineLayout, 0, 1, &frame.pyramidSets[level], 0, nullptr);
+
+			const uint32_t width = std::max(extent.width >> level, 1u);
+			const uint32_t height = std::max(extent.height >> level, 1u);
+			vkCmdDispatch(commandBuffer, groupCountFor(width, PYRAMID_GROUP_SIZE), groupCountFor(height, PYRAMID_GROUP_SIZE), 1);
+
+			// the next level reads this one, and after the last one next frame's cull pass does
+			barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+		} // for
+
+		pyramidReady = true;
+		pyramidProjectionView = cullProjectionView;
+
+	} // buildDepthPyramid
+
+	LveGpuCulling::FrameResources& LveGpuCulling::frameFor(uint32_t frameIndex) {
+		if (frames.size() <= frameIndex)
+			frames.resize(frameIndex + 1);
+
+		FrameResources& frame = frames[frameIndex];
+		if (frame.descriptorPool != VK_NULL_HANDLE)
+			return frame;
+
+		// the cull set and one set per pyramid level
+		const std::array<VkDescriptorPoolSize, 4> poolSizes{ {
+			{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1 },
+			{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 6 },
+			{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1 + MAX_PYRAMID_LEVELS },
+			{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 2 * MAX_PYRAMID_LEVELS } } };
+
+		VkDescriptorPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.maxSets = 1 + MAX_PYRAMID_LEVELS;
+		poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+		poolInfo.pPoolSizes = poolSizes.data();
+		if (vkCreateDescriptorPool(lveDevice.device(), &poolInfo, nullptr, &frame.descriptorPool) != VK_SUCCESS)
+			throw std::runtime_error("failed to create culling descriptor pool!");
+
+		std::array<VkDescriptorSetLayout, 1 + MAX_PYRAMID_LEVELS> layouts{};
+		layouts.fill(pyramidSetLayout);
+		layouts[0] = cullSetLayout;
+
+		std::array<VkDescriptorSet, 1 + MAX_PYRAMID_LEVELS> sets{};
+		VkDescriptorSetAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool = frame.descriptorPool;
+		allocInfo.descriptorSetCount = static_cast<uint32_t>(layouts.size());
+		allocInfo.pSetLayouts = layouts.data();
+		if (vkAllocateDescriptorSets(lveDevice.device(), &allocInfo, sets.data()) != VK_SUCCESS)
+			throw std::runtime_error("failed to allocate culling descriptor sets!");
+
+		frame.cullSet = sets[0];
+		std::copy(sets.begin() + 1, sets.end(), frame.pyramidSets);
+
+		reserve(frame.camera, sizeof(CameraData), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		return frame;
+
+	} // frameFor
+
+	void LveGpuCulling::reserve(FrameBuffer& frameBuffer, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties) {
+		size = std::max(size, MIN_BUFFER_SIZE);
+		if (frameBuffer.capacity >= size)
+			return;
+
+		// the fence of the last frame with this index has signalled, so nothing on the GPU uses the old buffer any more
+		destroy(frameBuffer);
+
+		// doubling keeps a growing scene from reallocating on every change
+		frameBuffer.capacity = std::max(size, frameBuffer.capacity * 2);
+		lveDevice.createBuffer(frameBuffer.capacity, usage, properties, frameBuffer.buffer, frameBuffer.memory);
+
+	} // reserve
+
+	void LveGpuCulling::destroy(FrameBuffer& frameBuffer) {
+		if (frameBuffer.buffer != VK_NULL_HANDLE)
+			lveDevice.destroyBuffer(frameBuffer.buffer, frameBuffer.memory);
+
+		frameBuffer = FrameBuffer{};
+
+	} // destroy
+
+	void LveGpuCulling::uploadScene(FrameResources& frame) {
+		constexpr VkMemoryPropertyFlags hostVisible = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+		// written once per scene change by the CPU, read every frame by the cull pass
+		reserve(frame.objects, objectData.size() * sizeof(ObjectData), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, hostVisible);
+		reserve(frame.groups, groupData.size() * sizeof(GroupData), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, hostVisible);
+		std::memcpy(frame.objects.memory.mapped, objectData.data(), objectData.size() * sizeof(ObjectData));
+		std::memcpy(frame.groups.memory.mapped, groupData.data(), groupData.size() * sizeof(GroupData));
+
+		// only ever touched by the GPU
+		reserve(frame.groupCounts, groupData.size() * sizeof(uint32_t),
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		reserve(frame.instances, static_cast<VkDeviceSize>(instanceCount) * sizeof(SimpleRenderSystem::InstanceData),
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		reserve(frame.drawCommands, groupData.size() * sizeof(VkDrawIndexedIndirectCommand),
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		reserve(frame.drawCounts, batches.size() * sizeof(uint32_t),
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+		frame.sceneVersion = sceneVersion;
+
+	} // uploadScene
+
+	void LveGpuCulling::writeCullSet(FrameResources& frame) {
+		const std::array<VkDescriptorBufferInfo, 7> bufferInfos{ {
+			{ frame.camera.buffer, 0, sizeof(CameraData) },
+			{ frame.objects.buffer, 0, VK_WHOLE_SIZE },
+			{ frame.groups.buffer, 0, VK_WHOLE_SIZE },
+			{ frame.groupCounts.buffer, 0, VK_WHOLE_SIZE },
+			{ frame.instances.buffer, 0, VK_WHOLE_SIZE },
+			{ frame.drawCommands.buffer, 0, VK_WHOLE_SIZE },
+			{ frame.drawCounts.buffer, 0, VK_WHOLE_SIZE } } };
+		const VkDescriptorImageInfo pyramidInfo{ sampler, pyramid.view, VK_IMAGE_LAYOUT_GENERAL };
+
+		std::array<VkWriteDescriptorSet, 8> writes{};
+		for (uint32_t binding = 0; binding < writes.size(); binding++) {
+			writes[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writes[binding].dstSet = frame.cullSet;
+			writes[binding].dstBinding = binding;
+			writes[binding].descriptorCount = 1;
+			if (binding < bufferInfos.size()) {
+				writes[binding].descriptorType = binding == 0 ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+				writes[binding].pBufferInfo = &bufferInfos[binding];
+
+			} else {
+				writes[binding].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+				writes[binding].pImageInfo = &pyramidInfo;
+
+			} // else
+
+		} // for
+
+		vkUpdateDescriptorSets(lveDevice.device(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+	} // writeCullSet
+
+	void LveGpuCulling::createDepthPyramid(VkExtent2D extent) {
+		// every level half the size of the one before, down to 1x1
+		uint32_t levelCount = 1;
+		while (levelCount < MAX_PYRAMID_LEVELS && (std::max(extent.width, extent.height) >> levelCount) > 0)
+			levelCount++;
+
+		VkImageCreateInfo imageInfo{};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.format = VK_FORMAT_R32_SFLOAT;
+		imageInfo.extent = { extent.width, extent.height, 1 };
+		imageInfo.mipLevels = levelCount;
+		imageInfo.arrayLayers = 1;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		lveDevice.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, pyramid.image, pyramid.memory);
+
+		VkImageViewCreateInfo viewInfo{};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image = pyramid.image;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = VK_FORMAT_R32_SFLOAT;
+		viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		viewInfo.subresourceRange.baseMipLevel = 0;
+		viewInfo.subresourceRange.levelCount = levelCount;
+		viewInfo.subresourceRange.baseArrayLayer = 0;
+		viewInfo.subresourceRange.layerCount = 1;
+		if (vkCreateImageView(lveDevice.device(), &viewInfo, nullptr, &pyramid.view) != VK_SUCCESS)
+			throw std::runtime_error("failed to create depth pyramid image view!");
+
+		// storage images can only see one level at a time
+		pyramid.levelViews.resize(levelCount);
+		viewInfo.subresourceRange.levelCount = 1;
+		for (uint32_t level = 0; level < levelCount; level++) {
+			viewInfo.subresourceRange.baseMipLevel = level;
+			if (vkCreateImageView(lveDevice.device(), &viewInfo, nullptr, &pyramid.levelViews[level]) != VK_SUCCESS)
+				throw std::runtime_error("failed to create depth pyramid level view!");
+
+		} // for
+
+		pyramid.extent = extent;
+		pyramidNeedsLayout = true;
+
+		// its texels mean nothing until buildDepthPyramid fills it
+		pyramidReady = false;
+
+	} // createDepthPyramid
+
+	void LveGpuCulling::transitionNewPyramid(VkCommandBuffer commandBuffer) {
+		if (!pyramidNeedsLayout)
+			return;
+
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = pyramid.image;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.baseMipLevel = 0;
+		barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = 1;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		pyramidNeedsLayout = false;
+
+	} // transitionNewPyramid
+
+	void LveGpuCulling::destroyDepthPyramid(DepthPyramid& depthPyramid) {
+		for (VkImageView levelView : depthPyramid.levelViews)
+			vkDestroyImageView(lveDevice.device(), levelView, nullptr);
+
+		if (depthPyramid.view != VK_NULL_HANDLE)
+			vkDestroyImageView(lveDevice.device(), depthPyramid.view, nullptr);
+
+		if (depthPyramid.image != VK_NULL_HANDLE)
+			lveDevice.destroyImage(depthPyramid.image, depthPyramid.memory);
+
+		depthPyramid = DepthPyramid{};
+
+	} // destroyDepthPyramid
+
+	void LveGpuCulling::destroyRetiredPyramids() {
+		// a frame index comes around again once every frame in flight has had its turn, by then its fence has been waited on
+		const uint64_t framesInFlight = frames.size();
+		for (auto retired = retiredPyramids.begin(); retired != retiredPyramids.end();) {
+			if (frameCounter > retired->retiredAtFrame + framesInFlight) {
+				destroyDepthPyramid(*retired);
+				retired = retiredPyramids.erase(retired);
+
+			} else {
+				retired++;
+
+			} // else
+
+		} // for
+
+	} // destroyRetiredPyramids
+
+} // lve
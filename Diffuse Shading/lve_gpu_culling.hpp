@@ -0,0 +1,199 @@
+#pragma once
+
+#include "lve_device.hpp"
+#include "lve_camera.hpp"
+#include "lve_compute_pipeline.hpp"
+#include "lve_game_object.hpp"
+#include "lve_model.hpp"
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace lve {
+
+	// culls and picks LODs on the GPU (gpu_cull.comp), so with a scene of any size the CPU only records a handful of commands per frame
+	// setScene copies the objects' bounds and transforms into storage buffers once, every frame cull tests them against the
+	// frustum and a depth pyramid of the previous frame (hiz_downsample.comp), writes the survivors' instance data and compacts
+	// one draw command per (model, LOD) that kept any into an indirect buffer with a count per batch, which
+	// SimpleRenderSystem::renderGameObjectsGpuCulled draws with vkCmdDrawIndexedIndirectCountKHR
+	// occlusion uses last frame's depth and camera, so something that comes out from behind an object shows up a frame late
+	class LveGpuCulling {
+	public:
+		// a run of draw commands that share a pipeline and buffers, drawn with one indirect call
+		struct DrawBatch {
+			LveModel* model; // any model of the batch, they all bind the same buffers and have the same vertex format
+			uint32_t firstCommand; // in getDrawCommandBuffer
+			uint32_t maxCommandCount; // one per (model, LOD) in the batch, the count in getDrawCountBuffer says how many are used
+
+		}; // DrawBatch
+
+		explicit LveGpuCulling(LveDevice& device);
+		~LveGpuCulling();
+
+		LveGpuCulling(const LveGpuCulling&) = delete;
+		LveGpuCulling& operator=(const LveGpuCulling&) = delete;
+
+		// needs drawIndirectFirstInstance, every draw command starts at its own instances
+		static bool isSupported(LveDevice& device);
+		// nullptr if the device is not supported or the compute shaders cannot be loaded, the caller then culls on the CPU
+		static std::unique_ptr<LveGpuCulling> create(LveDevice& device);
+
+		// takes a copy of the objects' models and transforms, call it again once objects are added, removed or moved
+		// objects whose model is still loading are added by cull as soon as it is resident, models without indices are left out
+		void setScene(std::span<const LveGameObject> gameObjects);
+
+		// before the swap chain render pass, frameIndex is LveRenderer::getFrameIndex
+		void cull(VkCommandBuffer commandBuffer, uint32_t frameIndex, const LveCamera& camera);
+		// after endSwapChainRenderPass, builds next frame's depth pyramid out of the depth image the frame was drawn with
+		void buildDepthPyramid(VkCommandBuffer commandBuffer, uint32_t frameIndex, VkImageView depthImageView, VkExtent2D extent);
+
+		// what cull wrote for frameIndex, only valid in the frame that called it
+		const std::vector<DrawBatch>& getDrawBatches() const { return batches; } // getDrawBatches
+		VkBuffer getInstanceBuffer(uint32_t frameIndex) const { return frames[frameIndex].instances.buffer; } // getInstanceBuffer
+		VkBuffer getDrawCommandBuffer(uint32_t frameIndex) const { return frames[frameIndex].drawCommands.buffer; } // getDrawCommandBuffer
+		VkBuffer getDrawCountBuffer(uint32_t frameIndex) const { return frames[frameIndex].drawCounts.buffer; } // getDrawCountBuffer
+
+		size_t getObjectCount() const { return objectData.size(); } // getObjectCount
+
+	private:
+		static constexpr uint32_t MAX_PYRAMID_LEVELS = 16; // enough for a 32768 pixel wide depth image
+
+		// std430, matches gpu_cull.comp
+		struct ObjectData {
+			glm::mat4 modelMatrix;
+			glm::vec4 bounds; // model space sphere
+			uint32_t firstGroup;
+			uint32_t lodCount;
+			float maxScale;
+			uint32_t padding;
+
+		}; // ObjectData
+
+		struct GroupData {
+			glm::mat4 dequantize;
+			uint32_t indexCount;
+			uint32_t firstIndex;
+			int32_t vertexOffset;
+			uint32_t firstInstance;
+			uint32_t batch;
+			uint32_t firstCommand;
+			float lodError;
+			uint32_t padding;
+
+		}; // GroupData
+
+		// std140, matches the Camera block of gpu_cull.comp
+		struct CameraData {
+			glm::mat4 projectionView;
+			glm::mat4 view;
+			glm::mat4 pyramidProjectionView;
+			glm::vec4 planes[6];
+			glm::vec2 pyramidSize;
+			float projectionScale;
+			uint32_t orthographic;
+			uint32_t objectCount;
+			uint32_t groupCount;
+			uint32_t occlusion;
+			float lodErrorThreshold;
+
+		}; // CameraData
+
+		static_assert(sizeof(ObjectData) == 96 && sizeof(GroupData) == 96 && sizeof(CameraData) == 320, "the layouts have to match gpu_cull.comp");
+
+		struct SceneObject {
+			std::shared_ptr<LveModel> model;
+			glm::mat4 modelMatrix;
+
+		}; // SceneObject
+
+		struct FrameBuffer {
+			VkBuffer buffer = VK_NULL_HANDLE;
+			LveAllocation memory{};
+			VkDeviceSize capacity = 0; // in bytes
+
+		}; // FrameBuffer
+
+		// everything the GPU reads or writes for one frame index, so a frame never touches what the one before is still using
+		struct FrameResources {
+			FrameBuffer camera{}; // host visible
+			FrameBuffer objects{}; // host visible, rewritten when the scene changes
+			FrameBuffer groups{}; // host visible, rewritten when the scene changes
+			FrameBuffer groupCounts{};
+			FrameBuffer instances{};
+			FrameBuffer drawCommands{};
+			FrameBuffer drawCounts{};
+			uint64_t sceneVersion = 0; // of objects and groups
+
+			VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+			VkDescriptorSet cullSet = VK_NULL_HANDLE;
+			VkDescriptorSet pyramidSets[MAX_PYRAMID_LEVELS]{};
+
+		}; // FrameResources
+
+		// the depth pyramid, one R32_SFLOAT image with a mip chain that stays in GENERAL
+		struct DepthPyramid {
+			VkImage image = VK_NULL_HANDLE;
+			LveAllocation memory{};
+			VkImageView view = VK_NULL_HANDLE; // every level, for the sampler in gpu_cull.comp
+			std::vector<VkImageView> levelViews{}; // one level each, for the storage images in hiz_downsample.comp
+			VkExtent2D extent{};
+			uint64_t retiredAtFrame = 0;
+
+		}; // DepthPyramid
+
+		void createDescriptorSetLayouts();
+		void createPipelines();
+		void createSampler();
+
+		FrameResources& frameFor(uint32_t frameIndex);
+		void reserve(FrameBuffer& frameBuffer, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties);
+		void destroy(FrameBuffer& frameBuffer);
+
+		// builds objectData, groupData and batches out of sceneObjects
+		void rebuildScene();
+		void uploadScene(FrameResources& frame);
+		void writeCullSet(FrameResources& frame);
+
+		void createDepthPyramid(VkExtent2D extent);
+		// a new pyramid starts out in UNDEFINED, this moves it to GENERAL before its first use
+		void transitionNewPyramid(VkCommandBuffer commandBuffer);
+		void destroyDepthPyramid(DepthPyramid& depthPyramid);
+		void destroyRetiredPyramids();
+
+		LveDevice& lveDevice;
+
+		VkDescriptorSetLayout cullSetLayout = VK_NULL_HANDLE;
+		VkDescriptorSetLayout pyramidSetLayout = VK_NULL_HANDLE;
+		VkPipelineLayout cullPipelineLayout = VK_NULL_HANDLE;
+		VkPipelineLayout pyramidPipelineLayout = VK_NULL_HANDLE;
+		std::unique_ptr<LveComputePipeline> cullPipeline;
+		std::unique_ptr<LveComputePipeline> compactPipeline;
+		std::unique_ptr<LveComputePipeline> depthCopyPipeline; // level 0
+		std::unique_ptr<LveComputePipeline> downsamplePipeline; // every other level
+		VkSampler sampler = VK_NULL_HANDLE;
+
+		std::vector<SceneObject> sceneObjects{};
+		std::vector<LveModel*> pendingModels{}; // not resident yet at the last rebuild
+		std::vector<ObjectData> objectData{};
+		std::vector<GroupData> groupData{};
+		std::vector<DrawBatch> batches{};
+		uint32_t instanceCount = 0; // slots every group together needs
+		uint64_t sceneVersion = 1;
+
+		std::vector<FrameResources> frames{}; // by frame index, grown on demand
+
+		DepthPyramid pyramid{};
+		std::vector<DepthPyramid> retiredPyramids{}; // replaced after a resize, frames in flight may still sample them
+		bool pyramidReady = false; // built by the last frame, so the next cull can use it
+		bool pyramidNeedsLayout = false; // new image, still in UNDEFINED
+		glm::mat4 cullProjectionView{ 1.f }; // the camera of the frame being recorded
+		glm::mat4 pyramidProjectionView{ 1.f }; // the camera the pyramid was rendered with
+		uint64_t frameCounter = 0; // cull calls so far
+
+	}; // LveGpuCulling
+
+} // lve
@@ -0,0 +1,179 @@
+#include "lve_gpu_profiler.hpp"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace lve {
+
+	LveGpuProfiler::LveGpuProfiler(LveDevice& device, uint32_t maxScopes, size_t historySize)
+		: lveDevice{ device }, maxScopes{ maxScopes }, historySize{ std::max<size_t>(historySize, 1) } {
+		uint32_t familyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(lveDevice.getPhysicalDevice(), &familyCount, nullptr);
+		std::vector<VkQueueFamilyProperties> families(familyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(lveDevice.getPhysicalDevice(), &familyCount, families.data());
+
+		const uint32_t validBits = families[lveDevice.findPhysicalQueueFamilies().graphicsFamily].timestampValidBits;
+		supported = validBits > 0 && maxScopes > 0;
+		timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+		nanosecondsPerTick = lveDevice.properties.limits.timestampPeriod;
+
+	} // LveGpuProfiler
+
+	LveGpuProfiler::~LveGpuProfiler() {
+		for (auto& frame : frames) {
+			if (frame.pool != VK_NULL_HANDLE)
+				vkDestroyQueryPool(lveDevice.device(), frame.pool, nullptr);
+
+		} // for
+
+	} // ~LveGpuProfiler
+
+	void LveGpuProfiler::beginFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex) {
+		currentFrame = nullptr;
+		if (!supported)
+			return;
+
+		if (frames.size() <= frameIndex)
+			frames.resize(frameIndex + 1);
+
+		FramePool& frame = frames[frameIndex];
+		if (frame.pool == VK_NULL_HANDLE) {
+			VkQueryPoolCreateInfo poolInfo{};
+			poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+			poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+			poolInfo.queryCount = maxScopes * 2;
+
+			if (vkCreateQueryPool(lveDevice.device(), &poolInfo, nullptr, &frame.pool) != VK_SUCCESS)
+				throw std::runtime_error("failed to create timestamp query pool!");
+
+		} // if
+
+		resolve(frame);
+
+		vkCmdResetQueryPool(commandBuffer, frame.pool, 0, maxScopes * 2);
+		currentFrame = &frame;
+
+	} // beginFrame
+
+	uint32_t LveGpuProfiler::beginScope(VkCommandBuffer commandBuffer, const char* name) {
+		if (currentFrame == nullptr || currentFrame->scopes.size() >= maxScopes)
+			return INVALID_SCOPE;
+
+		const uint32_t scope = static_cast<uint32_t>(currentFrame->scopes.size());
+		currentFrame->scopes.push_back({ historyFor(name), scope * 2 });
+
+		// TOP_OF_PIPE writes once everything before it has started, BOTTOM_OF_PIPE in endScope once it has all finished
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, currentFrame->pool, scope * 2);
+		return scope;
+
+	} // beginScope
+
+	void LveGpuProfiler::endScope(VkCommandBuffer commandBuffer, uint32_t scope) {
+		if (currentFrame == nullptr || scope == INVALID_SCOPE)
+			return;
+
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, currentFrame->pool, currentFrame->scopes[scope].firstQuery + 1);
+
+	} // endScope
+
+	void LveGpuProfiler::resolve(FramePool& frame) {
+		if (frame.scopes.empty())
+			return;
+
+		// a timestamp and its availability for every query, a scope that was never closed just stays unavailable
+		const uint32_t queryCount = static_cast<uint32_t>(frame.scopes.size()) * 2;
+		std::vector<uint64_t> results(queryCount * 2);
+		const VkResult result = vkGetQueryPoolResults(
+			lveDevice.device(),
+			frame.pool,
+			0,
+			queryCount,
+			results.size() * sizeof(uint64_t),
+			results.data(),
+			sizeof(uint64_t) * 2,
+			VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+		if (result == VK_SUCCESS || result == VK_NOT_READY) {
+			for (const auto& scope : frame.scopes) {
+				const uint64_t* begin = &results[scope.firstQuery * 2];
+				const uint64_t* end = &results[(scope.firstQuery + 1) * 2];
+				if (begin[1] == 0 || end[1] == 0)
+					continue;
+
+				const uint64_t ticks = (end[0] - begin[0]) & timestampMask; // still right if the counter wrapped in between
+				History& history = histories[scope.history];
+				const double milliseconds = static_cast<double>(ticks) * nanosecondsPerTick / 1000000.0;
+				if (history.samples.size() < historySize) {
+					history.samples.push_back(milliseconds);
+
+				} else {
+
+					history.samples[history.next] = milliseconds;
+					history.next = (history.next + 1) % historySize;
+
+				} // else
+
+			} // for
+
+		} // if
+
+		frame.scopes.clear();
+
+	} // resolve
+
+	uint32_t LveGpuProfiler::historyFor(const char* name) {
+		auto entry = historyIndices.find(name);
+		if (entry != historyIndices.end())
+			return entry->second;
+
+		const uint32_t index = static_cast<uint32_t>(histories.size());
+		histories.push_back({ name });
+		historyIndices.emplace(name, index);
+		return index;
+
+	} // historyFor
+
+	LveGpuProfiler::Stats LveGpuProfiler::computeStats(const History& history) {
+		Stats stats{};
+		stats.samples = history.samples.size();
+		if (history.samples.empty())
+			return stats;
+
+		std::vector<double> sorted = history.samples;
+		std::sort(sorted.begin(), sorted.end());
+
+		double total = 0.0;
+		for (double sample : sorted)
+			total += sample;
+
+		// nearest rank, so with fewer than a hundred samples p99 is just the slowest one
+		const size_t p99Rank = static_cast<size_t>(std::ceil(0.99 * sorted.size()));
+		stats.minMs = sorted.front();
+		stats.avgMs = total / sorted.size();
+		stats.p99Ms = sorted[std::max<size_t>(p99Rank, 1) - 1];
+		return stats;
+
+	} // computeStats
+
+	LveGpuProfiler::Stats LveGpuProfiler::getStats(const std::string& name) const {
+		auto entry = historyIndices.find(name);
+		if (entry == historyIndices.end())
+			return {};
+
+		return computeStats(histories[entry->second]);
+
+	} // getStats
+
+	std::vector<std::pair<std::string, LveGpuProfiler::Stats>> LveGpuProfiler::getAllStats() const {
+		std::vector<std::pair<std::string, Stats>> allStats{};
+		allStats.reserve(histories.size());
+		for (const auto& history : histories)
+			allStats.emplace_back(history.name, computeStats(history));
+
+		return allStats;
+
+	} // getAllStats
+
+} // lve
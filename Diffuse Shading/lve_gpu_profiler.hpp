@@ -0,0 +1,115 @@
+#pragma once
+
+#include "lve_device.hpp"
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace lve {
+
+	// measures how long named parts of a frame take on the GPU with timestamp queries
+	// every frame index gets a query pool of its own, the results of a frame are read the next time its frame index
+	// comes around, by then its fence has signalled, so reading them never waits on the GPU
+	// scopes can nest and have to be closed in the command buffer they were opened in
+	class LveGpuProfiler {
+	public:
+		static constexpr uint32_t INVALID_SCOPE = UINT32_MAX;
+
+		// in milliseconds, over the last historySize frames the scope showed up in
+		struct Stats {
+			double minMs = 0.0;
+			double avgMs = 0.0;
+			double p99Ms = 0.0;
+			size_t samples = 0;
+
+		}; // Stats
+
+		// opens a scope for as long as it lives
+		class Scope {
+		public:
+			Scope(LveGpuProfiler& profiler, VkCommandBuffer commandBuffer, const char* name)
+				: profiler{ profiler }, commandBuffer{ commandBuffer }, scope{ profiler.beginScope(commandBuffer, name) } {
+
+			} // Scope
+
+			~Scope() { profiler.endScope(commandBuffer, scope); } // ~Scope
+
+			Scope(const Scope&) = delete;
+			Scope& operator=(const Scope&) = delete;
+
+		private:
+			LveGpuProfiler& profiler;
+			VkCommandBuffer commandBuffer;
+			uint32_t scope;
+
+		}; // Scope
+
+		// maxScopes is per frame, scopes past it are not measured
+		explicit LveGpuProfiler(LveDevice& device, uint32_t maxScopes = 64, size_t historySize = 240);
+		~LveGpuProfiler();
+
+		LveGpuProfiler(const LveGpuProfiler&) = delete;
+		LveGpuProfiler& operator=(const LveGpuProfiler&) = delete;
+
+		// false when the graphics queue has no timestamps, every call below then does nothing
+		bool isSupported() const { return supported; } // isSupported
+
+		// right after vkBeginCommandBuffer and only once the fence of the last frame with this index has signalled,
+		// reads that frame's results and resets its queries, so it has to be outside a render pass
+		void beginFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+
+		// returns INVALID_SCOPE when the frame is out of queries, endScope ignores it
+		uint32_t beginScope(VkCommandBuffer commandBuffer, const char* name);
+		void endScope(VkCommandBuffer commandBuffer, uint32_t scope);
+
+		// nothing measured yet gives empty stats
+		Stats getStats(const std::string& name) const;
+		// every scope seen so far, in the order they were first opened
+		std::vector<std::pair<std::string, Stats>> getAllStats() const;
+
+	private:
+		struct ScopeRecord {
+			uint32_t history; // index into histories
+			uint32_t firstQuery; // begin timestamp, the end one follows it
+
+		}; // ScopeRecord
+
+		struct FramePool {
+			VkQueryPool pool = VK_NULL_HANDLE;
+			std::vector<ScopeRecord> scopes{};
+
+		}; // FramePool
+
+		struct History {
+			std::string name;
+			std::vector<double> samples{}; // ring buffer of milliseconds
+			size_t next = 0;
+
+		}; // History
+
+		void resolve(FramePool& frame);
+		uint32_t historyFor(const char* name);
+		static Stats computeStats(const History& history);
+
+		LveDevice& lveDevice;
+		uint32_t maxScopes;
+		size_t historySize;
+
+		bool supported = false;
+		double nanosecondsPerTick = 1.0; // timestampPeriod
+		uint64_t timestampMask = ~0ull; // timestampValidBits, the bits above it are garbage
+
+		std::vector<FramePool> frames{}; // grows with the frame indices it is handed, so it follows a frames in flight change
+		FramePool* currentFrame = nullptr;
+
+		std::vector<History> histories{};
+		std::unordered_map<std::string, uint32_t> historyIndices{};
+
+	}; // LveGpuProfiler
+
+} // lve
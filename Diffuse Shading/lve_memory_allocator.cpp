@@ -0,0 +1,213 @@
+#include "lve_memory_allocator.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <stdexcept>
+
+namespace lve {
+
+	namespace {
+
+		VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+			return (value + alignment - 1) / alignment * alignment;
+
+		} // alignUp
+
+	} // namespace
+
+	LveMemoryAllocator::Backend LveMemoryAllocator::vulkanBackend(VkDevice device) {
+		Backend backend{};
+		backend.allocateMemory = [device](uint32_t memoryType, VkDeviceSize size, VkDeviceMemory& memory) {
+			VkMemoryAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+			allocInfo.allocationSize = size;
+			allocInfo.memoryTypeIndex = memoryType;
+			return vkAllocateMemory(device, &allocInfo, nullptr, &memory);
+
+		}; // allocateMemory
+
+		backend.freeMemory = [device](VkDeviceMemory memory) {
+			vkFreeMemory(device, memory, nullptr);
+
+		}; // freeMemory
+
+		backend.mapMemory = [device](VkDeviceMemory memory) {
+			void* mapped = nullptr;
+			if (vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, &mapped) != VK_SUCCESS)
+				throw std::runtime_error("failed to map memory block!");
+
+			return mapped;
+
+		}; // mapMemory
+
+		return backend;
+
+	} // vulkanBackend
+
+	LveMemoryAllocator::LveMemoryAllocator(const VkPhysicalDeviceMemoryProperties& memoryProperties, Backend backend, VkDeviceSize preferredBlockSize)
+		: memoryProperties{ memoryProperties }, backend{ std::move(backend) }, preferredBlockSize{ preferredBlockSize } {
+		pools.resize(memoryProperties.memoryTypeCount * 2);
+
+	} // LveMemoryAllocator
+
+	LveMemoryAllocator::~LveMemoryAllocator() {
+		assert(stats.allocationCount == 0 && "Every allocation must be freed before the allocator");
+		for (auto& pool : pools) {
+			for (auto& block : pool)
+				backend.freeMemory(block->memory);
+
+		} // for
+
+	} // ~LveMemoryAllocator
+
+	uint32_t LveMemoryAllocator::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const {
+		for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+			if ((typeFilter & (1 << i)) && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+				return i;
+
+		} // for
+
+		throw std::runtime_error("failed to find suitable memory type!");
+
+	} // findMemoryType
+
+	VkDeviceSize LveMemoryAllocator::blockSizeFor(uint32_t memoryType) const {
+		// on small heaps (integrated GPUs, the 256 MB BAR window) a full size block would be a big bite of the whole heap
+		const VkDeviceSize heapSize = memoryProperties.memoryHeaps[memoryProperties.memoryTypes[memoryType].heapIndex].size;
+		if (heapSize <= 1024ull * 1024 * 1024)
+			return std::min(preferredBlockSize, alignUp(heapSize / 8, 1024 * 1024));
+
+		return preferredBlockSize;
+
+	} // blockSizeFor
+
+	void* LveMemoryAllocator::mapIfHostVisible(uint32_t memoryType, VkDeviceMemory memory) {
+		if ((memoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) == 0)
+			return nullptr;
+
+		return backend.mapMemory(memory);
+
+	} // mapIfHostVisible
+
+	LveAllocation LveMemoryAllocator::allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, bool linear) {
+		const uint32_t memoryType = findMemoryType(requirements.memoryTypeBits, properties);
+		const VkDeviceSize alignment = std::max<VkDeviceSize>(requirements.alignment, 1);
+		const VkDeviceSize blockSize = blockSizeFor(memoryType);
+
+		std::lock_guard<std::mutex> lock{ mutex };
+
+		LveAllocation allocation{};
+		allocation.size = requirements.size;
+		allocation.memoryType = memoryType;
+
+		// huge resources would leave most of a block unusable, they get device memory of their own
+		if (requirements.size > blockSize / 2) {
+			if (backend.allocateMemory(memoryType, requirements.size, allocation.memory) != VK_SUCCESS)
+				throw std::runtime_error("failed to allocate dedicated memory!");
+
+			allocation.mapped = mapIfHostVisible(memoryType, allocation.memory);
+			allocation.rangeSize = requirements.size;
+			stats.dedicatedCount++;
+			stats.dedicatedBytes += requirements.size;
+			stats.allocationCount++;
+			return allocation;
+
+		} // if
+
+		// rounding the size up keeps every free range starting on an aligned offset for the common alignments
+		const VkDeviceSize rangeSize = alignUp(requirements.size, alignment);
+		Pool& pool = poolFor(memoryType, linear);
+
+		LveMemoryBlock* bestBlock = nullptr;
+		VkDeviceSize offset = LveRangeAllocator::INVALID_OFFSET;
+		for (auto& block : pool) {
+			offset = block->ranges.allocate(rangeSize, alignment);
+			if (offset != LveRangeAllocator::INVALID_OFFSET) {
+				bestBlock = block.get();
+				break;
+
+			} // if
+
+		} // for
+
+		if (bestBlock == nullptr) {
+			auto block = std::make_unique<LveMemoryBlock>();
+			block->size = blockSize;
+			block->memoryType = memoryType;
+			block->linear = linear;
+			if (backend.allocateMemory(memoryType, blockSize, block->memory) != VK_SUCCESS)
+				throw std::runtime_error("failed to allocate memory block!");
+
+			block->mapped = mapIfHostVisible(memoryType, block->memory);
+			block->ranges = LveRangeAllocator{ blockSize };
+			offset = block->ranges.allocate(rangeSize, alignment);
+			bestBlock = block.get();
+			pool.push_back(std::move(block));
+			stats.blockCount++;
+			stats.blockBytes += blockSize;
+
+		} // if
+
+		bestBlock->allocationCount++;
+
+		allocation.memory = bestBlock->memory;
+		allocation.offset = offset;
+		allocation.mapped = bestBlock->mapped != nullptr ? static_cast<std::byte*>(bestBlock->mapped) + offset : nullptr;
+		allocation.block = bestBlock;
+		allocation.rangeOffset = offset;
+		allocation.rangeSize = rangeSize;
+
+		stats.allocationCount++;
+		stats.usedBytes += requirements.size;
+		stats.wastedBytes += rangeSize - requirements.size;
+		return allocation;
+
+	} // allocate
+
+	void LveMemoryAllocator::free(const LveAllocation& allocation) {
+		if (allocation.memory == VK_NULL_HANDLE)
+			return;
+
+		std::lock_guard<std::mutex> lock{ mutex };
+		stats.allocationCount--;
+
+		if (allocation.block == nullptr) {
+			backend.freeMemory(allocation.memory);
+			stats.dedicatedCount--;
+			stats.dedicatedBytes -= allocation.size;
+			return;
+
+		} // if
+
+		stats.usedBytes -= allocation.size;
+		stats.wastedBytes -= allocation.rangeSize - allocation.size;
+
+		LveMemoryBlock* block = allocation.block;
+		block->ranges.free(allocation.rangeOffset, allocation.rangeSize);
+		block->allocationCount--;
+
+		if (block->allocationCount > 0)
+			return;
+
+		// keep one empty block per pool around, so a resource that is freed and recreated every frame does not hit the driver each time
+		Pool& pool = poolFor(block->memoryType, block->linear);
+		const bool anotherEmpty = std::any_of(pool.begin(), pool.end(), [block](const auto& other) { return other.get() != block && other->allocationCount == 0; });
+		if (!anotherEmpty)
+			return;
+
+		backend.freeMemory(block->memory);
+		stats.blockCount--;
+		stats.blockBytes -= block->size;
+		pool.erase(std::find_if(pool.begin(), pool.end(), [block](const auto& other) { return other.get() == block; }));
+
+	} // free
+
+	LveMemoryAllocator::Stats LveMemoryAllocator::getStats() const {
+		std::lock_guard<std::mutex> lock{ mutex };
+		return stats;
+
+	} // getStats
+
+} // lve
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "lve_range_allocator.hpp"
+
+// libs
+#include <vulkan/vulkan.h>
+
+// std
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace lve {
+
+	struct LveMemoryBlock;
+
+	// a range of device memory handed out by LveMemoryAllocator, bind the resource at memory + offset
+	struct LveAllocation {
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkDeviceSize offset = 0;
+		VkDeviceSize size = 0;
+		void* mapped = nullptr; // already offset, only set for host visible memory, which stays mapped for its whole life
+		uint32_t memoryType = 0;
+
+		// where it came from, nullptr for a dedicated allocation
+		LveMemoryBlock* block = nullptr;
+		VkDeviceSize rangeOffset = 0; // the reserved range, offset and size grown to the alignment
+		VkDeviceSize rangeSize = 0;
+
+	}; // LveAllocation
+
+	// one vkAllocateMemory for many resources
+	// every memory type gets its own list of large blocks, resources are placed inside them with an LveRangeAllocator
+	// and anything bigger than half a block gets a dedicated allocation of its own
+	// drivers only allow a few thousand allocations in total (maxMemoryAllocationCount), this keeps us far from that
+	class LveMemoryAllocator {
+	public:
+		static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64ull * 1024 * 1024;
+
+		// the parts that talk to the driver, so the sub-allocation logic can run against a made up memory type table
+		// with fake handles and no GPU at all
+		struct Backend {
+			std::function<VkResult(uint32_t memoryType, VkDeviceSize size, VkDeviceMemory& memory)> allocateMemory;
+			std::function<void(VkDeviceMemory memory)> freeMemory;
+			std::function<void*(VkDeviceMemory memory)> mapMemory; // maps the whole allocation, only called for host visible types
+
+		}; // Backend
+
+		struct Stats {
+			uint32_t blockCount = 0;
+			uint32_t dedicatedCount = 0;
+			uint32_t allocationCount = 0; // live resources, in blocks or dedicated
+			VkDeviceSize blockBytes = 0; // device memory held by blocks
+			VkDeviceSize dedicatedBytes = 0;
+			VkDeviceSize usedBytes = 0; // what the resources asked for, in blocks
+			VkDeviceSize wastedBytes = 0; // lost to rounding sizes up to their alignment, in blocks
+
+		}; // Stats
+
+		static Backend vulkanBackend(VkDevice device);
+
+		LveMemoryAllocator(const VkPhysicalDeviceMemoryProperties& memoryProperties, Backend backend, VkDeviceSize preferredBlockSize = DEFAULT_BLOCK_SIZE);
+
+		// every allocation has to be freed by now, blocks still in use are released anyway
+		~LveMemoryAllocator();
+
+		LveMemoryAllocator(const LveMemoryAllocator&) = delete;
+		LveMemoryAllocator& operator=(const LveMemoryAllocator&) = delete;
+
+		// linear is true for buffers and linear images, false for optimal tiling images
+		// the two never share a block, which keeps us clear of bufferImageGranularity without having to track neighbours
+		// throws if no memory type matches or the driver is out of memory
+		LveAllocation allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, bool linear);
+		void free(const LveAllocation& allocation);
+
+		uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+
+		Stats getStats() const;
+
+	private:
+		using Pool = std::vector<std::unique_ptr<LveMemoryBlock>>;
+
+		Pool& poolFor(uint32_t memoryType, bool linear) { return pools[memoryType * 2 + (linear ? 0 : 1)]; } // poolFor
+		VkDeviceSize blockSizeFor(uint32_t memoryType) const;
+		void* mapIfHostVisible(uint32_t memoryType, VkDeviceMemory memory);
+
+		VkPhysicalDeviceMemoryProperties memoryProperties;
+		Backend backend;
+		VkDeviceSize preferredBlockSize;
+
+		mutable std::mutex mutex; // models are loaded on worker threads, so allocations come from more than one thread
+		std::vector<Pool> pools{};
+		Stats stats{};
+
+	}; // LveMemoryAllocator
+
+	struct LveMemoryBlock {
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkDeviceSize size = 0;
+		void* mapped = nullptr;
+		uint32_t memoryType = 0;
+		bool linear = true;
+		uint32_t allocationCount = 0;
+		LveRangeAllocator ranges{};
+
+	}; // LveMemoryBlock
+
+} // lve
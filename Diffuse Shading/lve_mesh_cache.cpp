@@ -0,0 +1,196 @@
+#include "lve_mesh_cache.hpp"
+
+// std
+#include <algorithm>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+
+namespace lve {
+
+	// we memcpy vertices in and out of the file, so they must not contain anything that is not plain data
+	static_assert(std::is_trivially_copyable_v<LveModel::Vertex>, "Vertex must be trivially copyable to be cached");
+	static_assert(std::is_trivially_copyable_v<LveModel::PackedVertex>, "PackedVertex must be trivially copyable to be cached");
+	static_assert(std::is_trivially_copyable_v<LveModel::Lod>, "Lod must be trivially copyable to be cached");
+	static_assert(sizeof(LveModel::Lod) == 12, "Lod layout is part of the file format");
+	static_assert(sizeof(LveMeshCache::Header) == 128, "Header layout is part of the file format");
+
+	uint64_t LveMeshCache::hashFile(const std::string& filepath) {
+		LveFileMapping source{};
+		if (!source.map(filepath))
+			throw std::runtime_error("failed to open file: " + filepath);
+
+		uint64_t hash = 0xcbf29ce484222325ull; // FNV offset basis
+		const std::byte* bytes = source.data();
+		for (size_t i = 0; i < source.size(); i++) {
+			hash ^= static_cast<uint64_t>(bytes[i]);
+			hash *= 0x100000001b3ull; // FNV prime
+
+		} // for
+
+		return hash;
+
+	} // hashFile
+
+	LveMeshCache::SourceStamp LveMeshCache::stampFile(const std::string& filepath) {
+		std::error_code error{};
+		SourceStamp stamp{};
+		stamp.size = static_cast<uint64_t>(std::filesystem::file_size(filepath, error));
+		if (!error)
+			stamp.writeTime = static_cast<int64_t>(std::filesystem::last_write_time(filepath, error).time_since_epoch().count());
+
+		if (error)
+			throw std::runtime_error("failed to open file: " + filepath);
+
+		return stamp;
+
+	} // stampFile
+
+	uint32_t LveMeshCache::importFlagsFor(const LveModel::ImportOptions& options) {
+		// the weld method is not in here on purpose, every method produces the same vertices and indices
+		uint32_t flags = 0;
+		if (options.optimizeVertexCache)
+			flags |= IMPORT_OPTIMIZE_VERTEX_CACHE;
+
+		if (options.vertexFormat == LveModel::VertexFormat::Packed)
+			flags |= IMPORT_PACK_VERTICES;
+
+		if (options.maxLodCount > 1)
+			flags |= IMPORT_GENERATE_LODS | (std::min(options.maxLodCount, 255u) << IMPORT_LOD_COUNT_SHIFT);
+
+		return flags;
+
+	} // importFlagsFor
+
+	bool LveMeshCache::write(
+		const std::string& cachePath,
+		const SourceStamp& sourceStamp,
+		uint64_t sourceHash,
+		uint32_t importFlags,
+		const LveModel::Builder& builder) {
+
+		const bool packed = !builder.packedVertices.empty();
+		if (packed != ((importFlags & IMPORT_PACK_VERTICES) != 0))
+			return false; // the flags would lie about the payload
+
+		std::span<const std::byte> vertexBytes = packed ? std::as_bytes(std::span{ builder.packedVertices }) : std::as_bytes(std::span{ builder.vertices });
+
+		Header header{};
+		header.magic = MAGIC;
+		header.version = VERSION;
+		header.sourceHash = sourceHash;
+		header.sourceSize = sourceStamp.size;
+		header.sourceWriteTime = sourceStamp.writeTime;
+		header.importFlags = importFlags;
+		header.vertexStride = static_cast<uint32_t>(packed ? sizeof(LveModel::PackedVertex) : sizeof(LveModel::Vertex));
+		header.vertexCount = static_cast<uint32_t>(packed ? builder.packedVertices.size() : builder.vertices.size());
+		header.indexCount = static_cast<uint32_t>(builder.indices.size());
+		header.lodCount = static_cast<uint32_t>(builder.lods.size());
+		for (int axis = 0; axis < 3; axis++) {
+			header.quantizationOffset[axis] = builder.quantization.offset[axis];
+			header.quantizationScale[axis] = builder.quantization.scale[axis];
+			header.boundsMin[axis] = builder.bounds.min[axis];
+			header.boundsMax[axis] = builder.bounds.max[axis];
+			header.boundsCenter[axis] = builder.bounds.center[axis];
+
+		} // for
+
+		header.boundsRadius = builder.bounds.radius;
+
+		const std::string tempPath = cachePath + ".tmp";
+
+		{
+			std::ofstream file{ tempPath, std::ios::binary | std::ios::trunc };
+			if (!file.is_open())
+				return false;
+
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			file.write(reinterpret_cast<const char*>(vertexBytes.data()), vertexBytes.size_bytes());
+			file.write(reinterpret_cast<const char*>(builder.indices.data()), builder.indices.size() * sizeof(uint32_t));
+			file.write(reinterpret_cast<const char*>(builder.lods.data()), builder.lods.size() * sizeof(LveModel::Lod));
+
+			if (!file.good())
+				return false;
+
+		} // file is flushed and closed here
+
+		std::error_code error{};
+		std::filesystem::rename(tempPath, cachePath, error);
+		if (error) {
+			// on windows this fails if another process still has the old cache mapped, the next run will try again
+			std::filesystem::remove(tempPath, error);
+			return false;
+
+		} // if
+
+		return true;
+
+	} // write
+
+	std::unique_ptr<LveMeshCache> LveMeshCache::open(const std::string& cachePath, const std::string& sourcePath, const SourceStamp& sourceStamp, uint32_t importFlags) {
+		std::unique_ptr<LveMeshCache> cache{ new LveMeshCache() };
+		if (!cache->mapping.map(cachePath) || cache->mapping.size() < sizeof(Header))
+			return nullptr;
+
+		const auto* header = reinterpret_cast<const Header*>(cache->mapping.data());
+		const bool packed = (importFlags & IMPORT_PACK_VERTICES) != 0;
+		const size_t vertexStride = packed ? sizeof(LveModel::PackedVertex) : sizeof(LveModel::Vertex);
+		if (header->magic != MAGIC || header->version != VERSION || header->importFlags != importFlags || header->vertexStride != vertexStride)
+			return nullptr;
+
+		// reading the whole source is what the cache is there to avoid, so only when a stat says it may have changed
+		if (header->sourceSize != sourceStamp.size || header->sourceWriteTime != sourceStamp.writeTime) {
+			if (header->sourceSize != sourceStamp.size || header->sourceHash != hashFile(sourcePath))
+				return nullptr;
+
+			cache->rehashed = true;
+
+		} // if
+
+		const size_t vertexBytes = static_cast<size_t>(header->vertexCount) * vertexStride;
+		const size_t indexBytes = static_cast<size_t>(header->indexCount) * sizeof(uint32_t);
+		const size_t lodBytes = static_cast<size_t>(header->lodCount) * sizeof(LveModel::Lod);
+		if (cache->mapping.size() != sizeof(Header) + vertexBytes + indexBytes + lodBytes)
+			return nullptr; // truncated or padded, either way we do not trust it
+
+		// the header is 128 bytes and both vertex layouts are a multiple of 4, so every array is suitably aligned inside the page aligned mapping
+		const std::byte* payload = cache->mapping.data() + sizeof(Header);
+		if (packed)
+			cache->packedVertices_ = { reinterpret_cast<const LveModel::PackedVertex*>(payload), header->vertexCount };
+		else
+			cache->vertices_ = { reinterpret_cast<const LveModel::Vertex*>(payload), header->vertexCount };
+
+		cache->indices_ = { reinterpret_cast<const uint32_t*>(payload + vertexBytes), header->indexCount };
+		cache->lods_ = { reinterpret_cast<const LveModel::Lod*>(payload + vertexBytes + indexBytes), header->lodCount };
+		for (const auto& lod : cache->lods_) {
+			if (static_cast<uint64_t>(lod.firstIndex) + lod.indexCount > header->indexCount)
+				return nullptr; // a LOD range outside the index buffer would draw garbage
+
+		} // for
+
+		cache->quantization_.offset = { header->quantizationOffset[0], header->quantizationOffset[1], header->quantizationOffset[2] };
+		cache->quantization_.scale = { header->quantizationScale[0], header->quantizationScale[1], header->quantizationScale[2] };
+		cache->bounds_.min = { header->boundsMin[0], header->boundsMin[1], header->boundsMin[2] };
+		cache->bounds_.max = { header->boundsMax[0], header->boundsMax[1], header->boundsMax[2] };
+		cache->bounds_.center = { header->boundsCenter[0], header->boundsCenter[1], header->boundsCenter[2] };
+		cache->bounds_.radius = header->boundsRadius;
+		return cache;
+
+	} // open
+
+	bool LveMeshCache::refreshStamp(const std::string& cachePath, const SourceStamp& sourceStamp) {
+		std::fstream file{ cachePath, std::ios::binary | std::ios::in | std::ios::out };
+		if (!file.is_open())
+			return false;
+
+		// size and write time sit next to each other in the header
+		file.seekp(offsetof(Header, sourceSize));
+		file.write(reinterpret_cast<const char*>(&sourceStamp.size), sizeof(sourceStamp.size));
+		file.write(reinterpret_cast<const char*>(&sourceStamp.writeTime), sizeof(sourceStamp.writeTime));
+		return file.good();
+
+	} // refreshStamp
+
+} // lve
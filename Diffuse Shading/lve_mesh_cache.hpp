@@ -0,0 +1,120 @@
+#pragma once
+
+#include "lve_model.hpp"
+#include "lve_file_mapping.hpp"
+
+// std
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+
+namespace lve {
+
+	// binary copy of a loaded mesh that sits next to its obj file
+	// the layout is exactly what we upload to the GPU, so a valid cache file skips parsing and dedup completely:
+	// [Header][Vertex or PackedVertex * vertexCount][uint32_t * indexCount][Lod * lodCount]
+	class LveMeshCache {
+	public:
+		static constexpr uint32_t MAGIC = 0x4D45564C; // "LVEM" in little endian
+		static constexpr uint32_t VERSION = 5;
+
+		struct Header {
+			uint32_t magic;
+			uint32_t version;
+			uint64_t sourceHash; // hash of the obj file bytes, a different file means a stale cache
+			uint64_t sourceSize; // size and write time of the obj file, when both still match the hash is not needed
+			int64_t sourceWriteTime;
+			uint32_t importFlags; // import options that change the produced geometry, see ImportFlags
+			uint32_t vertexStride; // sizeof(Vertex) or sizeof(PackedVertex) at the time of writing, guards against layout changes
+			uint32_t vertexCount;
+			uint32_t indexCount;
+			float quantizationOffset[3]; // only meaningful for packed vertices
+			float quantizationScale[3];
+			uint32_t lodCount; // 0 for caches written without a LOD chain
+			float boundsMin[3]; // the builder's bounds, so a cached mesh culls and picks LODs exactly like a freshly built one
+			float boundsMax[3];
+			float boundsCenter[3];
+			float boundsRadius;
+			uint32_t reserved[3]; // keeps the header at 128 bytes, a multiple of 16 so the arrays after it stay aligned
+
+		}; // Header
+
+		// only options that change the output go in here, a cache built with different ones is treated as stale
+		enum ImportFlags : uint32_t {
+			IMPORT_OPTIMIZE_VERTEX_CACHE = 1 << 0,
+			IMPORT_PACK_VERTICES = 1 << 1,
+			IMPORT_GENERATE_LODS = 1 << 2,
+			IMPORT_LOD_COUNT_SHIFT = 8, // the requested maximum LOD count lives in bits 8 to 15
+
+		}; // ImportFlags
+
+		static uint32_t importFlagsFor(const LveModel::ImportOptions& options);
+
+		// what a stat of the source says about it, cheap compared to reading the whole file
+		struct SourceStamp {
+			uint64_t size = 0;
+			int64_t writeTime = 0; // std::filesystem::last_write_time in the clock's own ticks
+
+		}; // SourceStamp
+
+		static std::string cachePathFor(const std::string& sourcePath) { return sourcePath + ".lvemesh"; } // cachePathFor
+
+		// 64 bit FNV-1a over the whole file, throws if the file cannot be opened
+		static uint64_t hashFile(const std::string& filepath);
+		// throws if the file does not exist
+		static SourceStamp stampFile(const std::string& filepath);
+
+		// writes to a temporary file first and then renames it, so a crash never leaves a half written cache behind
+		// stores builder.packedVertices if there are any, builder.vertices otherwise
+		static bool write(
+			const std::string& cachePath,
+			const SourceStamp& sourceStamp,
+			uint64_t sourceHash,
+			uint32_t importFlags,
+			const LveModel::Builder& builder);
+
+		// returns nullptr if the file is missing, from an older version or was built from a different source or with different flags
+		// the source is only hashed when its stamp differs from the one in the header, a touched but unchanged file still hits
+		static std::unique_ptr<LveMeshCache> open(const std::string& cachePath, const std::string& sourcePath, const SourceStamp& sourceStamp, uint32_t importFlags);
+
+		// rewrites just the stamp in the header, so the open after a rehash does not hash again
+		// the cache must not be open anywhere, windows does not let us write a mapped file
+		static bool refreshStamp(const std::string& cachePath, const SourceStamp& sourceStamp);
+
+		LveMeshCache(const LveMeshCache&) = delete;
+		LveMeshCache& operator=(const LveMeshCache&) = delete;
+
+		// open had to hash the source to trust this cache, its stamp is stale
+		bool wasRehashed() const { return rehashed; } // wasRehashed
+
+		bool isPacked() const { return !packedVertices_.empty(); } // isPacked
+		size_t vertexCount() const { return isPacked() ? packedVertices_.size() : vertices_.size(); } // vertexCount
+
+		// the spans point straight into the mapped file and are only valid while this object is alive
+		// only one of vertices and packedVertices is filled, depending on how the cache was written
+		std::span<const LveModel::Vertex> vertices() const { return vertices_; } // vertices
+		std::span<const LveModel::PackedVertex> packedVertices() const { return packedVertices_; } // packedVertices
+		std::span<const uint32_t> indices() const { return indices_; } // indices
+		const LveModel::Quantization& quantization() const { return quantization_; } // quantization
+		const LveModel::Bounds& bounds() const { return bounds_; } // bounds
+		std::span<const LveModel::Lod> lods() const { return lods_; } // lods
+
+		// whichever of the two vertex arrays is filled, as raw bytes for uploads
+		std::span<const std::byte> vertexData() const { return isPacked() ? std::as_bytes(packedVertices_) : std::as_bytes(vertices_); } // vertexData
+
+	private:
+		LveMeshCache() = default;
+
+		LveFileMapping mapping;
+		std::span<const LveModel::Vertex> vertices_{};
+		std::span<const LveModel::PackedVertex> packedVertices_{};
+		std::span<const uint32_t> indices_{};
+		std::span<const LveModel::Lod> lods_{};
+		LveModel::Quantization quantization_{};
+		LveModel::Bounds bounds_{};
+		bool rehashed = false;
+
+	}; // LveMeshCache
+
+} // lve
@@ -0,0 +1,168 @@
+#include "lve_mesh_optimizer.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+namespace lve {
+
+	LveModel::VertexCacheStats LveMeshOptimizer::analyzeVertexCache(std::span<const uint32_t> indices, size_t vertexCount, uint32_t cacheSize) {
+		assert(indices.size() % 3 == 0 && "Index count must be a multiple of 3");
+
+		LveModel::VertexCacheStats stats{};
+		if (indices.empty() || vertexCount == 0)
+			return stats;
+
+		// a vertex is in a FIFO of size N if fewer than N misses happened since it was last inserted
+		// so instead of a real queue we stamp every insertion with the running miss count
+		std::vector<uint32_t> insertedAt(vertexCount, 0);
+		uint32_t misses = 0;
+		for (uint32_t index : indices) {
+			assert(index < vertexCount && "Index out of range");
+			if (insertedAt[index] == 0 || misses + 1 - insertedAt[index] > cacheSize) {
+				misses++;
+				insertedAt[index] = misses; // 0 is reserved for never seen
+
+			} // if
+
+		} // for
+
+		stats.acmr = static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+		stats.atvr = static_cast<float>(misses) / static_cast<float>(vertexCount);
+		return stats;
+
+	} // analyzeVertexCache
+
+	void LveMeshOptimizer::optimizeVertexCache(std::span<uint32_t> indices, size_t vertexCount, uint32_t cacheSize) {
+		assert(indices.size() % 3 == 0 && "Index count must be a multiple of 3");
+
+		const size_t triangleCount = indices.size() / 3;
+		if (triangleCount == 0)
+			return;
+
+		// vertex -> triangle adjacency, one flat array with per vertex offsets
+		std::vector<uint32_t> liveTriangles(vertexCount, 0);
+		for (uint32_t index : indices)
+			liveTriangles[index]++;
+
+		std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+		for (size_t v = 0; v < vertexCount; v++)
+			adjacencyOffsets[v + 1] = adjacencyOffsets[v] + liveTriangles[v];
+
+		std::vector<uint32_t> adjacency(indices.size());
+		{
+			std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (size_t i = 0; i < indices.size(); i++)
+				adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+
+		} // fill is only needed while building
+
+		std::vector<uint32_t> cacheTime(vertexCount, 0);
+		std::vector<bool> emitted(triangleCount, false);
+		std::vector<uint32_t> deadEnd{}; // recently touched vertices, the cheapest place to restart when a fan runs dry
+		std::vector<uint32_t> candidates{};
+		std::vector<uint32_t> output{};
+		output.reserve(indices.size());
+
+		uint32_t timestamp = cacheSize + 1;
+		uint32_t cursor = 0; // next vertex to try when even the dead end stack is empty
+		const uint32_t NO_VERTEX = std::numeric_limits<uint32_t>::max();
+		uint32_t fanning = indices[0];
+
+		while (fanning != NO_VERTEX) {
+			candidates.clear();
+
+			// emit every triangle still around the fanning vertex
+			for (uint32_t a = adjacencyOffsets[fanning]; a < adjacencyOffsets[fanning + 1]; a++) {
+				const uint32_t triangle = adjacency[a];
+				if (emitted[triangle])
+					continue;
+
+				for (uint32_t corner = 0; corner < 3; corner++) {
+					const uint32_t v = indices[triangle * 3 + corner];
+					output.push_back(v);
+					deadEnd.push_back(v);
+					candidates.push_back(v);
+					liveTriangles[v]--;
+
+					if (timestamp - cacheTime[v] > cacheSize)
+						cacheTime[v] = timestamp++;
+
+				} // for
+
+				emitted[triangle] = true;
+
+			} // for
+
+			// next fan: the candidate that has been in the cache the longest but will still be in it after its remaining triangles
+			fanning = NO_VERTEX;
+			int64_t bestPriority = -1;
+			for (uint32_t v : candidates) {
+				if (liveTriangles[v] == 0)
+					continue;
+
+				int64_t priority = 0;
+				if (timestamp - cacheTime[v] + 2 * liveTriangles[v] <= cacheSize)
+					priority = timestamp - cacheTime[v];
+
+				if (priority > bestPriority) {
+					bestPriority = priority;
+					fanning = v;
+
+				} // if
+
+			} // for
+
+			if (fanning != NO_VERTEX)
+				continue;
+
+			// dead end, back off to something we touched recently and failing that to the next vertex with work left
+			while (!deadEnd.empty()) {
+				const uint32_t v = deadEnd.back();
+				deadEnd.pop_back();
+				if (liveTriangles[v] > 0) {
+					fanning = v;
+					break;
+
+				} // if
+
+			} // while
+
+			while (fanning == NO_VERTEX && cursor < vertexCount) {
+				if (liveTriangles[cursor] > 0)
+					fanning = cursor;
+
+				cursor++;
+
+			} // while
+
+		} // while
+
+		assert(output.size() == indices.size() && "Every triangle must be emitted exactly once");
+		std::copy(output.begin(), output.end(), indices.begin());
+
+	} // optimizeVertexCache
+
+	void LveMeshOptimizer::optimizeVertexFetch(std::vector<LveModel::Vertex>& vertices, std::span<uint32_t> indices) {
+		const uint32_t UNUSED = std::numeric_limits<uint32_t>::max();
+		std::vector<uint32_t> remap(vertices.size(), UNUSED);
+		std::vector<LveModel::Vertex> reordered{};
+		reordered.reserve(vertices.size());
+
+		for (uint32_t& index : indices) {
+			if (remap[index] == UNUSED) {
+				remap[index] = static_cast<uint32_t>(reordered.size());
+				reordered.push_back(vertices[index]);
+
+			} // if
+
+			index = remap[index];
+
+		} // for
+
+		vertices.swap(reordered);
+
+	} // optimizeVertexFetch
+
+} // lve
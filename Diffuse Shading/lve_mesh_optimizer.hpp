@@ -0,0 +1,33 @@
+#pragma once
+
+#include "lve_model.hpp"
+
+// std
+#include <span>
+#include <vector>
+
+namespace lve {
+
+	// index and vertex reordering so the GPU does less vertex shading and fetching for the same triangles
+	class LveMeshOptimizer {
+	public:
+		// most GPUs reuse shaded vertices from a small FIFO, 16 is a safe guess across vendors
+		static constexpr uint32_t DEFAULT_CACHE_SIZE = 16;
+
+		// simulates a FIFO post-transform cache over the index buffer
+		// ACMR = shaded vertices per triangle (0.5 is the ideal for big regular grids, 3 is no reuse at all)
+		// ATVR = shaded vertices per unique vertex (1 is the ideal)
+		static LveModel::VertexCacheStats analyzeVertexCache(std::span<const uint32_t> indices, size_t vertexCount, uint32_t cacheSize = DEFAULT_CACHE_SIZE);
+
+		// Tipsify (Sander, Nehab and Barczak 2007): fans around a vertex until it is done or about to fall out of the cache,
+		// then continues from whichever recently used vertex still has triangles left, linear in the triangle count
+		// triangles keep their winding, only their order changes
+		static void optimizeVertexCache(std::span<uint32_t> indices, size_t vertexCount, uint32_t cacheSize = DEFAULT_CACHE_SIZE);
+
+		// renumbers vertices in the order the index buffer first touches them, so fetches walk the vertex buffer mostly forwards
+		// vertices no triangle uses are dropped
+		static void optimizeVertexFetch(std::vector<LveModel::Vertex>& vertices, std::span<uint32_t> indices);
+
+	}; // LveMeshOptimizer
+
+} // lve
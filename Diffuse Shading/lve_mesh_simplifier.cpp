@@ -0,0 +1,313 @@
+#include "lve_mesh_simplifier.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <numeric>
+#include <unordered_map>
+
+namespace lve {
+
+	namespace {
+
+		// symmetric 4x4 matrix, the weighted sum of squared distances to a set of planes is v^T Q v
+		struct Quadric {
+			double a00 = 0.0, a01 = 0.0, a02 = 0.0, a03 = 0.0;
+			double a11 = 0.0, a12 = 0.0, a13 = 0.0;
+			double a22 = 0.0, a23 = 0.0;
+			double a33 = 0.0;
+			double weight = 0.0;
+
+			void addPlane(double a, double b, double c, double d, double weight) {
+				a00 += weight * a * a; a01 += weight * a * b; a02 += weight * a * c; a03 += weight * a * d;
+				a11 += weight * b * b; a12 += weight * b * c; a13 += weight * b * d;
+				a22 += weight * c * c; a23 += weight * c * d;
+				a33 += weight * d * d;
+				this->weight += weight;
+
+			} // addPlane
+
+			Quadric& operator+=(const Quadric& other) {
+				a00 += other.a00; a01 += other.a01; a02 += other.a02; a03 += other.a03;
+				a11 += other.a11; a12 += other.a12; a13 += other.a13;
+				a22 += other.a22; a23 += other.a23;
+				a33 += other.a33;
+				weight += other.weight;
+				return *this;
+
+			} // operator+=
+
+			double evaluate(const glm::vec3& p) const {
+				const double x = p.x, y = p.y, z = p.z;
+				const double error =
+					a00 * x * x + 2.0 * a01 * x * y + 2.0 * a02 * x * z + 2.0 * a03 * x +
+					a11 * y * y + 2.0 * a12 * y * z + 2.0 * a13 * y +
+					a22 * z * z + 2.0 * a23 * z +
+					a33;
+
+				// divided by the total weight this is the mean squared distance, so its square root is an actual distance
+				// rounding can push a perfect fit slightly negative
+				return weight > 0.0 ? std::max(error, 0.0) / weight : 0.0;
+
+			} // evaluate
+
+		}; // Quadric
+
+		struct Collapse {
+			uint32_t from; // vertex that goes away
+			uint32_t to; // vertex it is merged into, the exact one that shares a triangle with it so attributes stay consistent
+			double cost;
+
+		}; // Collapse
+
+		inline uint64_t edgeKey(uint32_t a, uint32_t b) {
+			return a < b ? (static_cast<uint64_t>(a) << 32) | b : (static_cast<uint64_t>(b) << 32) | a;
+
+		} // edgeKey
+
+	} // namespace
+
+	std::vector<uint32_t> LveMeshSimplifier::simplify(
+		std::span<const LveModel::Vertex> vertices,
+		std::span<const uint32_t> indices,
+		size_t targetIndexCount,
+		float maxError,
+		float* resultError) {
+
+		assert(indices.size() % 3 == 0 && "Index count must be a multiple of 3");
+
+		std::vector<uint32_t> result(indices.begin(), indices.end());
+		if (resultError != nullptr)
+			*resultError = 0.f;
+
+		if (indices.size() <= targetIndexCount || vertices.empty())
+			return result;
+
+		const size_t vertexCount = vertices.size();
+
+		// vertices that share a position are the same point of the surface, topology and quadrics work on these positions
+		std::vector<uint32_t> positionOf(vertexCount);
+		std::vector<uint32_t> positionCopies{};
+		std::vector<glm::vec3> positions{};
+		{
+			std::vector<uint32_t> order(vertexCount);
+			std::iota(order.begin(), order.end(), 0);
+			auto less = [&](uint32_t a, uint32_t b) {
+				const glm::vec3& pa = vertices[a].position;
+				const glm::vec3& pb = vertices[b].position;
+				if (pa.x != pb.x) return pa.x < pb.x;
+				if (pa.y != pb.y) return pa.y < pb.y;
+				return pa.z < pb.z;
+
+			}; // less
+
+			std::sort(order.begin(), order.end(), less);
+			for (size_t i = 0; i < vertexCount; i++) {
+				if (i == 0 || less(order[i - 1], order[i])) {
+					positions.push_back(vertices[order[i]].position);
+					positionCopies.push_back(0);
+
+				} // if
+
+				positionOf[order[i]] = static_cast<uint32_t>(positions.size() - 1);
+				positionCopies.back()++;
+
+			} // for
+
+		} // sorting is only needed while grouping
+
+		// errors are measured relative to the size of the mesh, so maxError means the same thing for every model
+		glm::vec3 boundsMin = positions[0];
+		glm::vec3 boundsMax = positions[0];
+		for (const auto& position : positions) {
+			boundsMin = glm::min(boundsMin, position);
+			boundsMax = glm::max(boundsMax, position);
+
+		} // for
+
+		const glm::vec3 extent = boundsMax - boundsMin;
+		const float meshScale = std::max(std::max(extent.x, extent.y), std::max(extent.z, 1e-12f));
+		for (auto& position : positions)
+			position = (position - boundsMin) / meshScale;
+
+		// an edge used by one triangle is an open border, by more than two is non-manifold, both lock their vertices
+		std::vector<bool> collapsible(positions.size());
+		for (size_t p = 0; p < positions.size(); p++)
+			collapsible[p] = positionCopies[p] == 1;
+
+		{
+			std::unordered_map<uint64_t, uint32_t> edgeUses{};
+			edgeUses.reserve(indices.size());
+			for (size_t i = 0; i < indices.size(); i += 3) {
+				for (int e = 0; e < 3; e++)
+					edgeUses[edgeKey(positionOf[indices[i + e]], positionOf[indices[i + (e + 1) % 3]])]++;
+
+			} // for
+
+			for (const auto& [key, uses] : edgeUses) {
+				if (uses != 2) {
+					collapsible[static_cast<uint32_t>(key >> 32)] = false;
+					collapsible[static_cast<uint32_t>(key)] = false;
+
+				} // if
+
+			} // for
+
+		} // edge counts are only needed here
+
+		// every position starts with the planes of its triangles, weighted by area so slivers do not dominate
+		std::vector<Quadric> quadrics(positions.size());
+		for (size_t i = 0; i < indices.size(); i += 3) {
+			const uint32_t p0 = positionOf[indices[i]], p1 = positionOf[indices[i + 1]], p2 = positionOf[indices[i + 2]];
+			const glm::vec3 normal = glm::cross(positions[p1] - positions[p0], positions[p2] - positions[p0]);
+			const float doubleArea = glm::length(normal);
+			if (doubleArea == 0.f)
+				continue;
+
+			const glm::vec3 unitNormal = normal / doubleArea;
+			const double distance = -glm::dot(unitNormal, positions[p0]);
+			Quadric plane{};
+			plane.addPlane(unitNormal.x, unitNormal.y, unitNormal.z, distance, doubleArea * 0.5);
+			quadrics[p0] += plane;
+			quadrics[p1] += plane;
+			quadrics[p2] += plane;
+
+		} // for
+
+		const double maxCost = static_cast<double>(maxError) * maxError;
+		double worstCost = 0.0;
+
+		std::vector<uint32_t> adjacencyOffsets(positions.size() + 1);
+		std::vector<uint32_t> adjacency{};
+		std::vector<Collapse> collapses{};
+		std::vector<bool> touched(positions.size());
+		std::vector<uint32_t> remap(vertexCount);
+
+		// every pass collapses a batch of independent edges and then rebuilds the index buffer, until we hit the target or run out
+		while (result.size() > targetIndexCount) {
+			const size_t triangleCount = result.size() / 3;
+
+			// position -> triangles of the current index buffer
+			std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+			for (uint32_t index : result)
+				adjacencyOffsets[positionOf[index] + 1]++;
+
+			std::partial_sum(adjacencyOffsets.begin(), adjacencyOffsets.end(), adjacencyOffsets.begin());
+			adjacency.resize(result.size());
+			{
+				std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+				for (size_t i = 0; i < result.size(); i++)
+					adjacency[fill[positionOf[result[i]]]++] = static_cast<uint32_t>(i / 3);
+
+			} // fill is only needed while building
+
+			collapses.clear();
+			for (size_t i = 0; i < result.size(); i += 3) {
+				for (int e = 0; e < 3; e++) {
+					const uint32_t a = result[i + e];
+					const uint32_t b = result[i + (e + 1) % 3];
+					const uint32_t pa = positionOf[a], pb = positionOf[b];
+
+					Quadric merged = quadrics[pa];
+					merged += quadrics[pb];
+
+					if (collapsible[pa])
+						collapses.push_back({ a, b, merged.evaluate(positions[pb]) });
+
+					if (collapsible[pb])
+						collapses.push_back({ b, a, merged.evaluate(positions[pa]) });
+
+				} // for
+
+			} // for
+
+			std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+			std::fill(touched.begin(), touched.end(), false);
+			std::iota(remap.begin(), remap.end(), 0);
+			size_t removedTriangles = 0;
+			size_t collapseCount = 0;
+			const size_t targetTriangles = targetIndexCount / 3;
+
+			for (const Collapse& collapse : collapses) {
+				if (collapse.cost > maxCost || triangleCount - removedTriangles <= targetTriangles)
+					break;
+
+				const uint32_t from = positionOf[collapse.from];
+				const uint32_t to = positionOf[collapse.to];
+				if (touched[from] || touched[to])
+					continue;
+
+				// moving from onto to must not flip or squash any of the triangles that survive the collapse
+				bool flips = false;
+				size_t removes = 0;
+				for (uint32_t a = adjacencyOffsets[from]; a < adjacencyOffsets[from + 1] && !flips; a++) {
+					const uint32_t triangle = adjacency[a];
+					uint32_t corners[3] = { positionOf[result[triangle * 3]], positionOf[result[triangle * 3 + 1]], positionOf[result[triangle * 3 + 2]] };
+					if (corners[0] == to || corners[1] == to || corners[2] == to) {
+						removes++;
+						continue;
+
+					} // if
+
+					const glm::vec3 before = glm::cross(positions[corners[1]] - positions[corners[0]], positions[corners[2]] - positions[corners[0]]);
+					for (auto& corner : corners) {
+						if (corner == from)
+							corner = to;
+
+					} // for
+
+					const glm::vec3 after = glm::cross(positions[corners[1]] - positions[corners[0]], positions[corners[2]] - positions[corners[0]]);
+					flips = glm::dot(before, after) < 0.25f * glm::length(before) * glm::length(after);
+
+				} // for
+
+				if (flips)
+					continue;
+
+				// the whole one ring is frozen for the rest of the pass, their triangles no longer match the adjacency we built
+				for (uint32_t a = adjacencyOffsets[from]; a < adjacencyOffsets[from + 1]; a++) {
+					const uint32_t triangle = adjacency[a];
+					for (int corner = 0; corner < 3; corner++)
+						touched[positionOf[result[triangle * 3 + corner]]] = true;
+
+				} // for
+
+				remap[collapse.from] = collapse.to;
+				quadrics[to] += quadrics[from];
+				worstCost = std::max(worstCost, collapse.cost);
+				removedTriangles += removes;
+				collapseCount++;
+
+			} // for
+
+			if (collapseCount == 0)
+				break;
+
+			// apply the collapses and throw away every triangle that lost its area
+			size_t write = 0;
+			for (size_t i = 0; i < result.size(); i += 3) {
+				const uint32_t a = remap[result[i]], b = remap[result[i + 1]], c = remap[result[i + 2]];
+				const uint32_t pa = positionOf[a], pb = positionOf[b], pc = positionOf[c];
+				if (pa == pb || pb == pc || pa == pc)
+					continue;
+
+				result[write++] = a;
+				result[write++] = b;
+				result[write++] = c;
+
+			} // for
+
+			result.resize(write);
+
+		} // while
+
+		if (resultError != nullptr)
+			*resultError = static_cast<float>(std::sqrt(worstCost)) * meshScale;
+
+		return result;
+
+	} // simplify
+
+} // lve
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "lve_model.hpp"
+
+// std
+#include <span>
+#include <vector>
+
+namespace lve {
+
+	// quadric error edge collapse (Garland and Heckbert 1997) that only ever writes a new index buffer
+	// every collapse moves a vertex onto one of its neighbours instead of a new optimal position, so the simplified
+	// triangles keep using the original vertex buffer and all LODs of a model can share it
+	class LveMeshSimplifier {
+	public:
+		// collapses edges, cheapest first, until the index count is at or below targetIndexCount
+		// or the next collapse would move the surface further than maxError (relative to the largest extent of the mesh)
+		// vertices on open borders and on attribute seams (same position, different normal / uv / color) are never moved,
+		// so silhouettes and seams stay intact, which also means flat shaded meshes barely simplify at all
+		// resultError receives the largest surface deviation introduced, in model units
+		static std::vector<uint32_t> simplify(
+			std::span<const LveModel::Vertex> vertices,
+			std::span<const uint32_t> indices,
+			size_t targetIndexCount,
+			float maxError,
+			float* resultError = nullptr);
+
+	}; // LveMeshSimplifier
+
+} // lve
@@ -1,39 +1,103 @@
 #include "lve_model.hpp"
 #include "lve_device.hpp"
-
-//libs
-#define TINYOBJLOADER_IMPLEMENTATION 
-#include <tiny_obj_loader.h>
-#include "lve_utils.hpp"
-
-#define GLM_ENABLE_EXPERIMENTAL
-#include <glm/gtx/hash.hpp>
+#include "lve_mesh_cache.hpp"
+#include "lve_mesh_optimizer.hpp"
+#include "lve_mesh_simplifier.hpp"
+#include "lve_obj_parser.hpp"
+#include "lve_upload_batch.hpp"
+#include "lve_vertex_weld.hpp"
 
 // std
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <cstring>
 #include <iostream>
-#include <unordered_map>
 
-namespace std {
-	template<>
-	struct hash<lve::LveModel::Vertex> {
-		size_t operator() (lve::LveModel::Vertex const& vertex) const {
-				size_t seed = 0; // this will store the final hash value
-				lve::hashCombine(seed, vertex.position, vertex.color, vertex.normal, vertex.uv);
-				return seed;
+namespace lve { 
 
-		} // size_t operator
+	namespace {
 
- 	}; //struct hash <lve::LveModel::Vertex>
+		static_assert(sizeof(LveModel::PackedVertex) == 16, "PackedVertex layout is part of the mesh cache format");
 
-} // namespace std
+		// round to nearest, denormals flush to zero and anything too big becomes infinity
+		uint16_t floatToHalf(float value) {
+			uint32_t bits;
+			std::memcpy(&bits, &value, sizeof(bits));
 
-namespace lve { 
+			const uint32_t sign = (bits >> 16) & 0x8000;
+			const uint32_t magnitude = bits & 0x7fffffff;
+
+			if (magnitude > 0x7f800000)
+				return static_cast<uint16_t>(sign | 0x7e00); // NaN
+			if (magnitude >= (143u << 23))
+				return static_cast<uint16_t>(sign | 0x7c00); // overflow, 143 = 127 + 16
+			if (magnitude < (113u << 23))
+				return static_cast<uint16_t>(sign); // underflow, 113 = 127 - 14
+
+			// rebias the exponent from 127 to 15 and drop 13 mantissa bits, adding half an ulp first rounds instead of truncating
+			return static_cast<uint16_t>(sign | ((magnitude - (112u << 23) + (1u << 12)) >> 13));
+
+		} // floatToHalf
+
+		// folds the unit sphere onto an octahedron and the octahedron onto a square, 2 numbers instead of 3 for almost no error
+		glm::vec2 octEncode(glm::vec3 normal) {
+			const float length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+			if (length == 0.f)
+				return glm::vec2{ 0.f }; // no normal in the file, decodes to +z
+
+			normal /= length;
+			if (normal.z < 0.f) {
+				// the lower half gets folded over the diagonals onto the corners of the square
+				const float x = normal.x;
+				normal.x = (1.f - std::abs(normal.y)) * (x >= 0.f ? 1.f : -1.f);
+				normal.y = (1.f - std::abs(x)) * (normal.y >= 0.f ? 1.f : -1.f);
+
+			} // if
+
+			return { normal.x, normal.y };
+
+		} // octEncode
+
+		int8_t toSnorm8(float value) {
+			return static_cast<int8_t>(std::lround(std::clamp(value, -1.f, 1.f) * 127.f));
+
+		} // toSnorm8
+
+		uint8_t toUnorm8(float value) {
+			return static_cast<uint8_t>(std::lround(std::clamp(value, 0.f, 1.f) * 255.f));
+
+		} // toUnorm8
 
-	LveModel::LveModel(LveDevice& device, const LveModel::Builder &builder) : lveDevice{device} {
-		createVertexBuffers(builder.vertices);
-		createIndexBuffers(builder.indices);
+	} // namespace
+
+	LveModel::LveModel(LveDevice& device, const LveModel::Builder &builder) : lveDevice{ device } {
+		bounds = builder.bounds;
+		if (builder.packedVertices.empty())
+			createBuffers(builder.vertices, builder.indices, builder.lods);
+		else
+			createBuffers(builder.packedVertices, builder.indices, builder.quantization, builder.lods);
+
+		resident.store(true, std::memory_order_release);
+
+	} // LveModel
+
+	LveModel::LveModel(LveDevice& device, std::span<const Vertex> vertices, std::span<const uint32_t> indices, std::span<const Lod> lods) : lveDevice{ device } {
+		bounds = Bounds::fromVertices(vertices);
+		createBuffers(vertices, indices, lods);
+		resident.store(true, std::memory_order_release);
+
+	} // LveModel
+
+	LveModel::LveModel(LveDevice& device, std::span<const PackedVertex> vertices, std::span<const uint32_t> indices, const Quantization& quantization, std::span<const Lod> lods)
+		: lveDevice{ device } {
+		bounds = Bounds::fromQuantization(quantization);
+		createBuffers(vertices, indices, quantization, lods);
+		resident.store(true, std::memory_order_release);
+
+	} // LveModel
+
+	LveModel::LveModel(LveDevice& device) : lveDevice{ device } {
 
 	} // LveModel
 
@@ -43,26 +107,110 @@ namespace lve {
 		// typically only in the 1000s
 		// so if we continue on, as soon as we want some sort of complex model we will run quickly into the max allocation limits
 		// the solution is to allocate bigger chunks of memory and parts of them to particular resources
-		
-		vkDestroyBuffer(lveDevice.device(), vertexBuffer, nullptr);
-		vkFreeMemory(lveDevice.device(), vertexBufferMemory, nullptr);
 
-		if (hasIndexBuffer) {
-			vkDestroyBuffer(lveDevice.device(), indexBuffer, nullptr); 
-			vkFreeMemory(lveDevice.device(), indexBufferMemory, nullptr);
+		// only left over if loading failed half way, LveModelLoader releases them once the copies are done
+		for (const auto& copy : pendingCopies)
+			lveDevice.stagingRing().release(copy.staging);
+		
+		// which is what LveGeometryArena does, most models only hand their ranges back to it
+		releaseBuffer(vertexBuffer, vertexBufferMemory, vertexRange);
 
-		} // if
+		if (hasIndexBuffer)
+			releaseBuffer(indexBuffer, indexBufferMemory, indexRange);
 
 	} // ~LveModel
 
 	std::unique_ptr<LveModel> LveModel::createModelFromFile(LveDevice& device, const std::string& filepath) {
-		Builder builder{};
-		builder.loadModel(filepath);
-		std::cout << "Vertex count: " << builder.vertices.size() << "\n";
-		return std::make_unique<LveModel>(device, builder);
+		return createModelFromFile(device, filepath, ImportOptions{});
+
+	} // createModelFromFile
+
+	std::unique_ptr<LveModel> LveModel::createModelFromFile(LveDevice& device, const std::string& filepath, const ImportOptions& options) {
+		std::unique_ptr<LveModel> model{ new LveModel(device) };
+		model->loadFromFile(filepath, options);
+		model->resident.store(true, std::memory_order_release);
+		return model;
 		
 	} // createModelFromFile
 
+	std::shared_ptr<LveModel> LveModel::createModelFromFile(LveDevice& device, const std::string& filepath, const ImportOptions& options, LveUploadBatch& batch) {
+		std::shared_ptr<LveModel> model{ new LveModel(device) };
+		model->uploadBatch = &batch;
+		model->loadFromFile(filepath, options);
+
+		// the batch keeps going after we return, so it tells the model when it is ready
+		// and keeps it alive until then, even if the caller lets go of it first
+		batch.onComplete([model]() { model->resident.store(true, std::memory_order_release); });
+		return model;
+
+	} // createModelFromFile
+
+	void LveModel::loadFromFile(const std::string& filepath, const ImportOptions& options) {
+		// parsing text is slow, so after the first load we keep a binary copy of the result next to the obj file
+		// on later runs we map that copy and upload straight out of it, the cost is then only the bytes themselves
+		const std::string cachePath = LveMeshCache::cachePathFor(filepath);
+		const LveMeshCache::SourceStamp sourceStamp = LveMeshCache::stampFile(filepath);
+		const uint32_t importFlags = LveMeshCache::importFlagsFor(options);
+
+		if (auto cache = LveMeshCache::open(cachePath, filepath, sourceStamp, importFlags)) {
+			std::cout << "Vertex count: " << cache->vertexCount() << " (cached)\n";
+			bounds = cache->bounds();
+			if (cache->isPacked())
+				createBuffers(cache->packedVertices(), cache->indices(), cache->quantization(), cache->lods());
+			else
+				createBuffers(cache->vertices(), cache->indices(), cache->lods());
+
+			// the source was touched but not changed, store its new stamp so the next load skips the hash again
+			if (cache->wasRehashed()) {
+				cache.reset();
+				LveMeshCache::refreshStamp(cachePath, sourceStamp);
+
+			} // if
+
+			return;
+
+		} // if
+
+		Builder builder{};
+		builder.loadModel(filepath, options.weldMethod);
+		std::cout << "Vertex count: " << builder.vertices.size() << "\n";
+
+		if (options.maxLodCount > 1) {
+			builder.generateLods(options.maxLodCount);
+			std::cout << "LOD triangles:";
+			for (const auto& lod : builder.lods)
+				std::cout << " " << lod.indexCount / 3;
+
+			std::cout << "\n";
+
+		} // if
+
+		if (options.optimizeVertexCache) {
+			VertexCacheReport report = builder.optimizeVertexCache();
+			std::cout << "Vertex cache: ACMR " << report.before.acmr << " -> " << report.after.acmr
+				<< ", ATVR " << report.before.atvr << " -> " << report.after.atvr << "\n";
+
+		} // if
+
+		if (options.vertexFormat == VertexFormat::Packed) {
+			builder.packVertices();
+			std::cout << "Vertex memory: " << builder.vertices.size() * sizeof(Vertex) << " -> " 
+				<< builder.packedVertices.size() * sizeof(PackedVertex) << " bytes (packed)\n";
+
+		} // if
+
+		// the parse just read every byte anyway, hashing them again is cheap next to it
+		if (!LveMeshCache::write(cachePath, sourceStamp, LveMeshCache::hashFile(filepath), importFlags, builder))
+			std::cerr << "failed to write mesh cache: " << cachePath << "\n";
+
+		bounds = builder.bounds;
+		if (builder.packedVertices.empty())
+			createBuffers(builder.vertices, builder.indices, builder.lods);
+		else
+			createBuffers(builder.packedVertices, builder.indices, builder.quantization, builder.lods);
+
+	} // loadFromFile
+
 	void LveModel::bind(VkCommandBuffer commandBuffer) {
 		VkBuffer buffers[] = { vertexBuffer };
 		VkDeviceSize offsets[] = { 0 };
@@ -73,93 +221,167 @@ namespace lve {
 
 	} // bind
 
-	void LveModel::draw(VkCommandBuffer commandBuffer) {
-		if (hasIndexBuffer)
-			vkCmdDrawIndexed(commandBuffer, indexCount, 1, 0, 0, 0);
+	void LveModel::draw(VkCommandBuffer commandBuffer, uint32_t lod, uint32_t instanceCount, uint32_t firstInstance) {
+		// our indices start at 0 for our first vertex, vertexOffset moves them to wherever the arena put it
+		const uint32_t firstVertex = vertexRange ? vertexRange->first : 0;
+
+		if (hasIndexBuffer) {
+			assert(lod < lods.size() && "LOD out of range");
+			const uint32_t firstIndex = (indexRange ? indexRange->first : 0) + lods[lod].firstIndex;
+			vkCmdDrawIndexed(commandBuffer, lods[lod].indexCount, instanceCount, firstIndex, static_cast<int32_t>(firstVertex), firstInstance);
+
+		} // if
 		else
-			vkCmdDraw(commandBuffer, vertexCount, 1, 0, 1);
+			vkCmdDraw(commandBuffer, vertexCount, instanceCount, firstVertex, firstInstance);
 
 	} // draw
 
-	void LveModel::createVertexBuffers(const std::vector<Vertex>& vertices) {
-		// note: HOST = CPU and DEVICE = GPU
-		vertexCount = static_cast<uint32_t>(vertices.size());
-		assert(vertexCount >= 3 && "Vertex count must be at least 3");
-		VkDeviceSize bufferSize = sizeof(vertices[0]) * vertexCount; // formula for giving us the total number of bytes 
+	VkDrawIndexedIndirectCommand LveModel::getDrawCommand(uint32_t lod, uint32_t instanceCount, uint32_t firstInstance) const {
+		assert(hasIndexBuffer && "indirect draws need an index buffer");
+		assert(lod < lods.size() && "LOD out of range");
 
-		VkBuffer stagingBuffer;
-		VkDeviceMemory stagingBufferMemory;
-		lveDevice.createBuffer(
-			bufferSize,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			stagingBuffer,
-			stagingBufferMemory
+		VkDrawIndexedIndirectCommand command{};
+		command.indexCount = lods[lod].indexCount;
+		command.instanceCount = instanceCount;
+		command.firstIndex = (indexRange ? indexRange->first : 0) + lods[lod].firstIndex;
+		command.vertexOffset = static_cast<int32_t>(vertexRange ? vertexRange->first : 0);
+		command.firstInstance = firstInstance;
+		return command;
 
-		); // createBuffer
+	} // getDrawCommand
 
-		void* data;
-		vkMapMemory(lveDevice.device(), stagingBufferMemory, 0, bufferSize, 0, &data); // this creates a region of host memory and maps it to a region of device memory 
-		memcpy(data, vertices.data(), static_cast<size_t>(bufferSize));
-		vkUnmapMemory(lveDevice.device(), stagingBufferMemory);
+	void LveModel::createBuffers(std::span<const Vertex> vertices, std::span<const uint32_t> indices, std::span<const Lod> lods) {
+		createVertexBuffers(std::as_bytes(vertices), static_cast<uint32_t>(vertices.size()));
+		createIndexBuffers(indices, lods);
+		submitUploads();
 
-		lveDevice.createBuffer(
-			bufferSize,
-			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, 
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 
-			vertexBuffer,
-			vertexBufferMemory
+	} // createBuffers
 
-		); // createBuffer
+	void LveModel::createBuffers(std::span<const PackedVertex> vertices, std::span<const uint32_t> indices, const Quantization& quantization, std::span<const Lod> lods) {
+		vertexFormat = VertexFormat::Packed;
+		this->quantization = quantization;
+		createVertexBuffers(std::as_bytes(vertices), static_cast<uint32_t>(vertices.size()));
+		createIndexBuffers(indices, lods);
+		submitUploads();
 
-		// we need to perform a copy operation to move the contents of the staging buffer to the vertex buffer
-		lveDevice.copyBuffer(stagingBuffer, vertexBuffer, bufferSize);
+	} // createBuffers
 
-		vkDestroyBuffer(lveDevice.device(), stagingBuffer, nullptr);
-		vkFreeMemory(lveDevice.device(), stagingBufferMemory, nullptr);
+	void LveModel::createVertexBuffers(std::span<const std::byte> vertexData, uint32_t vertexCount) {
+		this->vertexCount = vertexCount;
+		assert(vertexCount >= 3 && "Vertex count must be at least 3");
+		const uint32_t stride = static_cast<uint32_t>(vertexData.size_bytes() / vertexCount);
+		uploadBuffer(vertexData, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, stride, vertexBuffer, vertexBufferMemory, vertexRange);
 
 	} // createVertexBuffers
 
-	void LveModel::createIndexBuffers(const std::vector<uint32_t>& indices) {
+	void LveModel::createIndexBuffers(std::span<const uint32_t> indices, std::span<const Lod> lods) {
 		indexCount = static_cast<uint32_t>(indices.size());
 		hasIndexBuffer = indexCount > 0;
 		if (!hasIndexBuffer)
 			return;
 
-		VkDeviceSize bufferSize = sizeof(indices[0]) * indexCount; // formula for giving us the total number of bytes 
+		// without a LOD chain the whole buffer is LOD 0
+		if (lods.empty())
+			this->lods = { Lod{ 0, indexCount, 0.f } };
+		else
+			this->lods.assign(lods.begin(), lods.end());
 
-		VkBuffer stagingBuffer;
-		VkDeviceMemory stagingBufferMemory;
-		lveDevice.createBuffer(
-			bufferSize, 
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT, 
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 
-			stagingBuffer, 
-			stagingBufferMemory
-			 
-		); // createBuffer
+		uploadBuffer(std::as_bytes(indices), VK_BUFFER_USAGE_INDEX_BUFFER_BIT, sizeof(uint32_t), indexBuffer, indexBufferMemory, indexRange);
 
-		void* data;
-		vkMapMemory(lveDevice.device(), stagingBufferMemory, 0, bufferSize, 0, &data); // this creates a region of host memory and maps it to a region of device memory 
-		memcpy(data, indices.data(), static_cast<size_t>(bufferSize));
-		vkUnmapMemory(lveDevice.device(), stagingBufferMemory);
+	} // createIndexBuffers
 
-		lveDevice.createBuffer(
-			bufferSize, 
-			VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, 
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-			indexBuffer,
-			indexBufferMemory 
+	void LveModel::uploadBuffer(std::span<const std::byte> data, VkBufferUsageFlags usage, uint32_t stride, VkBuffer& buffer, LveAllocation& bufferMemory, std::optional<LveGeometryArena::Range>& range) {
+		// note: HOST = CPU and DEVICE = GPU
+		VkDeviceSize bufferSize = data.size_bytes(); // formula for giving us the total number of bytes 
 
-		); // createBuffer
+		// a slice of the device's staging ring, which stays mapped, so there is no buffer to create and no map / unmap here
+		LveStagingRegion staging = lveDevice.stagingRing().allocate(bufferSize);
+		memcpy(staging.mapped, data.data(), static_cast<size_t>(bufferSize));
 
-		// we need to perform a copy operation to move the contents of the staging buffer to the vertex buffer
-		lveDevice.copyBuffer(stagingBuffer, indexBuffer, bufferSize);
+		// a slice of the shared buffer if there is room, otherwise a device local buffer of our own like before
+		range = lveDevice.geometryArena().allocate(usage, stride, static_cast<uint32_t>(bufferSize / stride));
+		VkDeviceSize dstOffset = 0;
+		if (range) {
+			buffer = range->buffer;
+			dstOffset = range->byteOffset();
 
-		vkDestroyBuffer(lveDevice.device(), stagingBuffer, nullptr);
-		vkFreeMemory(lveDevice.device(), stagingBufferMemory, nullptr);
+		} // if
+		else {
+			lveDevice.createBuffer(
+				bufferSize,
+				usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT, 
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 
+				buffer,
+				bufferMemory
 
-	} // createIndexBuffers
+			); // createBuffer
+
+		} // else
+
+		// we need to perform a copy operation to move the contents of the staging buffer to the device local buffer
+		// submitUploads does them all at once after the last buffer
+		pendingCopies.push_back({ staging, buffer, dstOffset });
+
+	} // uploadBuffer
+
+	void LveModel::submitUploads() {
+		if (deferUploads)
+			return;
+
+		LveUploadBatch ownBatch{ lveDevice };
+		LveUploadBatch& batch = uploadBatch != nullptr ? *uploadBatch : ownBatch;
+		for (const auto& copy : pendingCopies)
+			batch.copyBuffer(copy.staging, copy.dstBuffer, copy.dstOffset);
+
+		pendingCopies.clear();
+		uploadBatch = nullptr; // createModelFromFile marks us resident once its batch is done
+
+		// ownBatch waits for its copies when it goes out of scope
+
+	} // submitUploads
+
+	void LveModel::releaseBuffer(VkBuffer buffer, const LveAllocation& bufferMemory, const std::optional<LveGeometryArena::Range>& range) {
+		// the frames in flight may still be drawing us, and a freed range could be handed to the next model while they do
+		lveDevice.deferRelease([&device = lveDevice, buffer, bufferMemory, range]() {
+			if (range)
+				device.geometryArena().free(*range);
+			else
+				device.destroyBuffer(buffer, bufferMemory);
+
+		}); // deferRelease
+
+	} // releaseBuffer
+
+	LveModel::Bounds LveModel::Bounds::fromVertices(std::span<const Vertex> vertices) {
+		Bounds bounds{};
+		if (vertices.empty())
+			return bounds;
+
+		bounds.min = vertices[0].position;
+		bounds.max = vertices[0].position;
+		for (const auto& vertex : vertices) {
+			bounds.min = glm::min(bounds.min, vertex.position);
+			bounds.max = glm::max(bounds.max, vertex.position);
+
+		} // for
+
+		bounds.center = (bounds.min + bounds.max) * 0.5f;
+		for (const auto& vertex : vertices)
+			bounds.radius = std::max(bounds.radius, glm::length(vertex.position - bounds.center));
+
+		return bounds;
+
+	} // fromVertices
+
+	LveModel::Bounds LveModel::Bounds::fromQuantization(const Quantization& quantization) {
+		Bounds bounds{};
+		bounds.min = quantization.offset;
+		bounds.max = quantization.offset + quantization.scale;
+		bounds.center = quantization.offset + quantization.scale * 0.5f;
+		bounds.radius = glm::length(quantization.scale) * 0.5f;
+		return bounds;
+
+	} // fromQuantization
 
 	std::vector<VkVertexInputBindingDescription> LveModel::Vertex::getBindingDescriptions() {
 		std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
@@ -183,72 +405,139 @@ namespace lve {
 
 	} // getAttributeDescriptions
 
-	void LveModel::Builder::loadModel(const std::string& filepath) {
-		tinyobj::attrib_t attrib;
-		std::vector<tinyobj::shape_t> shapes;
-		std::vector<tinyobj::material_t> materials;
-		std::string warn, err;
+	std::vector<VkVertexInputBindingDescription> LveModel::PackedVertex::getBindingDescriptions() {
+		std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
+		bindingDescriptions[0].binding = 0;
+		bindingDescriptions[0].stride = sizeof(PackedVertex);
+		bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+		return bindingDescriptions;
+
+	} // getBindingDescriptions
 
-		if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filepath.c_str())) 
-			throw std::runtime_error(warn + err);
-		
-		vertices.clear();
-		indices.clear();
+	std::vector<VkVertexInputAttributeDescription> LveModel::PackedVertex::getAttributeDescriptions() {
+		std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
 
-		std::unordered_map<Vertex, uint32_t> uniqueVertices{};
+		// 3 component 16 bit formats are optional for vertex buffers, so position is read as 4 components and the normal bytes end up in w
+		attributeDescriptions.push_back({ 0, 0, VK_FORMAT_R16G16B16A16_UNORM, offsetof(PackedVertex, position) });
+		attributeDescriptions.push_back({ 1, 0, VK_FORMAT_R8G8B8A8_UNORM, offsetof(PackedVertex, color) });
+		attributeDescriptions.push_back({ 2, 0, VK_FORMAT_R8G8_SNORM, offsetof(PackedVertex, normal) }); // z comes in as 0, the shader decodes it
+		attributeDescriptions.push_back({ 3, 0, VK_FORMAT_R16G16_SFLOAT, offsetof(PackedVertex, uv) });
 
-		for (const auto& shape : shapes) {
-			for (const auto& index : shape.mesh.indices) {
-				Vertex vertex{};
+		return attributeDescriptions;
 
-				if (index.vertex_index >= 0) {
-					vertex.position = {
-						attrib.vertices[3 * index.vertex_index + 0],
-						attrib.vertices[3 * index.vertex_index + 1],
-						attrib.vertices[3 * index.vertex_index + 2]
+	} // getAttributeDescriptions
 
-					}; // vertex.position
+	void LveModel::Builder::loadModel(const std::string& filepath, WeldMethod weldMethod) {
+		// the parser hands back every triangle corner fully expanded, all that is left here is welding the duplicates
+		std::vector<Vertex> corners = LveObjParser::parseTriangleCorners(filepath);
+		LveVertexWeld::weld(corners, weldMethod, vertices, indices);
+		computeBounds();
 
-					vertex.color = {
-						attrib.colors[3 * index.vertex_index + 0],
-						attrib.colors[3 * index.vertex_index + 1],
-						attrib.colors[3 * index.vertex_index + 2]
+	} // loadModel
 
-					}; // vertex.position
+	void LveModel::Builder::computeBounds() {
+		bounds = Bounds::fromVertices(vertices);
 
-				} // if
+	} // computeBounds
 
-				if (index.normal_index >= 0) {
-					vertex.normal = {
-						attrib.normals[3 * index.normal_index + 0],
-						attrib.normals[3 * index.normal_index + 1],
-						attrib.normals[3 * index.normal_index + 2]
+	void LveModel::Builder::generateLods(uint32_t maxLodCount, float maxError) {
+		// no point in simplifying something that is already tiny
+		constexpr size_t MIN_LOD_TRIANGLES = 64;
 
-					}; // vertex.normal
+		lods.clear();
+		lods.push_back({ 0, static_cast<uint32_t>(indices.size()), 0.f });
 
-				} // if (index.normal_index >= 0)
+		// every LOD is simplified from the one before, which is a lot faster than starting over from the full mesh
+		// so their errors add up, which is a safe upper bound on the distance to LOD 0
+		std::vector<uint32_t> previous = indices;
+		float error = 0.f;
+		while (lods.size() < maxLodCount && previous.size() / 3 > MIN_LOD_TRIANGLES) {
+			const size_t target = (previous.size() / 6) * 3;
+			float lodError = 0.f;
+			std::vector<uint32_t> simplified = LveMeshSimplifier::simplify(vertices, previous, target, maxError, &lodError);
 
-				if (index.texcoord_index >= 0) {
-					vertex.uv = {
-						attrib.texcoords[2 * index.texcoord_index + 0],
-						attrib.texcoords[2 * index.texcoord_index + 1],
+			// stuck on locked vertices or the error limit, more LODs would just be copies of this one
+			if (simplified.size() > previous.size() * 85 / 100)
+				break;
 
-					}; // vertex.normal
+			error += lodError;
+			lods.push_back({ static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(simplified.size()), error });
+			indices.insert(indices.end(), simplified.begin(), simplified.end());
+			previous.swap(simplified);
 
-				} // if (index.texcoord_index >= 0)
+		} // while
 
-				if (uniqueVertices.count(vertex) == 0) {
-					uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
-					vertices.push_back(vertex);
+	} // generateLods
 
-				} // if (uniqueVertices.count(vertex) == 0)
+	LveModel::VertexCacheReport LveModel::Builder::optimizeVertexCache() {
+		std::vector<Lod> ranges = lods;
+		if (ranges.empty())
+			ranges.push_back({ 0, static_cast<uint32_t>(indices.size()), 0.f });
 
-				indices.push_back(uniqueVertices[vertex]);
+		std::span<uint32_t> lod0{ indices.data() + ranges[0].firstIndex, ranges[0].indexCount };
 
-			} // for (const auto& index : shape.mesh.indices)
+		VertexCacheReport report{};
+		report.before = LveMeshOptimizer::analyzeVertexCache(lod0, vertices.size());
 
-		} // for (const auto& shape : shapes)
+		// triangle order first, the vertex order then follows from whatever the new index buffer touches first
+		// LOD 0 comes first in the buffer and uses every vertex, so it decides the vertex order
+		for (const auto& lod : ranges)
+			LveMeshOptimizer::optimizeVertexCache(std::span<uint32_t>{ indices.data() + lod.firstIndex, lod.indexCount }, vertices.size());
 
-	} // loadModel
+		LveMeshOptimizer::optimizeVertexFetch(vertices, indices);
+
+		report.after = LveMeshOptimizer::analyzeVertexCache(lod0, vertices.size());
+		return report;
+
+	} // optimizeVertexCache
+
+	void LveModel::Builder::packVertices() {
+		packedVertices.clear();
+		if (vertices.empty())
+			return;
+
+		computeBounds();
+		const glm::vec3 boundsMin = bounds.min;
+		const glm::vec3 boundsMax = bounds.max;
+
+		// 65535 steps across the bounds on every axis, a flat axis just stays at 0
+		// the unorm vertex format hands the shader 0..1, so the scale back is the whole extent
+		const glm::vec3 extent = boundsMax - boundsMin;
+		quantization.offset = boundsMin;
+		quantization.scale = extent;
+		const glm::vec3 toUnorm{
+			extent.x > 0.f ? 65535.f / extent.x : 0.f,
+			extent.y > 0.f ? 65535.f / extent.y : 0.f,
+			extent.z > 0.f ? 65535.f / extent.z : 0.f
+
+		}; // toUnorm
+
+		// rounding moves a packed position up to half a step on every axis, still inside the box but maybe outside the sphere
+		bounds.radius += glm::length(extent / 65535.f) * 0.5f;
+
+		packedVertices.resize(vertices.size());
+		for (size_t i = 0; i < vertices.size(); i++) {
+			const Vertex& vertex = vertices[i];
+			PackedVertex& packed = packedVertices[i];
+
+			const glm::vec3 position = (vertex.position - boundsMin) * toUnorm;
+			for (int axis = 0; axis < 3; axis++)
+				packed.position[axis] = static_cast<uint16_t>(std::lround(std::clamp(position[axis], 0.f, 65535.f)));
+
+			const glm::vec2 normal = octEncode(vertex.normal);
+			packed.normal[0] = toSnorm8(normal.x);
+			packed.normal[1] = toSnorm8(normal.y);
+
+			packed.color[0] = toUnorm8(vertex.color.x);
+			packed.color[1] = toUnorm8(vertex.color.y);
+			packed.color[2] = toUnorm8(vertex.color.z);
+			packed.color[3] = 255;
+
+			packed.uv[0] = floatToHalf(vertex.uv.x);
+			packed.uv[1] = floatToHalf(vertex.uv.y);
+
+		} // for
+
+	} // packVertices
 
 } // lve
\ No newline at end of file
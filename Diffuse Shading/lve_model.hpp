@@ -8,10 +8,18 @@
 #include <glm/glm.hpp>
 
 // stds
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 #include <memory>
+#include <optional>
+#include <span>
+#include <string>
 
 namespace lve {
+	class LveUploadBatch;
+
 	class LveModel {
 	
 	public:
@@ -35,42 +43,223 @@ namespace lve {
 
 		}; // Vertex
 
+		// compact alternative to Vertex, 16 bytes instead of 44
+		// the shader sees the same 4 inputs, the fixed function vertex fetch turns them back into floats for free
+		struct PackedVertex {
+			uint16_t position[3]; // unorm16 inside the mesh bounds, see Quantization
+			int8_t normal[2]; // octahedral encoded snorm8, also read as the w of the position attribute but the shader ignores that
+			uint8_t color[4]; // unorm8, alpha is always 255
+			uint16_t uv[2]; // half floats
+
+			static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
+			static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+
+		}; // PackedVertex
+
+		enum class VertexFormat {
+			Full, // Vertex
+			Packed // PackedVertex
+
+		}; // VertexFormat
+
+		// turns a packed position back into model space: position = offset + scale * unorm
+		struct Quantization {
+			glm::vec3 offset{ 0.f };
+			glm::vec3 scale{ 1.f };
+
+			// same thing as a matrix, so it can be folded into the transform we already push instead of costing shader work
+			glm::mat4 matrix() const {
+				glm::mat4 dequantize{ 1.f };
+				dequantize[0][0] = scale.x;
+				dequantize[1][1] = scale.y;
+				dequantize[2][2] = scale.z;
+				dequantize[3] = glm::vec4(offset, 1.f);
+				return dequantize;
+
+			} // matrix
+
+		}; // Quantization
+
+		// in model space, the box is exact, the sphere is around the box center and reaches the farthest vertex
+		// which is usually a lot tighter than the sphere around the box
+		struct Bounds {
+			glm::vec3 min{ 0.f };
+			glm::vec3 max{ 0.f };
+			glm::vec3 center{ 0.f };
+			float radius = 0.f;
+
+			static Bounds fromVertices(std::span<const Vertex> vertices);
+			// every packed position decodes to somewhere in the quantization box, so its sphere is just the one around the box
+			static Bounds fromQuantization(const Quantization& quantization);
+
+		}; // Bounds
+
+		// one level of detail, a range of the shared index buffer that draws the whole mesh with fewer triangles
+		struct Lod {
+			uint32_t firstIndex = 0;
+			uint32_t indexCount = 0;
+			float error = 0.f; // how far the surface may be from the full resolution one, in model units
+
+		}; // Lod
+
+		// how loadModel merges identical face corners into shared vertices, see LveVertexWeld
+		enum class WeldMethod {
+			UnorderedMap,
+			FlatHash,
+			RadixSort
+
+		}; // WeldMethod
+
+		// post-transform vertex cache efficiency of an index buffer, see LveMeshOptimizer::analyzeVertexCache
+		struct VertexCacheStats {
+			float acmr = 0.f; // average cache miss ratio, shaded vertices per triangle
+			float atvr = 0.f; // average transformed vertex ratio, shaded vertices per unique vertex
+
+		}; // VertexCacheStats
+
+		struct VertexCacheReport {
+			VertexCacheStats before{};
+			VertexCacheStats after{};
+
+		}; // VertexCacheReport
+
+		// everything that changes how a file turns into vertices and indices
+		struct ImportOptions {
+			WeldMethod weldMethod = WeldMethod::FlatHash;
+			bool optimizeVertexCache = true;
+			VertexFormat vertexFormat = VertexFormat::Packed;
+			uint32_t maxLodCount = 4; // including the full resolution one, 1 turns LOD generation off
+
+		}; // ImportOptions
+
 		// this is a temporary builder object storing our vertex and index information until it can be copied over to the model's index and buffer index memory
 		struct Builder {
 			std::vector<Vertex> vertices{};
 			std::vector<uint32_t> indices {};
 
-			void loadModel(const std::string& filepath);
+			// filled by packVertices, when not empty the model is created from these instead of vertices
+			std::vector<PackedVertex> packedVertices{};
+			Quantization quantization{};
+
+			// filled by loadModel and packVertices, or computeBounds after filling vertices some other way
+			Bounds bounds{};
+
+			// filled by generateLods, the ranges of indices that make up each LOD, LOD 0 first
+			// empty means the whole index buffer is the only LOD
+			std::vector<Lod> lods{};
+
+			void loadModel(const std::string& filepath, WeldMethod weldMethod = WeldMethod::FlatHash);
+			void computeBounds();
+
+			// simplifies the mesh into up to maxLodCount - 1 extra LODs with about half the triangles of the one before,
+			// appended to indices and sharing vertices, stops early once a LOD would deviate more than maxError (relative to the mesh size)
+			void generateLods(uint32_t maxLodCount, float maxError = 0.05f);
+
+			// reorders the triangles for the post-transform vertex cache, then the vertices into first use order
+			// every LOD is reordered on its own, only the order changes so the mesh looks exactly the same
+			// the report is for LOD 0
+			VertexCacheReport optimizeVertexCache();
+
+			// quantizes vertices into packedVertices, positions relative to the bounds of the mesh
+			void packVertices();
 
 		}; // Data
 
 		LveModel(LveDevice& lveDevice, const LveModel::Builder &builder);
+		// uploads straight from memory we do not own, e.g. a memory mapped mesh cache
+		LveModel(LveDevice& lveDevice, std::span<const Vertex> vertices, std::span<const uint32_t> indices, std::span<const Lod> lods = {});
+		LveModel(LveDevice& lveDevice, std::span<const PackedVertex> vertices, std::span<const uint32_t> indices, const Quantization& quantization, std::span<const Lod> lods = {});
 		~LveModel();
 
 		LveModel(const LveModel&) = delete;
 		LveModel& operator=(const LveModel&) = delete;
 
 		static std::unique_ptr<LveModel> createModelFromFile(LveDevice& device, const std::string& filepath);
+		static std::unique_ptr<LveModel> createModelFromFile(LveDevice& device, const std::string& filepath, const ImportOptions& options);
+		// leaves the copies in batch, the model becomes resident once the batch has finished them
+		// so loading many models up front costs one submit and one wait instead of one each
+		// shared because the batch holds on to the model until then
+		static std::shared_ptr<LveModel> createModelFromFile(LveDevice& device, const std::string& filepath, const ImportOptions& options, LveUploadBatch& batch);
 
+		// most models live in the LveGeometryArena and bind the same buffers, callers can skip bind when
+		// getVertexBuffer and getIndexBuffer are what they bound last, draw picks the right range either way
 		void bind(VkCommandBuffer commandBuffer);
-		void draw(VkCommandBuffer commandBuffer);
+		void draw(VkCommandBuffer commandBuffer, uint32_t lod = 0, uint32_t instanceCount = 1, uint32_t firstInstance = 0);
+		// the same draw as an indirect command, only for indexed models, it reads the buffers bind binds
+		VkDrawIndexedIndirectCommand getDrawCommand(uint32_t lod = 0, uint32_t instanceCount = 1, uint32_t firstInstance = 0) const;
+		bool isIndexed() const { return hasIndexBuffer; } // isIndexed
+
+		VkBuffer getVertexBuffer() const { return vertexBuffer; } // getVertexBuffer
+		VkBuffer getIndexBuffer() const { return indexBuffer; } // getIndexBuffer
 
+		VertexFormat getVertexFormat() const { return vertexFormat; } // getVertexFormat
+		const Quantization& getQuantization() const { return quantization; } // getQuantization
+
+		// false while LveModelLoader is still loading or uploading the model, nothing may bind or draw it until then
+		// models made by the constructors or createModelFromFile are resident straight away
+		bool isResident() const { return resident.load(std::memory_order_acquire); } // isResident
+
+		uint32_t getLodCount() const { return static_cast<uint32_t>(lods.size()); } // getLodCount
+		const Lod& getLod(uint32_t lod) const { return lods[lod]; } // getLod
+
+		// box and sphere around the mesh in model space
+		const Bounds& getBounds() const { return bounds; } // getBounds
+		glm::vec3 getBoundsCenter() const { return bounds.center; } // getBoundsCenter
+		float getBoundsRadius() const { return bounds.radius; } // getBoundsRadius
 
 	private:
+		friend class LveModelLoader;
+
+		// a staging buffer that still has to be copied into its device local buffer
+		struct PendingCopy {
+			LveStagingRegion staging;
+			VkBuffer dstBuffer;
+			VkDeviceSize dstOffset;
+
+		}; // PendingCopy
+
+		// an empty model, loadFromFile fills it in
+		explicit LveModel(LveDevice& device);
+
+		// everything createModelFromFile does after allocating the model, LveModelLoader runs this on a worker thread
+		void loadFromFile(const std::string& filepath, const ImportOptions& options);
+
 		LveDevice& lveDevice;
 
+		// the buffers are created and the staging buffers filled first, submitUploads then hands all the copies to one LveUploadBatch
+		// with deferUploads set they are left in pendingCopies for LveModelLoader, which batches many models itself
+		// with an uploadBatch they go into that, otherwise into a batch of our own that is waited for straight away
+		bool deferUploads = false;
+		LveUploadBatch* uploadBatch = nullptr;
+		std::vector<PendingCopy> pendingCopies{};
+		std::atomic<bool> resident{ false };
+
 		// two separate objects, we are in charge of memory management here
-		VkBuffer vertexBuffer; 
-		VkDeviceMemory vertexBufferMemory;
+		// with a vertexRange the buffer belongs to the LveGeometryArena and vertexBufferMemory is unused,
+		// we only get buffers of our own for a mesh too big for one of the arena's buffers
+		VkBuffer vertexBuffer = VK_NULL_HANDLE; 
+		LveAllocation vertexBufferMemory{};
+		std::optional<LveGeometryArena::Range> vertexRange{};
 		uint32_t vertexCount;
+		VertexFormat vertexFormat = VertexFormat::Full;
+		Quantization quantization{};
 
-		void createVertexBuffers(const std::vector<Vertex>& vertices);
-		void createIndexBuffers(const std::vector<uint32_t>& indices);
+		void createBuffers(std::span<const Vertex> vertices, std::span<const uint32_t> indices, std::span<const Lod> lods);
+		void createBuffers(std::span<const PackedVertex> vertices, std::span<const uint32_t> indices, const Quantization& quantization, std::span<const Lod> lods);
+		void createVertexBuffers(std::span<const std::byte> vertexData, uint32_t vertexCount);
+		void createIndexBuffers(std::span<const uint32_t> indices, std::span<const Lod> lods);
+		void uploadBuffer(std::span<const std::byte> data, VkBufferUsageFlags usage, uint32_t stride, VkBuffer& buffer, LveAllocation& bufferMemory, std::optional<LveGeometryArena::Range>& range);
+		void submitUploads();
+		void releaseBuffer(VkBuffer buffer, const LveAllocation& bufferMemory, const std::optional<LveGeometryArena::Range>& range);
 
 		bool hasIndexBuffer = false;
-		VkBuffer indexBuffer; 
-		VkDeviceMemory indexBufferMemory;
+		VkBuffer indexBuffer = VK_NULL_HANDLE; 
+		LveAllocation indexBufferMemory{};
+		std::optional<LveGeometryArena::Range> indexRange{};
 		uint32_t indexCount;
+		std::vector<Lod> lods{}; // always at least one once there is an index buffer
+
+		Bounds bounds{};
 
 	}; // LveModel
 
@@ -0,0 +1,108 @@
+#include "lve_model_loader.hpp"
+
+// std
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+
+namespace lve {
+
+	LveModelLoader::LveModelLoader(LveDevice& device, uint32_t workerCount) : lveDevice{ device }, uploads{ device }, workers{ workerCount } {
+
+	} // LveModelLoader
+
+	LveModelLoader::~LveModelLoader() {
+		waitIdle();
+
+	} // ~LveModelLoader
+
+	std::shared_ptr<LveModel> LveModelLoader::loadModel(const std::string& filepath, const LveModel::ImportOptions& options) {
+		std::shared_ptr<LveModel> model{ new LveModel(lveDevice) };
+		model->deferUploads = true;
+		pendingCount++;
+
+		// the future is not needed, the model itself tells the renderer when it is ready
+		workers.submit([this, model, filepath, options]() {
+			try {
+				model->loadFromFile(filepath, options);
+
+				std::lock_guard<std::mutex> lock{ mutex };
+				stagedModels.push_back(model);
+
+			} // try
+			catch (const std::exception& e) {
+				std::cerr << "failed to load model " << filepath << ": " << e.what() << "\n";
+
+				std::lock_guard<std::mutex> lock{ mutex };
+				pendingCount--;
+
+			} // catch
+
+			modelStaged.notify_all();
+
+		}); // submit
+
+		return model;
+
+	} // loadModel
+
+	void LveModelLoader::update() {
+		std::vector<std::shared_ptr<LveModel>> staged{};
+
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			staged.swap(stagedModels);
+
+		} // lock
+
+		if (!staged.empty())
+			submitUploads(std::move(staged));
+
+		// retires the submissions that are done, which marks their models resident
+		uploads.isComplete();
+
+	} // update
+
+	void LveModelLoader::waitIdle() {
+		while (pendingCount > 0) {
+			update();
+
+			if (!uploads.isComplete()) {
+				uploads.wait();
+				continue;
+
+			} // if
+
+			// nothing on the GPU, so whatever is pending is still on a worker
+			std::unique_lock<std::mutex> lock{ mutex };
+			modelStaged.wait(lock, [this]() { return !stagedModels.empty() || pendingCount == 0; });
+
+		} // while
+
+	} // waitIdle
+
+	void LveModelLoader::submitUploads(std::vector<std::shared_ptr<LveModel>> models) {
+		for (const auto& model : models) {
+			for (const auto& copy : model->pendingCopies)
+				uploads.copyBuffer(copy.staging, copy.dstBuffer, copy.dstOffset);
+
+			model->pendingCopies.clear();
+
+		} // for
+
+		// the models stay alive in the callback until their copies are done, even if everyone else lets go of them
+		uploads.onComplete([this, models = std::move(models)]() {
+			for (const auto& model : models) {
+				model->resident.store(true, std::memory_order_release);
+				pendingCount--;
+
+			} // for
+
+		}); // onComplete
+
+		// unlike LveDevice::copyBuffer nothing waits here, frames keep going while the copies run
+		uploads.submit();
+
+	} // submitUploads
+
+} // lve
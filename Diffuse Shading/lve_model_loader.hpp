@@ -0,0 +1,62 @@
+#pragma once
+
+#include "lve_device.hpp"
+#include "lve_model.hpp"
+#include "lve_thread_pool.hpp"
+#include "lve_upload_batch.hpp"
+
+// std
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace lve {
+
+	// loads models in the background so the first frame does not have to wait for every asset in the scene
+	// workers parse (or map the mesh cache), build the buffers and fill the staging buffers,
+	// then update() submits all the copies that are ready in one go through an LveUploadBatch and polls it, nothing waits for the GPU
+	class LveModelLoader {
+	public:
+		explicit LveModelLoader(LveDevice& device, uint32_t workerCount = 0);
+
+		// finishes everything that is in flight first, the GPU may still be reading staging buffers
+		~LveModelLoader();
+
+		LveModelLoader(const LveModelLoader&) = delete;
+		LveModelLoader& operator=(const LveModelLoader&) = delete;
+
+		// returns straight away with a model that is not resident yet, see LveModel::isResident
+		// if loading fails the error is printed and the model simply never becomes resident
+		std::shared_ptr<LveModel> loadModel(const std::string& filepath, const LveModel::ImportOptions& options = {});
+
+		// submits the copies of every model the workers have finished and retires uploads whose transfer has completed
+		// never blocks, call it once per frame from the thread that submits to the graphics queue
+		void update();
+
+		// blocks until every model requested so far is resident or has failed
+		void waitIdle();
+
+		// requested but not resident yet
+		size_t getPendingCount() const { return pendingCount.load(); } // getPendingCount
+
+	private:
+		void submitUploads(std::vector<std::shared_ptr<LveModel>> models);
+
+		LveDevice& lveDevice;
+
+		std::mutex mutex;
+		std::condition_variable modelStaged; // a worker finished or gave up on a model
+		std::vector<std::shared_ptr<LveModel>> stagedModels{}; // guarded by mutex
+		std::atomic<size_t> pendingCount{ 0 };
+
+		LveUploadBatch uploads; // one submission per update with staged models, only touched by the thread calling update
+
+		// last, so the workers are joined before anything they use is destroyed
+		LveThreadPool workers;
+
+	}; // LveModelLoader
+
+} // lve
@@ -0,0 +1,76 @@
+#include "lve_model_registry.hpp"
+#include "lve_mesh_cache.hpp"
+#include "lve_utils.hpp"
+
+// std
+#include <algorithm>
+#include <filesystem>
+
+namespace lve {
+
+	size_t LveModelRegistry::KeyHash::operator()(const Key& key) const {
+		size_t seed = 0;
+		hashCombine(seed, key.path, key.importFlags);
+		return seed;
+
+	} // operator()
+
+	LveModelRegistry::LveModelRegistry(LveModelLoader& loader) : loader{ loader } {
+
+	} // LveModelRegistry
+
+	std::shared_ptr<LveModel> LveModelRegistry::getModel(const std::string& filepath, const LveModel::ImportOptions& options) {
+		// absolute and normalized without touching the disk, a missing file still fails on the worker like before
+		std::error_code error{};
+		std::filesystem::path absolutePath = std::filesystem::absolute(filepath, error);
+		const Key key{ (error ? std::filesystem::path{ filepath } : absolutePath).lexically_normal().generic_string(), LveMeshCache::importFlagsFor(options) };
+
+		std::lock_guard<std::mutex> lock{ mutex };
+
+		auto entry = models.find(key);
+		if (entry != models.end()) {
+			if (auto model = entry->second.lock()) {
+				stats.hits++;
+				return model;
+
+			} // if
+
+		} // if
+
+		stats.misses++;
+		std::shared_ptr<LveModel> model = loader.loadModel(filepath, options);
+		models[key] = model;
+
+		// the map only grows on misses, so this is where dead entries pile up
+		if (models.size() >= evictAt) {
+			evictExpiredLocked();
+			evictAt = std::max<size_t>(64, models.size() * 2);
+
+		} // if
+
+		return model;
+
+	} // getModel
+
+	size_t LveModelRegistry::evictExpired() {
+		std::lock_guard<std::mutex> lock{ mutex };
+		return evictExpiredLocked();
+
+	} // evictExpired
+
+	size_t LveModelRegistry::evictExpiredLocked() {
+		const size_t evicted = std::erase_if(models, [](const auto& entry) { return entry.second.expired(); });
+		stats.evictions += evicted;
+		return evicted;
+
+	} // evictExpiredLocked
+
+	LveModelRegistry::Stats LveModelRegistry::getStats() {
+		std::lock_guard<std::mutex> lock{ mutex };
+		Stats current = stats;
+		current.liveModels = static_cast<size_t>(std::count_if(models.begin(), models.end(), [](const auto& entry) { return !entry.second.expired(); }));
+		return current;
+
+	} // getStats
+
+} // lve
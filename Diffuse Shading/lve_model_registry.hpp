@@ -0,0 +1,68 @@
+#pragma once
+
+#include "lve_model.hpp"
+#include "lve_model_loader.hpp"
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace lve {
+
+	// hands out one shared LveModel per file and import options, so objects that use the same mesh share its GPU buffers
+	// the registry only keeps weak references, a model is freed as soon as the last game object lets go of it
+	// and the next request for it loads it again
+	class LveModelRegistry {
+	public:
+		struct Stats {
+			size_t hits = 0; // requests answered with a model that was still alive
+			size_t misses = 0; // requests that had to load the file
+			size_t evictions = 0; // entries dropped because their model had been freed
+			size_t liveModels = 0; // entries whose model is still alive right now
+
+		}; // Stats
+
+		explicit LveModelRegistry(LveModelLoader& loader);
+
+		LveModelRegistry(const LveModelRegistry&) = delete;
+		LveModelRegistry& operator=(const LveModelRegistry&) = delete;
+
+		// loads through the LveModelLoader on a miss, so the model may not be resident yet either way
+		// paths are compared after making them absolute, "models/a.obj" and "./models/a.obj" are the same model
+		std::shared_ptr<LveModel> getModel(const std::string& filepath, const LveModel::ImportOptions& options = {});
+
+		// drops every entry whose model has been freed, returns how many were dropped
+		size_t evictExpired();
+
+		Stats getStats();
+
+	private:
+		struct Key {
+			std::string path;
+			uint32_t importFlags; // LveMeshCache::importFlagsFor, only options that change the geometry split entries
+
+			bool operator==(const Key& other) const { return importFlags == other.importFlags && path == other.path; } // operator==
+
+		}; // Key
+
+		struct KeyHash {
+			size_t operator()(const Key& key) const;
+
+		}; // KeyHash
+
+		size_t evictExpiredLocked();
+
+		LveModelLoader& loader;
+
+		std::mutex mutex;
+		std::unordered_map<Key, std::weak_ptr<LveModel>, KeyHash> models{};
+		size_t evictAt = 64; // dead entries are only swept when the map has doubled since the last sweep
+		Stats stats{};
+
+	}; // LveModelRegistry
+
+} // lve
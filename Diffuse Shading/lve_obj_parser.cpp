@@ -0,0 +1,381 @@
+#include "lve_obj_parser.hpp"
+#include "lve_file_mapping.hpp"
+
+// std
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+namespace lve {
+
+	namespace {
+
+		constexpr int32_t NO_INDEX = std::numeric_limits<int32_t>::min();
+
+		// below this size starting a thread costs more than the parsing it saves
+		constexpr size_t MIN_CHUNK_SIZE = 256 * 1024;
+
+		// bits for FaceCorner::relativeMask
+		constexpr uint8_t RELATIVE_POSITION = 1 << 0;
+		constexpr uint8_t RELATIVE_TEXCOORD = 1 << 1;
+		constexpr uint8_t RELATIVE_NORMAL = 1 << 2;
+
+		// a face corner as written in the file
+		// negative obj indices count back from the last element read so far, which for a chunk in the middle of the file
+		// depends on how many elements the earlier chunks contain, so those are stored relative to the chunk and fixed up later
+		struct FaceCorner {
+			int32_t position = NO_INDEX;
+			int32_t texcoord = NO_INDEX;
+			int32_t normal = NO_INDEX;
+			uint8_t relativeMask = 0;
+
+		}; // FaceCorner
+
+		struct Chunk {
+			const char* begin = nullptr;
+			const char* end = nullptr;
+
+			std::vector<glm::vec3> positions{};
+			std::vector<glm::vec3> colors{};
+			std::vector<glm::vec3> normals{};
+			std::vector<glm::vec2> texcoords{};
+
+			// polygons are kept as written until every position is known, quads need them to pick the split
+			std::vector<FaceCorner> faceCorners{};
+			std::vector<uint32_t> faceSizes{};
+			size_t triangleCount = 0;
+
+			// where this chunk's elements start in the merged arrays
+			size_t positionBase = 0;
+			size_t normalBase = 0;
+			size_t texcoordBase = 0;
+			size_t cornerBase = 0;
+
+			std::exception_ptr error{};
+
+		}; // Chunk
+
+		inline bool isSpace(char c) { return c == ' ' || c == '\t'; } // isSpace
+
+		inline const char* skipSpaces(const char* p, const char* end) {
+			while (p < end && isSpace(*p))
+				p++;
+
+			return p;
+
+		} // skipSpaces
+
+		inline const char* nextLine(const char* p, const char* end) {
+			auto newline = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+			return newline != nullptr ? newline + 1 : end;
+
+		} // nextLine
+
+		// std::from_chars does no locale lookups and no stream state, which is where istream based parsing spends most of its time
+		inline bool parseFloat(const char*& p, const char* end, float& value) {
+			p = skipSpaces(p, end);
+			if (p < end && *p == '+')
+				p++; // from_chars does not accept a leading plus
+
+			auto [next, error] = std::from_chars(p, end, value);
+			if (error == std::errc::result_out_of_range)
+				value = 0.f; // denormals and friends, not worth failing the load over
+			else if (error != std::errc{})
+				return false;
+
+			p = next;
+			return true;
+
+		} // parseFloat
+
+		inline bool parseInt(const char*& p, const char* end, int32_t& value) {
+			if (p < end && *p == '+')
+				p++;
+
+			auto [next, error] = std::from_chars(p, end, value);
+			if (error != std::errc{})
+				return false;
+
+			p = next;
+			return true;
+
+		} // parseInt
+
+		inline void parseIndex(const char*& p, const char* end, size_t elementsSoFar, uint8_t relativeBit, int32_t& index, uint8_t& relativeMask) {
+			int32_t value = 0;
+			if (!parseInt(p, end, value) || value == 0)
+				throw std::runtime_error("invalid face index");
+
+			if (value > 0) {
+				index = value - 1; // obj indices start at 1
+
+			} else {
+				index = static_cast<int32_t>(elementsSoFar) + value;
+				relativeMask |= relativeBit;
+
+			} // else
+
+		} // parseIndex
+
+		void parseFaceCorner(const char*& p, const char* end, const Chunk& chunk, FaceCorner& corner) {
+			// v, v/vt, v//vn or v/vt/vn
+			parseIndex(p, end, chunk.positions.size(), RELATIVE_POSITION, corner.position, corner.relativeMask);
+			if (p >= end || *p != '/')
+				return;
+
+			p++;
+			if (p < end && *p != '/')
+				parseIndex(p, end, chunk.texcoords.size(), RELATIVE_TEXCOORD, corner.texcoord, corner.relativeMask);
+
+			if (p >= end || *p != '/')
+				return;
+
+			p++;
+			parseIndex(p, end, chunk.normals.size(), RELATIVE_NORMAL, corner.normal, corner.relativeMask);
+
+		} // parseFaceCorner
+
+		void parseChunk(Chunk& chunk) {
+			const char* p = chunk.begin;
+			const char* end = chunk.end;
+
+			while (p < end) {
+				const char* lineEnd = nextLine(p, end);
+				p = skipSpaces(p, lineEnd);
+
+				if (lineEnd - p >= 2 && p[0] == 'v' && isSpace(p[1])) {
+					p += 2;
+					glm::vec3 position{};
+					if (!parseFloat(p, lineEnd, position.x) || !parseFloat(p, lineEnd, position.y) || !parseFloat(p, lineEnd, position.z))
+						throw std::runtime_error("invalid vertex position");
+
+					// vertex colors are an unofficial extension written as "v x y z r g b", tinyobj falls back to white without them
+					glm::vec3 color{ 1.f, 1.f, 1.f };
+					float r, g, b;
+					if (parseFloat(p, lineEnd, r) && parseFloat(p, lineEnd, g) && parseFloat(p, lineEnd, b))
+						color = { r, g, b };
+
+					chunk.positions.push_back(position);
+					chunk.colors.push_back(color);
+
+				} // if (position)
+				else if (lineEnd - p >= 3 && p[0] == 'v' && p[1] == 'n' && isSpace(p[2])) {
+					p += 3;
+					glm::vec3 normal{};
+					if (!parseFloat(p, lineEnd, normal.x) || !parseFloat(p, lineEnd, normal.y) || !parseFloat(p, lineEnd, normal.z))
+						throw std::runtime_error("invalid vertex normal");
+
+					chunk.normals.push_back(normal);
+
+				} // else if (normal)
+				else if (lineEnd - p >= 3 && p[0] == 'v' && p[1] == 't' && isSpace(p[2])) {
+					p += 3;
+					glm::vec2 uv{};
+					if (!parseFloat(p, lineEnd, uv.x))
+						throw std::runtime_error("invalid texture coordinate");
+
+					parseFloat(p, lineEnd, uv.y); // v is optional in the spec and defaults to 0
+					chunk.texcoords.push_back(uv);
+
+				} // else if (texcoord)
+				else if (lineEnd - p >= 2 && p[0] == 'f' && isSpace(p[1])) {
+					p += 2;
+					uint32_t cornerCount = 0;
+
+					while (true) {
+						p = skipSpaces(p, lineEnd);
+						if (p >= lineEnd || *p == '\r' || *p == '\n' || *p == '#')
+							break;
+
+						FaceCorner corner{};
+						parseFaceCorner(p, lineEnd, chunk, corner);
+						chunk.faceCorners.push_back(corner);
+						cornerCount++;
+
+					} // while
+
+					// tinyobj skips degenerate faces with a warning, we do the same minus the warning
+					if (cornerCount < 3) {
+						chunk.faceCorners.resize(chunk.faceCorners.size() - cornerCount);
+
+					} else {
+						chunk.faceSizes.push_back(cornerCount);
+						chunk.triangleCount += cornerCount - 2;
+
+					} // else
+
+				} // else if (face)
+
+				p = lineEnd;
+
+			} // while
+
+		} // parseChunk
+
+		// runs the function once per chunk, the calling thread takes the first chunk instead of sitting idle
+		// exceptions are caught on the worker and rethrown here, a throwing std::thread would terminate the program
+		template <typename Function>
+		void forEachChunk(std::vector<Chunk>& chunks, Function function) {
+			auto run = [&function](Chunk& chunk) {
+				try {
+					function(chunk);
+
+				} // try
+				catch (...) {
+					chunk.error = std::current_exception();
+
+				} // catch
+
+			}; // run
+
+			std::vector<std::thread> workers{};
+			workers.reserve(chunks.size());
+			for (size_t i = 1; i < chunks.size(); i++)
+				workers.emplace_back(run, std::ref(chunks[i]));
+
+			if (!chunks.empty())
+				run(chunks[0]);
+
+			for (auto& worker : workers)
+				worker.join();
+
+			for (const auto& chunk : chunks) {
+				if (chunk.error)
+					std::rethrow_exception(chunk.error);
+
+			} // for
+
+		} // forEachChunk
+
+		inline size_t resolveIndex(int32_t index, bool relative, size_t base, size_t count) {
+			int64_t resolved = relative ? static_cast<int64_t>(base) + index : index;
+			if (resolved < 0 || resolved >= static_cast<int64_t>(count))
+				throw std::runtime_error("face index out of range");
+
+			return static_cast<size_t>(resolved);
+
+		} // resolveIndex
+
+	} // namespace
+
+	std::vector<LveModel::Vertex> LveObjParser::parseTriangleCorners(const std::string& filepath, unsigned int threadCount) {
+		LveFileMapping file{};
+		if (!file.map(filepath))
+			throw std::runtime_error("failed to open file: " + filepath);
+
+		const char* data = reinterpret_cast<const char*>(file.data());
+		const char* fileEnd = data + file.size();
+
+		if (threadCount == 0)
+			threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+		// split at roughly equal byte offsets and push every split forward to the start of the next line
+		const size_t chunkCount = std::clamp<size_t>(file.size() / MIN_CHUNK_SIZE, 1, threadCount);
+		std::vector<Chunk> chunks(chunkCount);
+		const char* chunkBegin = data;
+		for (size_t i = 0; i < chunkCount; i++) {
+			const char* chunkEnd = (i + 1 == chunkCount) ? fileEnd : nextLine(data + file.size() * (i + 1) / chunkCount, fileEnd);
+			chunks[i].begin = chunkBegin;
+			chunks[i].end = std::max(chunkEnd, chunkBegin);
+			chunkBegin = chunks[i].end;
+
+		} // for
+
+		// pass 1: tokenize every chunk on its own
+		forEachChunk(chunks, parseChunk);
+
+		// every chunk now knows how many elements it holds, so a prefix sum gives everyone their global offsets
+		size_t positionCount = 0, normalCount = 0, texcoordCount = 0, cornerCount = 0;
+		for (auto& chunk : chunks) {
+			chunk.positionBase = positionCount;
+			chunk.normalBase = normalCount;
+			chunk.texcoordBase = texcoordCount;
+			chunk.cornerBase = cornerCount;
+			positionCount += chunk.positions.size();
+			normalCount += chunk.normals.size();
+			texcoordCount += chunk.texcoords.size();
+			cornerCount += chunk.triangleCount * 3;
+
+		} // for
+
+		// pass 2: merge the attributes, faces may point into any chunk so this has to finish before we resolve them
+		std::vector<glm::vec3> positions(positionCount);
+		std::vector<glm::vec3> colors(positionCount);
+		std::vector<glm::vec3> normals(normalCount);
+		std::vector<glm::vec2> texcoords(texcoordCount);
+		forEachChunk(chunks, [&](Chunk& chunk) {
+			std::copy(chunk.positions.begin(), chunk.positions.end(), positions.begin() + chunk.positionBase);
+			std::copy(chunk.colors.begin(), chunk.colors.end(), colors.begin() + chunk.positionBase);
+			std::copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + chunk.normalBase);
+			std::copy(chunk.texcoords.begin(), chunk.texcoords.end(), texcoords.begin() + chunk.texcoordBase);
+
+		}); // forEachChunk
+
+		// pass 3: resolve and triangulate the faces straight into their final slots
+		std::vector<LveModel::Vertex> corners(cornerCount);
+		forEachChunk(chunks, [&](Chunk& chunk) {
+			auto expand = [&](const FaceCorner& corner) {
+				LveModel::Vertex vertex{};
+				size_t position = resolveIndex(corner.position, corner.relativeMask & RELATIVE_POSITION, chunk.positionBase, positions.size());
+				vertex.position = positions[position];
+				vertex.color = colors[position];
+
+				if (corner.normal != NO_INDEX)
+					vertex.normal = normals[resolveIndex(corner.normal, corner.relativeMask & RELATIVE_NORMAL, chunk.normalBase, normals.size())];
+
+				if (corner.texcoord != NO_INDEX)
+					vertex.uv = texcoords[resolveIndex(corner.texcoord, corner.relativeMask & RELATIVE_TEXCOORD, chunk.texcoordBase, texcoords.size())];
+
+				return vertex;
+
+			}; // expand
+
+			LveModel::Vertex* out = corners.data() + chunk.cornerBase;
+			const FaceCorner* face = chunk.faceCorners.data();
+			std::vector<LveModel::Vertex> polygon{};
+
+			for (uint32_t faceSize : chunk.faceSizes) {
+				polygon.resize(faceSize);
+				for (uint32_t i = 0; i < faceSize; i++)
+					polygon[i] = expand(face[i]);
+
+				if (faceSize == 4) {
+					// split along the shorter diagonal, same as tinyobj so the output matches what we had before
+					glm::vec3 e02 = polygon[2].position - polygon[0].position;
+					glm::vec3 e13 = polygon[3].position - polygon[1].position;
+					if (glm::dot(e02, e02) < glm::dot(e13, e13)) {
+						*out++ = polygon[0]; *out++ = polygon[1]; *out++ = polygon[2];
+						*out++ = polygon[0]; *out++ = polygon[2]; *out++ = polygon[3];
+
+					} else {
+						*out++ = polygon[0]; *out++ = polygon[1]; *out++ = polygon[3];
+						*out++ = polygon[1]; *out++ = polygon[2]; *out++ = polygon[3];
+
+					} // else
+
+				} else {
+					// triangles, and a simple fan for anything bigger
+					for (uint32_t i = 1; i + 1 < faceSize; i++) {
+						*out++ = polygon[0];
+						*out++ = polygon[i];
+						*out++ = polygon[i + 1];
+
+					} // for
+
+				} // else
+
+				face += faceSize;
+
+			} // for
+
+		}); // forEachChunk
+
+		return corners;
+
+	} // parseTriangleCorners
+
+} // lve
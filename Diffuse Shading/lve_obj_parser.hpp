@@ -0,0 +1,25 @@
+#pragma once
+
+#include "lve_model.hpp"
+
+// std
+#include <string>
+#include <vector>
+
+namespace lve {
+
+	// multithreaded parser for the part of the obj format we actually use: v (with optional vertex colors), vn, vt and f
+	// the file is memory mapped and split into line aligned chunks, every chunk is tokenized on its own thread,
+	// then the per chunk results are stitched together in a second parallel pass once every chunk knows its global offsets
+	// anything else (o, g, s, usemtl, mtllib, comments) is skipped
+	class LveObjParser {
+	public:
+		// returns one fully expanded vertex per triangle corner, in file order, ready to be welded into vertices + indices
+		// triangles and quads come out exactly like tinyobj (quads are split along the shorter diagonal),
+		// bigger polygons are fanned from their first corner instead of ear clipped, which is fine for the convex faces exporters write
+		// threadCount = 0 uses every hardware thread
+		static std::vector<LveModel::Vertex> parseTriangleCorners(const std::string& filepath, unsigned int threadCount = 0);
+
+	}; // LveObjParser
+
+} // lve
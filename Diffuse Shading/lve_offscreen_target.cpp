@@ -0,0 +1,215 @@
+#include "lve_offscreen_target.hpp"
+
+// std
+#include <array>
+#include <limits>
+#include <stdexcept>
+
+namespace lve {
+
+	LveOffscreenTarget::LveOffscreenTarget(LveDevice& device, VkExtent2D extent, const LveSwapChainConfig& config)
+		: device{ device }, extent{ extent }, frames(config.framesInFlight) {
+		if (config.framesInFlight == 0)
+			throw std::runtime_error("an offscreen target needs at least one frame in flight!");
+
+		depthFormat = device.findSupportedFormat(
+			{ VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT },
+			VK_IMAGE_TILING_OPTIMAL,
+			VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
+
+		createRenderPass();
+		for (auto& frame : frames)
+			createFrame(frame);
+
+	} // LveOffscreenTarget
+
+	LveOffscreenTarget::~LveOffscreenTarget() {
+		for (auto& frame : frames) {
+			vkDestroyFence(device.device(), frame.inFlightFence, nullptr);
+			vkDestroyFramebuffer(device.device(), frame.framebuffer, nullptr);
+			vkDestroyImageView(device.device(), frame.depthView, nullptr);
+			vkDestroyImageView(device.device(), frame.colorView, nullptr);
+			if (frame.depthImage != VK_NULL_HANDLE)
+				device.destroyImage(frame.depthImage, frame.depthMemory);
+
+			if (frame.colorImage != VK_NULL_HANDLE)
+				device.destroyImage(frame.colorImage, frame.colorMemory);
+
+		} // for
+
+		vkDestroyRenderPass(device.device(), renderPass, nullptr);
+
+	} // ~LveOffscreenTarget
+
+	void LveOffscreenTarget::createRenderPass() {
+		// the same as the swap chain's apart from the final color layout, so pipelines made for one work with the other
+		VkAttachmentDescription colorAttachment{};
+		colorAttachment.format = COLOR_FORMAT;
+		colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+		colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		colorAttachment.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+		VkAttachmentDescription depthAttachment{};
+		depthAttachment.format = depthFormat;
+		depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+		depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE; // same as the swap chain, LveGpuCulling reads it after the pass
+		depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+
+		VkAttachmentReference colorAttachmentRef{ 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+		VkAttachmentReference depthAttachmentRef{ 1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+
+		VkSubpassDescription subpass{};
+		subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		subpass.colorAttachmentCount = 1;
+		subpass.pColorAttachments = &colorAttachmentRef;
+		subpass.pDepthStencilAttachment = &depthAttachmentRef;
+
+		std::array<VkSubpassDependency, 2> dependencies{};
+		dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+		dependencies[0].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		dependencies[0].srcAccessMask = 0;
+		dependencies[0].dstSubpass = 0;
+		dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+		dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+		// without a present the image is only ever read by a capture, so the pass hands it straight to the transfer stage
+		// and the depth to the compute stage
+		dependencies[1].srcSubpass = 0;
+		dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+		dependencies[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		dependencies[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+
+		std::array<VkAttachmentDescription, 2> attachments = { colorAttachment, depthAttachment };
+		VkRenderPassCreateInfo renderPassInfo{};
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+		renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+		renderPassInfo.pAttachments = attachments.data();
+		renderPassInfo.subpassCount = 1;
+		renderPassInfo.pSubpasses = &subpass;
+		renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+		renderPassInfo.pDependencies = dependencies.data();
+
+		if (vkCreateRenderPass(device.device(), &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS)
+			throw std::runtime_error("failed to create offscreen render pass!");
+
+	} // createRenderPass
+
+	void LveOffscreenTarget::createFrame(Frame& frame) {
+		VkImageCreateInfo imageInfo{};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.extent = { extent.width, extent.height, 1 };
+		imageInfo.mipLevels = 1;
+		imageInfo.arrayLayers = 1;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		imageInfo.format = COLOR_FORMAT;
+		imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+		device.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, frame.colorImage, frame.colorMemory);
+		frame.colorView = createImageView(frame.colorImage, COLOR_FORMAT, VK_IMAGE_ASPECT_COLOR_BIT);
+
+		imageInfo.format = depthFormat;
+		imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+		device.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, frame.depthImage, frame.depthMemory);
+		frame.depthView = createImageView(frame.depthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT);
+
+		std::array<VkImageView, 2> attachments = { frame.colorView, frame.depthView };
+		VkFramebufferCreateInfo framebufferInfo{};
+		framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+		framebufferInfo.renderPass = renderPass;
+		framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+		framebufferInfo.pAttachments = attachments.data();
+		framebufferInfo.width = extent.width;
+		framebufferInfo.height = extent.height;
+		framebufferInfo.layers = 1;
+
+		if (vkCreateFramebuffer(device.device(), &framebufferInfo, nullptr, &frame.framebuffer) != VK_SUCCESS)
+			throw std::runtime_error("failed to create offscreen framebuffer!");
+
+		VkFenceCreateInfo fenceInfo{};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+		if (vkCreateFence(device.device(), &fenceInfo, nullptr, &frame.inFlightFence) != VK_SUCCESS)
+			throw std::runtime_error("failed to create synchronization objects for a frame!");
+
+	} // createFrame
+
+	VkImageView LveOffscreenTarget::createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectMask) {
+		VkImageViewCreateInfo viewInfo{};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image = image;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = format;
+		viewInfo.subresourceRange.aspectMask = aspectMask;
+		viewInfo.subresourceRange.baseMipLevel = 0;
+		viewInfo.subresourceRange.levelCount = 1;
+		viewInfo.subresourceRange.baseArrayLayer = 0;
+		viewInfo.subresourceRange.layerCount = 1;
+
+		VkImageView view = VK_NULL_HANDLE;
+		if (vkCreateImageView(device.device(), &viewInfo, nullptr, &view) != VK_SUCCESS)
+			throw std::runtime_error("failed to create offscreen image view!");
+
+		return view;
+
+	} // createImageView
+
+	VkResult LveOffscreenTarget::acquireNextImage(uint32_t* imageIndex) {
+		// nothing to wait for but the GPU, the image of a frame is free again as soon as its fence signals
+		vkWaitForFences(device.device(), 1, &frames[currentFrame].inFlightFence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+		*imageIndex = static_cast<uint32_t>(currentFrame);
+		return VK_SUCCESS;
+
+	} // acquireNextImage
+
+	VkResult LveOffscreenTarget::submitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex) {
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = buffers;
+
+		VkFence fence = frames[*imageIndex].inFlightFence;
+		vkResetFences(device.device(), 1, &fence);
+		auto queueLock = device.lockQueue(device.graphicsQueue()); // loader threads submit to this queue too
+		if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, fence) != VK_SUCCESS)
+			throw std::runtime_error("failed to submit draw command buffer!");
+
+		currentFrame = (currentFrame + 1) % frames.size();
+		return VK_SUCCESS;
+
+	} // submitCommandBuffers
+
+	bool LveOffscreenTarget::isIdle() const {
+		for (const auto& frame : frames) {
+			if (vkGetFenceStatus(device.device(), frame.inFlightFence) != VK_SUCCESS)
+				return false;
+
+		} // for
+
+		return true;
+
+	} // isIdle
+
+	void LveOffscreenTarget::waitForFrame(size_t frameIndex) const {
+		if (frameIndex >= frames.size())
+			return;
+
+		vkWaitForFences(device.device(), 1, &frames[frameIndex].inFlightFence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+
+	} // waitForFrame
+
+} // lve
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "lve_device.hpp"
+#include "lve_render_target.hpp"
+#include "lve_swap_chain.hpp"
+
+// std
+#include <vector>
+
+namespace lve {
+
+	// color and depth images to render into without a window, for benchmarks and tests on machines with no display
+	// one image per frame in flight, frame i always draws into image i, which its fence guards like a swap chain image
+	// nothing is presented or paced, so frames go as fast as the GPU takes them
+	// the color image is left in TRANSFER_SRC_OPTIMAL for LveReadback
+	class LveOffscreenTarget : public LveRenderTarget {
+	public:
+		static constexpr VkFormat COLOR_FORMAT = VK_FORMAT_B8G8R8A8_SRGB; // what swap chains usually pick, so pipelines and captures match
+
+		// only framesInFlight is used from the config
+		LveOffscreenTarget(LveDevice& device, VkExtent2D extent, const LveSwapChainConfig& config = {});
+		~LveOffscreenTarget();
+
+		LveOffscreenTarget(const LveOffscreenTarget&) = delete;
+		LveOffscreenTarget& operator=(const LveOffscreenTarget&) = delete;
+
+		VkResult acquireNextImage(uint32_t* imageIndex) override;
+		VkResult submitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex) override;
+
+		VkRenderPass getRenderPass() override { return renderPass; } // getRenderPass
+		VkFramebuffer getFrameBuffer(int index) override { return frames[index].framebuffer; } // getFrameBuffer
+		VkImage getImage(int index) override { return frames[index].colorImage; } // getImage
+		VkImageView getDepthImageView(int index) override { return frames[index].depthView; } // getDepthImageView
+		VkFormat getSwapChainImageFormat() override { return COLOR_FORMAT; } // getSwapChainImageFormat
+		VkExtent2D getSwapChainExtent() override { return extent; } // getSwapChainExtent
+
+		VkImageLayout getFinalColorLayout() const override { return VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL; } // getFinalColorLayout
+		VkPresentModeKHR getPresentMode() const override { return VK_PRESENT_MODE_IMMEDIATE_KHR; } // nothing waits for a vertical blank
+		bool supportsReadback() const override { return true; } // supportsReadback
+
+		bool isIdle() const override;
+		void waitForFrame(size_t frameIndex) const override;
+
+	private:
+		struct Frame {
+			VkImage colorImage = VK_NULL_HANDLE;
+			LveAllocation colorMemory{};
+			VkImageView colorView = VK_NULL_HANDLE;
+			VkImage depthImage = VK_NULL_HANDLE;
+			LveAllocation depthMemory{};
+			VkImageView depthView = VK_NULL_HANDLE;
+			VkFramebuffer framebuffer = VK_NULL_HANDLE;
+			VkFence inFlightFence = VK_NULL_HANDLE;
+
+		}; // Frame
+
+		void createRenderPass();
+		void createFrame(Frame& frame);
+		VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectMask);
+
+		LveDevice& device;
+		VkExtent2D extent;
+		VkFormat depthFormat;
+
+		VkRenderPass renderPass = VK_NULL_HANDLE;
+		std::vector<Frame> frames;
+		size_t currentFrame = 0;
+
+	}; // LveOffscreenTarget
+
+} // lve
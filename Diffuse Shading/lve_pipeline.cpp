@@ -125,6 +125,10 @@ namespace lve {
 		configInfo.dynamicStateInfo.dynamicStateCount = static_cast<uint32_t>(configInfo.dynamicStateEnables.size());
 		configInfo.dynamicStateInfo.flags = 0;
 
+		// full fp32 vertices unless the caller swaps in another layout, e.g. LveModel::PackedVertex
+		configInfo.bindingDescriptions = LveModel::Vertex::getBindingDescriptions();
+		configInfo.attributeDescriptions = LveModel::Vertex::getAttributeDescriptions();
+
 		//return configInfo;
 
 	} // defaultPipelineConfigInfo
@@ -171,8 +175,7 @@ namespace lve {
 		shaderStages[0].pName = "main";
 		shaderStages[0].flags = 0;
 		shaderStages[0].pNext = nullptr;
-		// to be covered later
-		shaderStages[0].pSpecializationInfo = nullptr; // customizes shader functionality 
+		shaderStages[0].pSpecializationInfo = configInfo.vertSpecializationInfo; // customizes shader functionality 
 
 		shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 		shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
@@ -186,8 +189,8 @@ namespace lve {
 		// how we extract our inital vertex input data to our graphics pipeline
 		VkPipelineVertexInputStateCreateInfo vertexInputInfo{}; 
 		
-		auto bindingDescriptions = LveModel::Vertex::getBindingDescriptions();
-		auto attributeDescriptions = LveModel::Vertex::getAttributeDescriptions();
+		auto& bindingDescriptions = configInfo.bindingDescriptions;
+		auto& attributeDescriptions = configInfo.attributeDescriptions;
 
 		vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 		vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size()); // we harded data directly into the shader
@@ -13,6 +13,8 @@ namespace lve {
 
 		//VkViewport viewport;
 		//VkRect2D scissor;
+		std::vector<VkVertexInputBindingDescription> bindingDescriptions{};
+		std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
 		std::vector<VkDynamicState> dynamicStateEnables;
 		VkPipelineDynamicStateCreateInfo dynamicStateInfo;
 		VkPipelineViewportStateCreateInfo viewportInfo;
@@ -25,6 +27,7 @@ namespace lve {
 		VkPipelineLayout pipelineLayout = nullptr;
 		VkRenderPass renderPass = nullptr;
 		uint32_t subpass = 0;
+		const VkSpecializationInfo* vertSpecializationInfo = nullptr; // constant_id values baked into the vertex shader
 
 	}; // PipelineConfigInfo
 
@@ -47,10 +50,10 @@ namespace lve {
 
 		static void defaultPipelineConfigInfo(PipelineConfigInfo& configInfo);
 
-
-	private:
+		// the whole file as bytes, LveComputePipeline loads its SPIR-V with it too
 		static std::vector<char> readFile(const std::string& filePath);
 
+	private:
 		void createGraphicsPipeline(const std::string& vertFilePath, 
 			const std::string& fragFilePath, 
 			const PipelineConfigInfo& configInfo);
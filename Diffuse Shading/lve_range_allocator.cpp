@@ -0,0 +1,74 @@
+#include "lve_range_allocator.hpp"
+
+// std
+#include <cassert>
+#include <iterator>
+
+namespace lve {
+
+	LveRangeAllocator::LveRangeAllocator(uint64_t capacity) : capacity{ capacity }, freeSize{ capacity } {
+		if (capacity > 0)
+			freeRanges[0] = capacity;
+
+	} // LveRangeAllocator
+
+	uint64_t LveRangeAllocator::allocate(uint64_t size, uint64_t alignment) {
+		assert(size > 0 && alignment > 0 && "Ranges must have a size and an alignment");
+
+		auto best = freeRanges.end();
+		uint64_t bestOffset = 0;
+		for (auto range = freeRanges.begin(); range != freeRanges.end(); range++) {
+			const uint64_t aligned = (range->first + alignment - 1) / alignment * alignment;
+			if (aligned - range->first + size <= range->second && (best == freeRanges.end() || range->second < best->second)) {
+				best = range;
+				bestOffset = aligned;
+
+			} // if
+
+		} // for
+
+		if (best == freeRanges.end())
+			return INVALID_OFFSET;
+
+		// cut the request out of the free range, whatever is left on either side stays free
+		const uint64_t rangeOffset = best->first;
+		const uint64_t rangeEnd = best->first + best->second;
+		freeRanges.erase(best);
+		if (bestOffset > rangeOffset)
+			freeRanges[rangeOffset] = bestOffset - rangeOffset;
+
+		if (rangeEnd > bestOffset + size)
+			freeRanges[bestOffset + size] = rangeEnd - (bestOffset + size);
+
+		freeSize -= size;
+		return bestOffset;
+
+	} // allocate
+
+	void LveRangeAllocator::free(uint64_t offset, uint64_t size) {
+		assert(offset + size <= capacity && "Range is outside of the allocator");
+		freeSize += size;
+
+		auto next = freeRanges.lower_bound(offset);
+		if (next != freeRanges.end() && next->first == offset + size) {
+			size += next->second;
+			next = freeRanges.erase(next);
+
+		} // if
+
+		if (next != freeRanges.begin()) {
+			auto previous = std::prev(next);
+			if (previous->first + previous->second == offset) {
+				offset = previous->first;
+				size += previous->second;
+				freeRanges.erase(previous);
+
+			} // if
+
+		} // if
+
+		freeRanges[offset] = size;
+
+	} // free
+
+} // lve
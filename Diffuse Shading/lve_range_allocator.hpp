@@ -0,0 +1,36 @@
+#pragma once
+
+// std
+#include <cstdint>
+#include <limits>
+#include <map>
+
+namespace lve {
+
+	// hands out ranges of [0, capacity) from a free list ordered by offset
+	// it never touches any memory itself, so it works for bytes in a memory block just as well as for vertices in a buffer
+	class LveRangeAllocator {
+	public:
+		static constexpr uint64_t INVALID_OFFSET = std::numeric_limits<uint64_t>::max();
+
+		explicit LveRangeAllocator(uint64_t capacity = 0);
+
+		// best fit, the smallest free range that still fits keeps the big ranges for big requests
+		// returns the aligned offset or INVALID_OFFSET, the padding in front of it stays free
+		uint64_t allocate(uint64_t size, uint64_t alignment = 1);
+
+		// gives the range back and merges it with the free ranges right before and after it
+		void free(uint64_t offset, uint64_t size);
+
+		uint64_t getCapacity() const { return capacity; } // getCapacity
+		uint64_t getFreeSize() const { return freeSize; } // getFreeSize
+		bool isEmpty() const { return freeSize == capacity; } // isEmpty
+
+	private:
+		std::map<uint64_t, uint64_t> freeRanges{}; // offset -> size
+		uint64_t capacity;
+		uint64_t freeSize;
+
+	}; // LveRangeAllocator
+
+} // lve
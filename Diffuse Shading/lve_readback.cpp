@@ -0,0 +1,227 @@
+#include "lve_readback.hpp"
+
+// std
+#include <algorithm>
+#include <stdexcept>
+
+namespace lve {
+
+	LveReadback::LveReadback(LveDevice& device, uint32_t slotCount) : lveDevice{ device }, slots(slotCount) {
+
+	} // LveReadback
+
+	LveReadback::~LveReadback() {
+		if (!fences.empty())
+			vkWaitForFences(lveDevice.device(), static_cast<uint32_t>(fences.size()), fences.data(), VK_TRUE, UINT64_MAX);
+
+		for (VkFence fence : fences)
+			vkDestroyFence(lveDevice.device(), fence, nullptr);
+
+		for (auto& slot : slots) {
+			if (slot.buffer != VK_NULL_HANDLE)
+				lveDevice.destroyBuffer(slot.buffer, slot.memory);
+
+		} // for
+
+	} // ~LveReadback
+
+	VkDeviceSize LveReadback::texelSize(VkFormat format) {
+		switch (format) {
+		case VK_FORMAT_R8G8B8A8_UNORM:
+		case VK_FORMAT_R8G8B8A8_SRGB:
+		case VK_FORMAT_B8G8R8A8_UNORM:
+		case VK_FORMAT_B8G8R8A8_SRGB:
+			return 4;
+		case VK_FORMAT_R16G16B16A16_SFLOAT:
+		case VK_FORMAT_R16G16B16A16_UNORM:
+			return 8;
+		case VK_FORMAT_R32G32B32A32_SFLOAT:
+			return 16;
+		default:
+			throw std::runtime_error("readback does not support this image format!");
+
+		} // switch
+
+	} // texelSize
+
+	std::optional<LveReadback::Handle> LveReadback::recordCopy(
+		VkCommandBuffer commandBuffer,
+		VkImage image,
+		VkImageLayout layout,
+		VkFormat format,
+		VkExtent2D extent,
+		VkPipelineStageFlags srcStageMask,
+		VkAccessFlags srcAccessMask) {
+		retire();
+
+		// round robin, so the oldest capture is the one we look at first
+		uint32_t slotIndex = nextSlot;
+		for (uint32_t i = 0; i < slots.size() && slots[slotIndex].state != SlotState::Free; i++)
+			slotIndex = (slotIndex + 1) % slots.size();
+
+		Slot& slot = slots[slotIndex];
+		if (slot.state != SlotState::Free)
+			return std::nullopt;
+
+		nextSlot = (slotIndex + 1) % slots.size();
+
+		const VkDeviceSize rowPitch = extent.width * texelSize(format);
+		const VkDeviceSize size = rowPitch * extent.height;
+		if (slot.capacity < size) {
+			// the slot is free, so nothing on the GPU uses the old buffer any more
+			if (slot.buffer != VK_NULL_HANDLE)
+				lveDevice.destroyBuffer(slot.buffer, slot.memory);
+
+			// coherent so reading it needs no invalidate, the buffer is only read once per capture anyway
+			lveDevice.createBuffer(
+				size,
+				VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+				slot.buffer,
+				slot.memory
+
+			); // createBuffer
+
+			slot.capacity = size;
+
+		} // if
+
+		VkImageMemoryBarrier toTransfer{};
+		toTransfer.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		toTransfer.srcAccessMask = srcAccessMask;
+		toTransfer.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		toTransfer.oldLayout = layout;
+		toTransfer.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		toTransfer.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		toTransfer.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		toTransfer.image = image;
+		toTransfer.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+		vkCmdPipelineBarrier(commandBuffer, srcStageMask, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &toTransfer);
+
+		VkBufferImageCopy region{};
+		region.bufferOffset = 0;
+		region.bufferRowLength = 0; // tightly packed
+		region.bufferImageHeight = 0;
+		region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+		region.imageOffset = { 0, 0, 0 };
+		region.imageExtent = { extent.width, extent.height, 1 };
+		vkCmdCopyImageToBuffer(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slot.buffer, 1, &region);
+
+		// back to where it was for whoever comes next (presentation waits on a semaphore, which covers the rest)
+		VkImageMemoryBarrier toOriginal = toTransfer;
+		toOriginal.srcAccessMask = 0;
+		toOriginal.dstAccessMask = 0;
+		toOriginal.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		toOriginal.newLayout = layout;
+
+		// and the copy made visible to the host once the fence has signalled
+		VkBufferMemoryBarrier toHost{};
+		toHost.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		toHost.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		toHost.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		toHost.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		toHost.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		toHost.buffer = slot.buffer;
+		toHost.offset = 0;
+		toHost.size = size;
+		vkCmdPipelineBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_HOST_BIT | VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+			0,
+			0, nullptr,
+			1, &toHost,
+			1, &toOriginal
+
+		); // vkCmdPipelineBarrier
+
+		slot.state = SlotState::Recorded;
+		slot.id = nextId++;
+		slot.image = { static_cast<const std::byte*>(slot.memory.mapped), extent.width, extent.height, rowPitch, format };
+		return Handle{ slotIndex, slot.id };
+
+	} // recordCopy
+
+	void LveReadback::submit(VkQueue queue) {
+		const bool recorded = std::any_of(slots.begin(), slots.end(), [](const Slot& slot) { return slot.state == SlotState::Recorded; });
+		if (!recorded)
+			return;
+
+		VkFenceCreateInfo fenceInfo{};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+		VkFence fence;
+		if (vkCreateFence(lveDevice.device(), &fenceInfo, nullptr, &fence) != VK_SUCCESS)
+			throw std::runtime_error("failed to create readback fence!");
+
+		// a submit with no work still signals its fence only after everything submitted to the queue before it,
+		// so we learn when the frame is done without touching the swap chain's own fences
+		{
+			auto queueLock = lveDevice.lockQueue(queue);
+			if (vkQueueSubmit(queue, 0, nullptr, fence) != VK_SUCCESS)
+				throw std::runtime_error("failed to submit readback fence!");
+
+		} // lock
+
+		fences.push_back(fence);
+		for (auto& slot : slots) {
+			if (slot.state == SlotState::Recorded) {
+				slot.state = SlotState::InFlight;
+				slot.fence = fence;
+
+			} // if
+
+		} // for
+
+	} // submit
+
+	void LveReadback::retire() {
+		size_t finished = 0;
+		while (finished < fences.size() && vkGetFenceStatus(lveDevice.device(), fences[finished]) == VK_SUCCESS) {
+			for (auto& slot : slots) {
+				if (slot.state == SlotState::InFlight && slot.fence == fences[finished]) {
+					slot.state = slot.id == 0 ? SlotState::Free : SlotState::Ready; // released early, nobody is waiting for it
+					slot.fence = VK_NULL_HANDLE;
+
+				} // if
+
+			} // for
+
+			vkDestroyFence(lveDevice.device(), fences[finished], nullptr);
+			finished++;
+
+		} // while
+
+		fences.erase(fences.begin(), fences.begin() + finished);
+
+	} // retire
+
+	bool LveReadback::isReady(const Handle& handle) {
+		retire();
+		const Slot& slot = slots[handle.slot];
+		return slot.id == handle.id && slot.state == SlotState::Ready;
+
+	} // isReady
+
+	std::optional<LveReadback::Image> LveReadback::getImage(const Handle& handle) {
+		if (!isReady(handle))
+			return std::nullopt;
+
+		return slots[handle.slot].image;
+
+	} // getImage
+
+	void LveReadback::release(const Handle& handle) {
+		Slot& slot = slots[handle.slot];
+		if (slot.id != handle.id)
+			return;
+
+		// a slot released while the copy is still running is only freed once it lands, see retire
+		if (slot.state == SlotState::Ready)
+			slot.state = SlotState::Free;
+		else
+			slot.id = 0;
+
+	} // release
+
+} // lve
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "lve_device.hpp"
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace lve {
+
+	// copies color images back to the CPU without waiting for the GPU, for golden image tests and capturing frames
+	// recordCopy goes into the command buffer of the frame that rendered the image, submit goes right after that
+	// command buffer has been submitted, and the pixels can be read a frame or two later once the handle is ready
+	// a few host visible buffers are reused round robin, when all of them are busy or not released yet the copy
+	// is just not recorded, so capturing can never hold up the frame loop
+	class LveReadback {
+	public:
+		struct Handle {
+			uint32_t slot;
+			uint64_t id; // so an old handle to a reused slot is never ready
+
+		}; // Handle
+
+		// tightly packed rows, rowPitch is width times the texel size
+		struct Image {
+			const std::byte* pixels;
+			uint32_t width;
+			uint32_t height;
+			VkDeviceSize rowPitch;
+			VkFormat format; // swap chains are usually BGRA
+
+		}; // Image
+
+		explicit LveReadback(LveDevice& device, uint32_t slotCount = 3);
+
+		// waits for copies still in flight
+		~LveReadback();
+
+		LveReadback(const LveReadback&) = delete;
+		LveReadback& operator=(const LveReadback&) = delete;
+
+		// the image must be in layout, have been created with VK_IMAGE_USAGE_TRANSFER_SRC_BIT, and is left in layout again
+		// srcStageMask / srcAccessMask are whatever last wrote it, by default a render pass (its dependency must reach the transfer stage)
+		// 8, 16 and 32 bit per channel RGBA / BGRA formats only
+		std::optional<Handle> recordCopy(
+			VkCommandBuffer commandBuffer,
+			VkImage image,
+			VkImageLayout layout,
+			VkFormat format,
+			VkExtent2D extent,
+			VkPipelineStageFlags srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VkAccessFlags srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT);
+
+		// queues a fence behind everything submitted to queue so far, which covers the copies recorded since the last submit
+		void submit(VkQueue queue);
+
+		bool isReady(const Handle& handle);
+
+		// nothing until the handle is ready, the pixels stay valid until release
+		std::optional<Image> getImage(const Handle& handle);
+		void release(const Handle& handle);
+
+	private:
+		enum class SlotState {
+			Free,
+			Recorded, // in a command buffer that has not been submitted yet
+			InFlight,
+			Ready
+
+		}; // SlotState
+
+		struct Slot {
+			SlotState state = SlotState::Free;
+			uint64_t id = 0;
+			VkBuffer buffer = VK_NULL_HANDLE;
+			LveAllocation memory{};
+			VkDeviceSize capacity = 0;
+			VkFence fence = VK_NULL_HANDLE; // shared with every slot of the same submit, owned by fences
+			Image image{};
+
+		}; // Slot
+
+		static VkDeviceSize texelSize(VkFormat format);
+		void retire();
+
+		LveDevice& lveDevice;
+
+		std::vector<Slot> slots;
+		std::vector<VkFence> fences{}; // in flight, in submission order
+		uint32_t nextSlot = 0;
+		uint64_t nextId = 1;
+
+	}; // LveReadback
+
+} // lve
@@ -0,0 +1,50 @@
+#pragma once
+
+// libs
+#include <vulkan/vulkan.h>
+
+// std
+#include <cstddef>
+#include <cstdint>
+
+namespace lve {
+
+	// what LveRenderer draws into, a swap chain for a window (LveSwapChain) or a ring of offscreen images (LveOffscreenTarget)
+	// the names come from the swap chain, which was here first
+	class LveRenderTarget {
+	public:
+		virtual ~LveRenderTarget() = default;
+
+		// waits for the fence of the frame that last used this frame's slot, then picks the image to draw into
+		virtual VkResult acquireNextImage(uint32_t* imageIndex) = 0;
+		virtual VkResult submitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex) = 0;
+
+		virtual VkRenderPass getRenderPass() = 0;
+		virtual VkFramebuffer getFrameBuffer(int index) = 0;
+		virtual VkImage getImage(int index) = 0;
+		// the depth the image at index was drawn with, left in DEPTH_STENCIL_READ_ONLY_OPTIMAL for compute shaders to sample
+		virtual VkImageView getDepthImageView(int index) = 0;
+		virtual VkFormat getSwapChainImageFormat() = 0;
+		virtual VkExtent2D getSwapChainExtent() = 0;
+
+		// the layout the render pass leaves the color image in
+		virtual VkImageLayout getFinalColorLayout() const = 0;
+		virtual VkPresentModeKHR getPresentMode() const = 0;
+
+		// the images can be copied from (TRANSFER_SRC)
+		virtual bool supportsReadback() const = 0;
+
+		// the GPU has finished every frame submitted through this target, a retired one can be destroyed now
+		virtual bool isIdle() const = 0;
+		// waits for the last frame submitted with this frame index, returns right away when there is none
+		virtual void waitForFrame(size_t frameIndex) const = 0;
+
+		float extentAspectRatio() {
+			const VkExtent2D extent = getSwapChainExtent();
+			return static_cast<float>(extent.width) / static_cast<float>(extent.height);
+
+		} // extentAspectRatio
+
+	}; // LveRenderTarget
+
+} // lve
@@ -7,75 +7,102 @@
 #include <iostream>
 
 namespace lve {
-	LveRenderer::LveRenderer(LveWindow& window, LveDevice& device) : lveWindow{ window }, lveDevice{device} {
+	LveRenderer::LveRenderer(LveWindow& window, LveDevice& device, const LveSwapChainConfig& config)
+		: lveWindow{ &window }, lveDevice{device}, config{ config }, readback{ device, config.framesInFlight + 1 }, gpuProfiler{ device } {
+		recreateSwapChain();
+
+	} // lveRenderer
+
+	LveRenderer::LveRenderer(LveDevice& device, VkExtent2D extent, const LveSwapChainConfig& config)
+		: headlessExtent{ extent }, lveDevice{ device }, config{ config }, readback{ device, config.framesInFlight + 1 }, gpuProfiler{ device } {
+		if (!device.isHeadless())
+			throw std::runtime_error("a headless renderer needs a headless device!");
+
 		recreateSwapChain();
-		createCommandBuffers();
 
 	} // lveRenderer
 
 	void LveRenderer::recreateSwapChain() {
-		auto extent = lveWindow.getExtent();
+		if (lveWindow == nullptr) {
+			// nothing can resize it, this only runs for a config change, the old images retire like an old swap chain
+			if (renderTarget != nullptr)
+				retiredSwapChains.push_back({ std::move(renderTarget), frameNumber });
+
+			renderTarget = std::make_unique<LveOffscreenTarget>(lveDevice, headlessExtent, config);
+			commandBuffers.assign(config.framesInFlight, VK_NULL_HANDLE);
+			currentFrameIndex = 0;
+			configChanged = false;
+			return;
+
+		} // if
+
+		auto extent = lveWindow->getExtent();
 		while (extent.width == 0 || extent.height == 0) {
-			extent = lveWindow.getExtent();
+			extent = lveWindow->getExtent();
 			glfwWaitEvents();
 
 		} // while
 
-		vkDeviceWaitIdle(lveDevice.device());
-		lveSwapChain = nullptr;
-
-		if (lveSwapChain == nullptr) {
-			lveSwapChain = std::make_unique<LveSwapChain>(lveDevice, extent);
+		// no vkDeviceWaitIdle, the frames still in flight on the old swap chain keep running while the new one is made
+		// the old one hands its images over through oldSwapchain and is destroyed in beginFrame once its frames are done
+		if (renderTarget == nullptr) {
+			renderTarget = std::make_unique<LveSwapChain>(lveDevice, extent, config);
 
 		} else {
 
-			std::shared_ptr<LveSwapChain> oldSwapChain = std::move(lveSwapChain);
-			lveSwapChain = std::make_unique<LveSwapChain>(lveDevice, extent, oldSwapChain);
+			std::shared_ptr<LveSwapChain> oldSwapChain{ static_cast<LveSwapChain*>(renderTarget.release()) };
+			auto newSwapChain = std::make_unique<LveSwapChain>(lveDevice, extent, oldSwapChain, config);
 
-			if (!oldSwapChain->compareSwapFormats(*lveSwapChain.get())) {
+			if (!oldSwapChain->compareSwapFormats(*newSwapChain)) {
 				// instead of throwing an error it would be better to make a call back notifying the app that a change has been made
 				// will be done at a later date
 				throw std::runtime_error("Swap chain image(or depth) format has changed");
 
 			} // if
 
-		} // else
+			renderTarget = std::move(newSwapChain);
+			retiredSwapChains.push_back({ std::move(oldSwapChain), frameNumber });
 
+		} // else
 
-		// .....
+		// the new swap chain starts over at its first frame, so we start over too
+		// this is also where a new frames in flight count takes effect
+		commandBuffers.assign(config.framesInFlight, VK_NULL_HANDLE);
+		currentFrameIndex = 0;
+		configChanged = false;
 
 	} // recreateSwapChain
 
-	void LveRenderer::createCommandBuffers() {
-		commandBuffers.resize(LveSwapChain::MAX_FRAMES_IN_FLIGHT);
+	void LveRenderer::destroyRetiredSwapChains() {
+		// the fences only cover rendering, presenting has no fence on Vulkan 1.0, so a retired swap chain also sits out
+		// a full round of frames on the new one, by then the presents queued before the switch have long been consumed
+		std::erase_if(retiredSwapChains, [this](const RetiredSwapChain& retired) {
+			return frameNumber >= retired.retiredAtFrame + config.framesInFlight && retired.swapChain->isIdle();
 
+		}); // erase_if
 
-		VkCommandBufferAllocateInfo allocInfo{};
-		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-		allocInfo.commandPool = lveDevice.getCommandPool();
-		// an application may need to delete an create command buffers frequently so to reduce the cost of resource creation Vulkan has us allocate and free command buffers from command pools
-		// this way the most expensive stuff of requiring memory can be done once and be reused as command buffers are created and destroyed
-		allocInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
+	} // destroyRetiredSwapChains
 
-		if (vkAllocateCommandBuffers(lveDevice.device(), &allocInfo, commandBuffers.data()) != VK_SUCCESS) {
-			throw std::runtime_error("failed to allocate command buffers");
+	void LveRenderer::setSwapChainConfig(const LveSwapChainConfig& newConfig) {
+		config = newConfig;
+		configChanged = true;
 
-		} // if
+	} // setSwapChainConfig
 
-	} // createCommandBuffers
-
-
-	void LveRenderer::freeCommandBuffers() {
-		vkFreeCommandBuffers(lveDevice.device(), lveDevice.getCommandPool(), static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
-		commandBuffers.clear();
-
-	} // freeCommandBuffers
+	void LveRenderer::setPresentPolicy(LvePresentPolicy policy) {
+		LveSwapChainConfig newConfig = config;
+		newConfig.presentPolicy = policy;
+		setSwapChainConfig(newConfig);
 
+	} // setPresentPolicy
 
 	VkCommandBuffer LveRenderer::beginFrame() {
 		assert(!isFrameStarted && "Can't call begin frame while a frame is already in progress!");
-		auto result = lveSwapChain->acquireNextImage(&currentImageIndex); // handles all the synchronization surronding double and triple buffering 
+
+		if (configChanged)
+			recreateSwapChain();
+
+		auto result = renderTarget->acquireNextImage(&currentImageIndex); // handles all the synchronization surronding double and triple buffering 
 
 		// VK_ERROR_OUT_OF_DATE_KHR: A surface that changed in such a way that is no longer compatible with the swap chain
 		if (result == VK_ERROR_OUT_OF_DATE_KHR) {
@@ -89,6 +116,23 @@ namespace lve {
 
 		} // if
 
+		// acquireNextImage waited for the fence of the last submission from this frame index, so whatever was recorded for it is done
+		// a retired swap chain has fences of its own, a frame still running on it may be using this frame index's pools too
+		for (const auto& retired : retiredSwapChains)
+			retired.swapChain->waitForFrame(currentFrameIndex);
+
+		destroyRetiredSwapChains();
+
+		// with no retired swap chain left the wait above covers every frame up to frameNumber - framesInFlight,
+		// so whatever was let go of while recording those can be freed
+		const uint64_t completedFrames = retiredSwapChains.empty() && frameNumber + 1 >= config.framesInFlight ? frameNumber + 1 - config.framesInFlight : 0;
+		lveDevice.advanceFrame(frameNumber, completedFrames);
+
+		// an application may need to delete an create command buffers frequently so to reduce the cost of resource creation Vulkan has us allocate and free command buffers from command pools
+		// this way the most expensive stuff of requiring memory can be done once and be reused as command buffers are created and destroyed
+		lveDevice.commandPools().resetFrame(currentFrameIndex);
+		commandBuffers[currentFrameIndex] = lveDevice.commandPools().allocateFrameCommandBuffer(currentFrameIndex);
+
 		isFrameStarted = true;
 		auto commandBuffer = getCurrentCommandBuffer();
 
@@ -100,6 +144,10 @@ namespace lve {
 
 		} // if
 
+		// this frame index's fences have signalled above, so the profiler can read what it measured last time around
+		gpuProfiler.beginFrame(commandBuffer, currentFrameIndex);
+		frameScope = gpuProfiler.beginScope(commandBuffer, "frame");
+
 		return commandBuffer;
 
 	} // beginFrame
@@ -107,16 +155,36 @@ namespace lve {
 	void LveRenderer::endFrame() {
 		assert(isFrameStarted && "Can't call endFrame while frame is not in progress");
 		auto commandBuffer = getCurrentCommandBuffer();
+		gpuProfiler.endScope(commandBuffer, frameScope);
 
 		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
 			throw std::runtime_error("failed to begin record command buffer!");
 
 		} // if
 
-		auto result = lveSwapChain->submitCommandBuffers(&commandBuffer, &currentImageIndex);
+		auto result = renderTarget->submitCommandBuffers(&commandBuffer, &currentImageIndex);
+		readback.submit(lveDevice.graphicsQueue()); // the command buffer was submitted even if presenting failed
+
+		isFrameStarted = false;
+		currentFrameIndex = (currentFrameIndex + 1) % config.framesInFlight;
+		frameNumber++;
+
+		// measured at the CPU, which the present mode paces once the frames in flight are used up
+		framesSinceStart++;
+		const auto now = std::chrono::steady_clock::now();
+		const float elapsed = std::chrono::duration<float>(now - frameRateStart).count();
+		if (elapsed >= 1.f) {
+			framesPerSecond = framesSinceStart / elapsed;
+			framesSinceStart = 0;
+			frameRateStart = now;
+
+		} // if
+
+		// after advancing, recreateSwapChain starts the frame index over to match the new swap chain
+		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || (lveWindow != nullptr && lveWindow->wasWindowResized())) {
+			if (lveWindow != nullptr)
+				lveWindow->resetWindowResizedFlag();
 
-		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || lveWindow.wasWindowResized()) {
-			lveWindow.resetWindowResizedFlag();
 			recreateSwapChain();
 
 		} else if (result != VK_SUCCESS) {
@@ -124,22 +192,19 @@ namespace lve {
 
 		} // if 
 
-		isFrameStarted = false;
-		currentFrameIndex = (currentFrameIndex + 1) % LveSwapChain::MAX_FRAMES_IN_FLIGHT;
-
 	} // endFrame
 
-	void LveRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer) {
+	void LveRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents) {
 		assert(isFrameStarted && "Can't call beginSwapChainRenderPass while frame is not in progress");
 		assert(commandBuffer == getCurrentCommandBuffer() && "Can't begin renderpass on command buffer from a different frame");
 
 		VkRenderPassBeginInfo renderPassInfo{};
 		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-		renderPassInfo.renderPass = lveSwapChain->getRenderPass();
- 		renderPassInfo.framebuffer = lveSwapChain->getFrameBuffer(currentImageIndex);
+		renderPassInfo.renderPass = renderTarget->getRenderPass();
+ 		renderPassInfo.framebuffer = renderTarget->getFrameBuffer(currentImageIndex);
 
  		renderPassInfo.renderArea.offset = { 0, 0 };
- 		renderPassInfo.renderArea.extent = lveSwapChain->getSwapChainExtent();
+ 		renderPassInfo.renderArea.extent = renderTarget->getSwapChainExtent();
 		 
  		std::array<VkClearValue, 2> clearValues{};
  		clearValues[0].color = { 0.01f, 0.01f, 0.01f, 1.0f }; // remeber index 0 is color and 1 is depth stencil
@@ -147,32 +212,90 @@ namespace lve {
 		 
  		renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
  		renderPassInfo.pClearValues = clearValues.data();
- 		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-
- 		VkViewport viewport{};
- 		viewport.x = 0.0f;
- 		viewport.y = 0.0f;
- 		viewport.width = static_cast<float>(lveSwapChain->getSwapChainExtent().width);
- 		viewport.height = static_cast<float>(lveSwapChain->getSwapChainExtent().height);
- 		viewport.minDepth = 0.0f;
- 		viewport.maxDepth = 1.0f;
-		VkRect2D scissor{ {0, 0}, lveSwapChain->getSwapChainExtent() };
-		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
-		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+ 		renderPassScope = gpuProfiler.beginScope(commandBuffer, "render pass");
+ 		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, contents);
+ 		renderPassContents = contents;
 
+		// with secondary command buffers the primary may only execute them, beginSecondaryCommandBuffer sets these instead
+		if (contents == VK_SUBPASS_CONTENTS_INLINE)
+			setViewportAndScissor(commandBuffer);
 
 	} // beginSwapChainRenderPass
 
+	VkCommandBuffer LveRenderer::beginSecondaryCommandBuffer() {
+		assert(isFrameStarted && "Can't call beginSecondaryCommandBuffer while frame is not in progress");
+		assert(renderPassContents == VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS && "The render pass has to be begun for secondary command buffers");
+
+		// the calling thread's own pool for this frame, so every worker can record at the same time
+		VkCommandBuffer commandBuffer = lveDevice.commandPools().allocateFrameCommandBuffer(currentFrameIndex, VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+
+		// the framebuffer is optional but lets the driver skip work it would otherwise have to do when it is executed
+		VkCommandBufferInheritanceInfo inheritanceInfo{};
+		inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		inheritanceInfo.renderPass = renderTarget->getRenderPass();
+		inheritanceInfo.subpass = 0;
+		inheritanceInfo.framebuffer = renderTarget->getFrameBuffer(currentImageIndex);
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+		if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+			throw std::runtime_error("failed to begin recording secondary command buffer!");
+
+		} // if
+
+		// dynamic state is not inherited from the primary
+		setViewportAndScissor(commandBuffer);
+		return commandBuffer;
+
+	} // beginSecondaryCommandBuffer
+
+	void LveRenderer::setViewportAndScissor(VkCommandBuffer commandBuffer) {
+		VkViewport viewport{};
+		viewport.x = 0.0f;
+		viewport.y = 0.0f;
+		viewport.width = static_cast<float>(renderTarget->getSwapChainExtent().width);
+		viewport.height = static_cast<float>(renderTarget->getSwapChainExtent().height);
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+		VkRect2D scissor{ {0, 0}, renderTarget->getSwapChainExtent() };
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+	} // setViewportAndScissor
+
 	void LveRenderer::endSwapChainRenderPass(VkCommandBuffer commandBuffer) {
 		assert(isFrameStarted && "Can't call endSwapChainRenderPass while frame is not in progress");
 		assert(commandBuffer == getCurrentCommandBuffer() && "Can't begin renderpass on command buffer from a different frame");
 			
 		vkCmdEndRenderPass(commandBuffer);
+		renderPassContents = VK_SUBPASS_CONTENTS_INLINE;
+		gpuProfiler.endScope(commandBuffer, renderPassScope);
 
 	} // endSwapChainRenderPass
 
+	std::optional<LveReadback::Handle> LveRenderer::captureFrame() {
+		assert(isFrameStarted && "Can't call captureFrame while frame is not in progress");
+		if (!renderTarget->supportsReadback())
+			return std::nullopt;
+
+		// the render pass left the image ready to present (or to copy when headless), the readback puts it back that way
+		return readback.recordCopy(
+			getCurrentCommandBuffer(),
+			renderTarget->getImage(currentImageIndex),
+			renderTarget->getFinalColorLayout(),
+			renderTarget->getSwapChainImageFormat(),
+			renderTarget->getSwapChainExtent()
+
+		); // recordCopy
+
+	} // captureFrame
+
 	LveRenderer::~LveRenderer() {
-		freeCommandBuffers();
+		// the command buffers go with the device's pools
+		// the retired swap chains go with us, the app has waited for the device before letting the renderer go
 
 	} // ~LveRenderer
 
@@ -3,17 +3,26 @@
 #include "lve_window.hpp"
 #include "lve_device.hpp"
 #include "lve_swap_chain.hpp"
+#include "lve_offscreen_target.hpp"
+#include "lve_readback.hpp"
+#include "lve_gpu_profiler.hpp"
 
 // std
 #include <memory>
+#include <optional>
 #include <vector>
 #include <cassert>
+#include <chrono>
+#include <cstdint>
 
 namespace lve {
 
     class LveRenderer {
     public:
-        LveRenderer(LveWindow &window, LveDevice &device);
+        LveRenderer(LveWindow &window, LveDevice &device, const LveSwapChainConfig& config = {});
+        // headless, draws into an LveOffscreenTarget of this size with the same beginFrame / endFrame as a window
+        // the device has to be headless too
+        LveRenderer(LveDevice& device, VkExtent2D extent, const LveSwapChainConfig& config = {});
         ~LveRenderer();
 
         LveRenderer(const LveRenderer&) = delete;
@@ -21,9 +30,26 @@ namespace lve {
 
         VkCommandBuffer beginFrame();
         void endFrame();
-        void beginSwapChainRenderPass(VkCommandBuffer commandBuffer);
+        // VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS to record the pass on several threads with beginSecondaryCommandBuffer,
+        // the primary can then only vkCmdExecuteCommands them until endSwapChainRenderPass
+        void beginSwapChainRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
         void endSwapChainRenderPass(VkCommandBuffer commandBuffer);
 
+        // safe to call from any thread while the swap chain render pass is begun for secondary command buffers
+        // it continues that render pass with viewport and scissor already set, end it with vkEndCommandBuffer on the same thread
+        // and execute it from the frame's command buffer, it is only valid for this frame
+        VkCommandBuffer beginSecondaryCommandBuffer();
+
+        // copies the frame being recorded back to the CPU, call it after endSwapChainRenderPass
+        // poll the handle with getReadback() and release it once the pixels have been used
+        // nothing if the surface does not allow it or every readback slot is still busy
+        std::optional<LveReadback::Handle> captureFrame();
+        LveReadback& getReadback() { return readback; } // getReadback
+
+        // the renderer measures "frame" and "render pass" itself, open more scopes with LveGpuProfiler::Scope
+        // between beginFrame and endFrame
+        LveGpuProfiler& getGpuProfiler() { return gpuProfiler; } // getGpuProfiler
+
         bool isFrameInProgress() const { return isFrameStarted; } // isFrameInProgress
 
         VkCommandBuffer getCurrentCommandBuffer() const { 
@@ -32,12 +58,36 @@ namespace lve {
 
         } // getCurrentCommandBuffer
 
+        // the depth of the frame being recorded, readable by compute shaders after endSwapChainRenderPass
+        VkImageView getDepthImageView() const {
+            assert(isFrameStarted && "Cannot get the depth image when frame not in progress");
+            return renderTarget->getDepthImageView(static_cast<int>(currentImageIndex));
+
+        } // getDepthImageView
+
         VkRenderPass getSwapChainRenderPass() const {
-            return lveSwapChain->getRenderPass();
+            return renderTarget->getRenderPass();
 
         } // getSwapChainRenderPass
 
-        float getAspectRatio() const { return lveSwapChain->extentAspectRatio(); } // getAspectRatio
+        float getAspectRatio() const { return renderTarget->extentAspectRatio(); } // getAspectRatio
+        VkExtent2D getExtent() const { return renderTarget->getSwapChainExtent(); } // getExtent
+        bool isHeadless() const { return lveWindow == nullptr; } // isHeadless
+
+        // anything kept per frame (uniform buffers, descriptor sets, ...) needs this many copies, indexed by getFrameIndex
+        // it only changes through setSwapChainConfig
+        uint32_t getFramesInFlight() const { return config.framesInFlight; } // getFramesInFlight
+        const LveSwapChainConfig& getSwapChainConfig() const { return config; } // getSwapChainConfig
+
+        // takes effect at the start of the next frame, which recreates the swap chain with it
+        void setSwapChainConfig(const LveSwapChainConfig& newConfig);
+        void setPresentPolicy(LvePresentPolicy policy);
+
+        // the mode the policy ended up as, surfaces do not have to support all of them, headless is always immediate
+        VkPresentModeKHR getPresentMode() const { return renderTarget->getPresentMode(); } // getPresentMode
+
+        // frames actually presented per second, averaged over about the last second
+        float getFramesPerSecond() const { return framesPerSecond; } // getFramesPerSecond
 
         int getFrameIndex() const { 
             assert(isFrameStarted && "Cannot get a frame index when frame not in progress");
@@ -47,19 +97,42 @@ namespace lve {
 
     private:
 
-        void createCommandBuffers();
+        struct RetiredSwapChain {
+            std::shared_ptr<LveRenderTarget> swapChain;
+            uint64_t retiredAtFrame;
+
+        }; // RetiredSwapChain
+
         void recreateSwapChain();
-        void freeCommandBuffers();
+        void destroyRetiredSwapChains();
+        void setViewportAndScissor(VkCommandBuffer commandBuffer);
 
-        LveWindow& lveWindow;
+        LveWindow* lveWindow = nullptr; // nullptr when headless
+        VkExtent2D headlessExtent{};
         LveDevice& lveDevice;
 
-        std::unique_ptr<LveSwapChain> lveSwapChain;
+        LveSwapChainConfig config;
+        bool configChanged = false;
+
+        std::unique_ptr<LveRenderTarget> renderTarget; // an LveSwapChain, or an LveOffscreenTarget when headless
+        // replaced on a resize or config change but maybe still in use by frames in flight, images, framebuffers and depth included
+        std::vector<RetiredSwapChain> retiredSwapChains;
+        LveReadback readback;
+        LveGpuProfiler gpuProfiler;
+        uint32_t frameScope = LveGpuProfiler::INVALID_SCOPE;
+        uint32_t renderPassScope = LveGpuProfiler::INVALID_SCOPE;
+        // allocated from the device's frame pools in beginFrame, the pool for a frame index is reset as soon as its fence has signalled
         std::vector<VkCommandBuffer> commandBuffers;
 
         uint32_t currentImageIndex; 
-        int currentFrameIndex;
+        int currentFrameIndex = 0;
         bool isFrameStarted = false;
+        VkSubpassContents renderPassContents = VK_SUBPASS_CONTENTS_INLINE;
+        uint64_t frameNumber = 0; // frames ended since the start
+
+        std::chrono::steady_clock::time_point frameRateStart = std::chrono::steady_clock::now();
+        uint32_t framesSinceStart = 0;
+        float framesPerSecond = 0.f;
 
     }; // FirstApp
 
@@ -0,0 +1,138 @@
+#include "lve_staging_ring.hpp"
+#include "lve_device.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace lve {
+
+	LveStagingRing::LveStagingRing(LveDevice& device, VkDeviceSize size) : lveDevice{ device }, capacity{ size } {
+		lveDevice.createBuffer(
+			capacity,
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			buffer,
+			memory
+
+		); // createBuffer
+
+		stats.capacity = capacity;
+
+	} // LveStagingRing
+
+	LveStagingRing::~LveStagingRing() {
+		assert(blocks.empty() && "Every staging region must be released before the ring");
+		lveDevice.destroyBuffer(buffer, memory);
+
+	} // ~LveStagingRing
+
+	LveStagingRegion LveStagingRing::allocate(VkDeviceSize size, VkDeviceSize alignment) {
+		assert(size > 0 && "Staging regions can not be empty");
+
+		if (size > capacity / 2)
+			return allocateTemporary(size);
+
+		std::unique_lock<std::mutex> lock{ mutex };
+
+		// the live regions sit between the oldest one and head, possibly wrapping around the end
+		VkDeviceSize offset = (head + alignment - 1) / alignment * alignment;
+		if (blocks.empty()) {
+			offset = 0;
+
+		} // if
+		else {
+			const VkDeviceSize tail = blocks.front().offset;
+			if (head > tail) {
+				// free space is after head and before tail, skip the end of the buffer if it is too short
+				if (offset + size > capacity)
+					offset = 0;
+
+				if (offset == 0 && size > tail)
+					offset = capacity; // does not fit
+
+			} // if
+			else if (offset + size > tail)
+				offset = capacity; // head caught up with tail, only space between them
+
+		} // else
+
+		if (offset + size > capacity) {
+			lock.unlock();
+			return allocateTemporary(size);
+
+		} // if
+
+		// the padding skipped when wrapping is freed together with the region before it, tail jumps straight to the next offset
+		blocks.push_back({ offset, offset + size, false });
+		head = offset + size;
+		stats.liveRegions++;
+
+		LveStagingRegion region{};
+		region.buffer = buffer;
+		region.offset = offset;
+		region.size = size;
+		region.mapped = static_cast<std::byte*>(memory.mapped) + offset;
+		return region;
+
+	} // allocate
+
+	LveStagingRegion LveStagingRing::allocateTemporary(VkDeviceSize size) {
+		LveStagingRegion region{};
+		lveDevice.createBuffer(
+			size,
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			region.buffer,
+			region.temporaryMemory
+
+		); // createBuffer
+
+		region.size = size;
+		region.mapped = static_cast<std::byte*>(region.temporaryMemory.mapped);
+
+		std::lock_guard<std::mutex> lock{ mutex };
+		stats.temporaryAllocations++;
+		return region;
+
+	} // allocateTemporary
+
+	void LveStagingRing::release(const LveStagingRegion& region) {
+		if (region.isTemporary()) {
+			lveDevice.destroyBuffer(region.buffer, region.temporaryMemory);
+			return;
+
+		} // if
+
+		std::lock_guard<std::mutex> lock{ mutex };
+
+		auto block = std::find_if(blocks.begin(), blocks.end(), [&](const Block& block) { return block.offset == region.offset && !block.released; });
+		assert(block != blocks.end() && "Staging region does not belong to this ring");
+		block->released = true;
+		stats.liveRegions--;
+
+		while (!blocks.empty() && blocks.front().released)
+			blocks.pop_front();
+
+		// with nothing live we can start over at the front and get the longest run of free space
+		if (blocks.empty())
+			head = 0;
+
+	} // release
+
+	LveStagingRing::Stats LveStagingRing::getStats() {
+		std::lock_guard<std::mutex> lock{ mutex };
+
+		Stats current = stats;
+		if (!blocks.empty()) {
+			const VkDeviceSize tail = blocks.front().offset;
+			current.usedBytes = head > tail ? head - tail : capacity - tail + head;
+
+		} // if
+
+		return current;
+
+	} // getStats
+
+} // lve
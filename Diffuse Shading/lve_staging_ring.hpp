@@ -0,0 +1,82 @@
+#pragma once
+
+#include "lve_memory_allocator.hpp"
+
+// libs
+#include <vulkan/vulkan.h>
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
+namespace lve {
+
+	class LveDevice;
+
+	// somewhere to write upload data to, copy from buffer at offset
+	struct LveStagingRegion {
+		VkBuffer buffer = VK_NULL_HANDLE;
+		VkDeviceSize offset = 0;
+		VkDeviceSize size = 0;
+		std::byte* mapped = nullptr;
+		LveAllocation temporaryMemory{}; // only set when the ring could not fit it and buffer is a staging buffer of its own
+
+		bool isTemporary() const { return temporaryMemory.memory != VK_NULL_HANDLE; } // isTemporary
+
+	}; // LveStagingRegion
+
+	// one host visible buffer that stays mapped, uploads take turns writing through it front to back and wrap around
+	// instead of each creating, filling and destroying a staging buffer of their own
+	// a region is released once the copy out of it has finished (LveUploadBatch does that when its ticket completes),
+	// space only comes back in the order it was handed out, so a region released early waits for the ones before it
+	// anything bigger than half the ring, or that does not fit while the ring is busy, gets a temporary buffer instead
+	class LveStagingRing {
+	public:
+		static constexpr VkDeviceSize DEFAULT_SIZE = 16ull * 1024 * 1024;
+
+		struct Stats {
+			VkDeviceSize capacity = 0;
+			VkDeviceSize usedBytes = 0; // including the padding skipped at the end when wrapping around
+			uint32_t liveRegions = 0;
+			uint32_t temporaryAllocations = 0; // since the start, these are the uploads the ring could not take
+
+		}; // Stats
+
+		LveStagingRing(LveDevice& device, VkDeviceSize size = DEFAULT_SIZE);
+		~LveStagingRing();
+
+		LveStagingRing(const LveStagingRing&) = delete;
+		LveStagingRing& operator=(const LveStagingRing&) = delete;
+
+		// never blocks, so a worker can stage while the thread that frees regions is busy
+		LveStagingRegion allocate(VkDeviceSize size, VkDeviceSize alignment = 16);
+		void release(const LveStagingRegion& region);
+
+		Stats getStats();
+
+	private:
+		struct Block {
+			VkDeviceSize offset;
+			VkDeviceSize end;
+			bool released;
+
+		}; // Block
+
+		LveStagingRegion allocateTemporary(VkDeviceSize size);
+
+		LveDevice& lveDevice;
+
+		VkBuffer buffer = VK_NULL_HANDLE;
+		LveAllocation memory{};
+		VkDeviceSize capacity;
+
+		std::mutex mutex; // models are staged on worker threads
+		std::deque<Block> blocks{}; // live regions in the order they were handed out
+		VkDeviceSize head = 0; // where the next region goes
+		Stats stats{};
+
+	}; // LveStagingRing
+
+} // lve
@@ -1,6 +1,7 @@
 #include "lve_swap_chain.hpp"
 
 // std
+#include <algorithm>
 #include <array>
 #include <cstdlib>
 #include <cstring>
@@ -12,21 +13,27 @@
 
 namespace lve {
 
-    LveSwapChain::LveSwapChain(LveDevice& deviceRef, VkExtent2D extent) : device{ deviceRef }, windowExtent{ extent } {
+    LveSwapChain::LveSwapChain(LveDevice& deviceRef, VkExtent2D extent, const LveSwapChainConfig& config)
+        : device{ deviceRef }, windowExtent{ extent }, config{ config } {
         init();
 
     } // LveSwapChain
 
-    LveSwapChain::LveSwapChain(LveDevice& deviceRef, VkExtent2D extent, std::shared_ptr<LveSwapChain> previous)
-        : device{ deviceRef }, windowExtent{ extent }, oldSwapChain{ previous } {
+    LveSwapChain::LveSwapChain(LveDevice& deviceRef, VkExtent2D extent, std::shared_ptr<LveSwapChain> previous, const LveSwapChainConfig& config)
+        : device{ deviceRef }, windowExtent{ extent }, config{ config }, oldSwapChain{ previous } {
 
         init();
-        // clean up the old swap chain as its no longer needed
+        // only needed for createInfo.oldSwapchain, whoever handed it to us decides when it is destroyed
+        // which has to wait until the frames still in flight on it are done
         oldSwapChain = nullptr;
 
     } // LveSwapChain(LveDevice& deviceRef, VkExtent2D windowExtent, std::shared_ptr<LveSwapChain> previous)
 
     void LveSwapChain::init() {
+        if (config.framesInFlight == 0) {
+            throw std::runtime_error("a swap chain needs at least one frame in flight!");
+        }
+
         createSwapChain();
         createImageViews();
         createRenderPass();
@@ -49,8 +56,7 @@ namespace lve {
 
         for (int i = 0; i < depthImages.size(); i++) {
             vkDestroyImageView(device.device(), depthImageViews[i], nullptr);
-            vkDestroyImage(device.device(), depthImages[i], nullptr);
-            vkFreeMemory(device.device(), depthImageMemorys[i], nullptr);
+            device.destroyImage(depthImages[i], depthImageMemorys[i]);
         }
 
         for (auto framebuffer : swapChainFramebuffers) {
@@ -60,17 +66,36 @@ namespace lve {
         vkDestroyRenderPass(device.device(), renderPass, nullptr);
 
         // cleanup synchronization objects
-        for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        for (size_t i = 0; i < inFlightFences.size(); i++) {
             vkDestroySemaphore(device.device(), renderFinishedSemaphores[i], nullptr);
             vkDestroySemaphore(device.device(), imageAvailableSemaphores[i], nullptr);
             vkDestroyFence(device.device(), inFlightFences[i], nullptr);
         }
     }
 
+    bool LveSwapChain::isIdle() const {
+        for (VkFence fence : inFlightFences) {
+            if (vkGetFenceStatus(device.device(), fence) != VK_SUCCESS)
+                return false;
+
+        } // for
+
+        return true;
+
+    } // isIdle
+
+    void LveSwapChain::waitForFrame(size_t frameIndex) const {
+        if (frameIndex >= inFlightFences.size())
+            return;
+
+        vkWaitForFences(device.device(), 1, &inFlightFences[frameIndex], VK_TRUE, std::numeric_limits<uint64_t>::max());
+
+    } // waitForFrame
+
     VkResult LveSwapChain::acquireNextImage(uint32_t* imageIndex) {
-        // After two command buffers have been submitted, the CPU will block on the next call to aquire the next image function 
+        // After framesInFlight command buffers have been submitted, the CPU will block on the next call to aquire the next image function 
         // Once the gpu has finished executing one of the command buffers, it will signal the CPU to carry on
-        // therefore, it is possible to get away with only using 2 command buffers
+        // therefore, it is possible to get away with only using framesInFlight command buffers
         vkWaitForFences( // CPU will wait here
             device.device(),
             1,
@@ -113,9 +138,13 @@ namespace lve {
         submitInfo.pSignalSemaphores = signalSemaphores;
 
         vkResetFences(device.device(), 1, &inFlightFences[currentFrame]);
-        if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) !=
-            VK_SUCCESS) {
-            throw std::runtime_error("failed to submit draw command buffer!");
+        {
+            // loader threads submit to this queue too
+            auto queueLock = device.lockQueue(device.graphicsQueue());
+            if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) !=
+                VK_SUCCESS) {
+                throw std::runtime_error("failed to submit draw command buffer!");
+            }
         }
 
         VkPresentInfoKHR presentInfo = {};
@@ -130,9 +159,13 @@ namespace lve {
 
         presentInfo.pImageIndices = imageIndex;
 
-        auto result = vkQueuePresentKHR(device.presentQueue(), &presentInfo);
+        VkResult result;
+        {
+            auto queueLock = device.lockQueue(device.presentQueue());
+            result = vkQueuePresentKHR(device.presentQueue(), &presentInfo);
+        }
 
-        currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+        currentFrame = (currentFrame + 1) % config.framesInFlight;
 
         return result;
     }
@@ -141,10 +174,11 @@ namespace lve {
         SwapChainSupportDetails swapChainSupport = device.getSwapChainSupport();
 
         VkSurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(swapChainSupport.formats);
-        VkPresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
+        presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
         VkExtent2D extent = chooseSwapExtent(swapChainSupport.capabilities);
 
-        uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
+        uint32_t imageCount = config.imageCount > 0 ? config.imageCount : swapChainSupport.capabilities.minImageCount + 1;
+        imageCount = std::max(imageCount, swapChainSupport.capabilities.minImageCount);
         if (swapChainSupport.capabilities.maxImageCount > 0 &&
             imageCount > swapChainSupport.capabilities.maxImageCount) {
             imageCount = swapChainSupport.capabilities.maxImageCount;
@@ -161,6 +195,13 @@ namespace lve {
         createInfo.imageArrayLayers = 1;
         createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
 
+        // so frames can be read back, see LveReadback
+        readbackSupported = (swapChainSupport.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) != 0;
+        if (readbackSupported) {
+            createInfo.imageUsage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+
+        } // if
+
         QueueFamilyIndices indices = device.findPhysicalQueueFamilies();
         uint32_t queueFamilyIndices[] = { indices.graphicsFamily, indices.presentFamily };
 
@@ -226,11 +267,12 @@ namespace lve {
         depthAttachment.format = findDepthFormat();
         depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
         depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-        depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        // kept for LveGpuCulling, which builds its occlusion pyramid out of it after the pass
+        depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
         depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
         depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
         depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
 
         VkAttachmentReference depthAttachmentRef{};
         depthAttachmentRef.attachment = 1;
@@ -259,14 +301,26 @@ namespace lve {
         VkSubpassDependency dependency = {};
         dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
         dependency.srcAccessMask = 0;
+        // the compute stage for the last read of the depth image, clearing it must not overtake that
         dependency.srcStageMask =
-            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
         dependency.dstSubpass = 0;
         dependency.dstStageMask =
             VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
         dependency.dstAccessMask =
             VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
 
+        // the implicit dependency at the end of the render pass only reaches BOTTOM_OF_PIPE, a frame capture copies the
+        // color image right after the pass, so the writes and the transition to the final layout have to reach the transfer stage
+        // and the depth writes the compute stage that reads them
+        std::array<VkSubpassDependency, 2> dependencies = { dependency, VkSubpassDependency{} };
+        dependencies[1].srcSubpass = 0;
+        dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+        dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+        dependencies[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+        dependencies[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+
         std::array<VkAttachmentDescription, 2> attachments = { colorAttachment, depthAttachment };
         VkRenderPassCreateInfo renderPassInfo = {};
         renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
@@ -274,8 +328,8 @@ namespace lve {
         renderPassInfo.pAttachments = attachments.data();
         renderPassInfo.subpassCount = 1;
         renderPassInfo.pSubpasses = &subpass;
-        renderPassInfo.dependencyCount = 1;
-        renderPassInfo.pDependencies = &dependency;
+        renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+        renderPassInfo.pDependencies = dependencies.data();
 
         if (vkCreateRenderPass(device.device(), &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
             throw std::runtime_error("failed to create render pass!");
@@ -328,7 +382,7 @@ namespace lve {
             imageInfo.format = depthFormat;
             imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
             imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-            imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+            imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
             imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
             imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
             imageInfo.flags = 0;
@@ -357,9 +411,9 @@ namespace lve {
     }
 
     void LveSwapChain::createSyncObjects() {
-        imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-        renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-        inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
+        imageAvailableSemaphores.resize(config.framesInFlight);
+        renderFinishedSemaphores.resize(config.framesInFlight);
+        inFlightFences.resize(config.framesInFlight);
         imagesInFlight.resize(imageCount(), VK_NULL_HANDLE);
 
         VkSemaphoreCreateInfo semaphoreInfo = {};
@@ -369,7 +423,7 @@ namespace lve {
         fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
         fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
-        for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        for (size_t i = 0; i < config.framesInFlight; i++) {
             if (vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &imageAvailableSemaphores[i]) !=
                 VK_SUCCESS ||
                 vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]) !=
@@ -394,26 +448,60 @@ namespace lve {
 
     VkPresentModeKHR LveSwapChain::chooseSwapPresentMode(
         const std::vector<VkPresentModeKHR>& availablePresentModes) {
+        auto available = [&](VkPresentModeKHR mode) {
+            return std::find(availablePresentModes.begin(), availablePresentModes.end(), mode) != availablePresentModes.end();
 
-        // if I want to use V-Sync only then I can comment out these lines 
-        for (const auto& availablePresentMode : availablePresentModes) {
-            if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR) {
-                std::cout << "Present mode: Mailbox" << std::endl;
-                return availablePresentMode;
-            }
-        }
+        }; // available
+
+        // in order of preference, FIFO is always there so it ends every list
+        std::vector<VkPresentModeKHR> preferred{};
+        switch (config.presentPolicy) {
+        case LvePresentPolicy::VSync:
+            break;
+        case LvePresentPolicy::LowLatency:
+            preferred = { VK_PRESENT_MODE_MAILBOX_KHR };
+            break;
+        case LvePresentPolicy::Uncapped:
+            // Immediate does not always update the current refresh cycle, so it can tear
+            preferred = { VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR };
+            break;
+        case LvePresentPolicy::AdaptiveVSync:
+            preferred = { VK_PRESENT_MODE_FIFO_RELAXED_KHR };
+            break;
+
+        } // switch
+
+        preferred.push_back(VK_PRESENT_MODE_FIFO_KHR);
 
-        // Immediate does not always update the current refresh cycle
-        // for (const auto &availablePresentMode : availablePresentModes) {
-        //   if (availablePresentMode == VK_PRESENT_MODE_IMMEDIATE_KHR) {
-        //     std::cout << "Present mode: Immediate" << std::endl;
-        //     return availablePresentMode;
-        //   }
-        // }
+        for (VkPresentModeKHR mode : preferred) {
+            if (mode == VK_PRESENT_MODE_FIFO_KHR || available(mode)) {
+                std::cout << "Present mode: " << presentModeName(mode) << std::endl;
+                return mode;
+
+            } // if
+
+        } // for
 
-        std::cout << "Present mode: V-Sync" << std::endl;
         return VK_PRESENT_MODE_FIFO_KHR;
-    }
+
+    } // chooseSwapPresentMode
+
+    const char* LveSwapChain::presentModeName(VkPresentModeKHR mode) {
+        switch (mode) {
+        case VK_PRESENT_MODE_IMMEDIATE_KHR:
+            return "Immediate";
+        case VK_PRESENT_MODE_MAILBOX_KHR:
+            return "Mailbox";
+        case VK_PRESENT_MODE_FIFO_KHR:
+            return "V-Sync";
+        case VK_PRESENT_MODE_FIFO_RELAXED_KHR:
+            return "Adaptive V-Sync";
+        default:
+            return "Unknown";
+
+        } // switch
+
+    } // presentModeName
 
     VkExtent2D LveSwapChain::chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities) {
         if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max()) {
@@ -436,7 +524,7 @@ namespace lve {
         return device.findSupportedFormat(
             { VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT },
             VK_IMAGE_TILING_OPTIMAL,
-            VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
+            VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
     }
 
 }  // namespace lve
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "lve_device.hpp"
+#include "lve_render_target.hpp"
 
 // vulkan headers
 #include <vulkan/vulkan.h>
@@ -12,36 +13,61 @@
 
 namespace lve {
 
-    class LveSwapChain {
-    public:
-        static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
+    // how presenting is paced, each falls back to FIFO (V-Sync) when the surface does not have its mode
+    enum class LvePresentPolicy {
+        VSync, // FIFO, waits for vertical blank, never tears, the only mode every surface has, easiest on power
+        LowLatency, // MAILBOX, renders uncapped but only the newest frame is shown at vertical blank, no tearing
+        Uncapped, // IMMEDIATE, shows frames as soon as they are done and may tear, for benchmarking, falls back to MAILBOX first
+        AdaptiveVSync // FIFO_RELAXED, V-Sync unless a frame is late, which is then shown right away and may tear
+
+    }; // LvePresentPolicy
+
+    // latency against throughput, fixed for the life of a swap chain
+    struct LveSwapChainConfig {
+        // how many frames the CPU may record ahead of the GPU, 1 for the lowest latency, 3 to ride out CPU spikes
+        uint32_t framesInFlight = 2;
+        // images to ask the surface for, 0 is minImageCount + 1, always clamped to what the surface allows
+        uint32_t imageCount = 0;
+        LvePresentPolicy presentPolicy = LvePresentPolicy::LowLatency;
+
+    }; // LveSwapChainConfig
 
-        LveSwapChain(LveDevice& deviceRef, VkExtent2D windowExtent);
-        LveSwapChain(LveDevice& deviceRef, VkExtent2D windowExtent, std::shared_ptr<LveSwapChain> previous);
+    class LveSwapChain : public LveRenderTarget {
+    public:
+        LveSwapChain(LveDevice& deviceRef, VkExtent2D windowExtent, const LveSwapChainConfig& config = {});
+        LveSwapChain(LveDevice& deviceRef, VkExtent2D windowExtent, std::shared_ptr<LveSwapChain> previous, const LveSwapChainConfig& config = {});
 
         ~LveSwapChain();
 
         LveSwapChain(const LveSwapChain&) = delete;
         LveSwapChain& operator=(const LveSwapChain&) = delete;
 
-        VkFramebuffer getFrameBuffer(int index) { return swapChainFramebuffers[index]; }
-        VkRenderPass getRenderPass() { return renderPass; }
+        VkFramebuffer getFrameBuffer(int index) override { return swapChainFramebuffers[index]; }
+        VkRenderPass getRenderPass() override { return renderPass; }
         VkImageView getImageView(int index) { return swapChainImageViews[index]; }
+        VkImage getImage(int index) override { return swapChainImages[index]; }
+        VkImageView getDepthImageView(int index) override { return depthImageViews[index]; } // getDepthImageView
         size_t imageCount() { return swapChainImages.size(); }
-        VkFormat getSwapChainImageFormat() { return swapChainImageFormat; }
-        VkExtent2D getSwapChainExtent() { return swapChainExtent; }
+        uint32_t framesInFlight() const { return config.framesInFlight; }
+        VkPresentModeKHR getPresentMode() const override { return presentMode; } // what presentPolicy ended up as on this surface
+        VkFormat getSwapChainImageFormat() override { return swapChainImageFormat; }
+        VkExtent2D getSwapChainExtent() override { return swapChainExtent; }
+        VkImageLayout getFinalColorLayout() const override { return VK_IMAGE_LAYOUT_PRESENT_SRC_KHR; } // getFinalColorLayout
         uint32_t width() const { return swapChainExtent.width; }
         uint32_t height() const { return swapChainExtent.height; }
 
-        float extentAspectRatio() {
-            return static_cast<float>(swapChainExtent.width) / static_cast<float>(swapChainExtent.height);
-
-        } // extentAspectRatio
+        // the images can be copied from (TRANSFER_SRC), which surfaces do not have to allow
+        bool supportsReadback() const override { return readbackSupported; } // supportsReadback
 
         VkFormat findDepthFormat();
 
-        VkResult acquireNextImage(uint32_t* imageIndex);
-        VkResult submitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex);
+        static const char* presentModeName(VkPresentModeKHR mode);
+
+        bool isIdle() const override;
+        void waitForFrame(size_t frameIndex) const override;
+
+        VkResult acquireNextImage(uint32_t* imageIndex) override;
+        VkResult submitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex) override;
 
         bool compareSwapFormats(const LveSwapChain& swapChain) const {
             return swapChain.swapChainDepthFormat == swapChainDepthFormat && swapChain.swapChainImageFormat == swapChainImageFormat;
@@ -62,7 +88,7 @@ namespace lve {
 
         // handles how the synchronization handles our display
         // the only support mode guaranteed to be supported is FIFO
-        // otherwise check vulkan docs on which mode to use
+        // the others are picked through config.presentPolicy when the surface has them
         VkPresentModeKHR chooseSwapPresentMode(
             const std::vector<VkPresentModeKHR>& availablePresentModes);
         VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities);
@@ -70,18 +96,21 @@ namespace lve {
         VkFormat swapChainImageFormat;
         VkFormat swapChainDepthFormat;
         VkExtent2D swapChainExtent;
+        bool readbackSupported = false;
+        VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;
 
         std::vector<VkFramebuffer> swapChainFramebuffers;
         VkRenderPass renderPass;
 
         std::vector<VkImage> depthImages;
-        std::vector<VkDeviceMemory> depthImageMemorys;
+        std::vector<LveAllocation> depthImageMemorys;
         std::vector<VkImageView> depthImageViews;
         std::vector<VkImage> swapChainImages;
         std::vector<VkImageView> swapChainImageViews;
         
         LveDevice& device;
         VkExtent2D windowExtent;
+        LveSwapChainConfig config;
 
         VkSwapchainKHR swapChain;
         std::shared_ptr<LveSwapChain> oldSwapChain;
@@ -0,0 +1,55 @@
+#include "lve_thread_pool.hpp"
+
+// std
+#include <algorithm>
+
+namespace lve {
+
+	LveThreadPool::LveThreadPool(uint32_t threadCount) {
+		if (threadCount == 0)
+			threadCount = std::max(2u, std::thread::hardware_concurrency()) - 1;
+
+		threads.reserve(threadCount);
+		for (uint32_t i = 0; i < threadCount; i++)
+			threads.emplace_back([this]() { workerLoop(); });
+
+	} // LveThreadPool
+
+	LveThreadPool::~LveThreadPool() {
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			stopping = true;
+
+		} // lock
+
+		jobAvailable.notify_all();
+		for (auto& thread : threads)
+			thread.join();
+
+	} // ~LveThreadPool
+
+	void LveThreadPool::workerLoop() {
+		while (true) {
+			std::function<void()> job;
+
+			{
+				std::unique_lock<std::mutex> lock{ mutex };
+				jobAvailable.wait(lock, [this]() { return stopping || !jobs.empty(); });
+
+				// only stop once the queue is drained, nobody is left waiting on a future that will never be set
+				if (jobs.empty())
+					return;
+
+				job = std::move(jobs.front());
+				jobs.pop();
+
+			} // lock
+
+			// packaged_task catches whatever the job throws and stores it in the future
+			job();
+
+		} // while
+
+	} // workerLoop
+
+} // lve
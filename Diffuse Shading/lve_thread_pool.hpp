@@ -0,0 +1,61 @@
+#pragma once
+
+// std
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace lve {
+
+	// a fixed set of worker threads pulling jobs off one shared queue
+	// starting a thread per job costs more than most of our jobs, so the threads live as long as the pool
+	class LveThreadPool {
+	public:
+		// 0 picks one thread per hardware thread minus the one the caller keeps for itself, but always at least one
+		explicit LveThreadPool(uint32_t threadCount = 0);
+
+		// jobs that are already queued still run, then the threads are joined
+		~LveThreadPool();
+
+		LveThreadPool(const LveThreadPool&) = delete;
+		LveThreadPool& operator=(const LveThreadPool&) = delete;
+
+		// the future hands back the result, or rethrows whatever the job threw
+		template<typename Function>
+		std::future<std::invoke_result_t<Function>> submit(Function&& function) {
+			// std::function has to be copyable and packaged_task is not, so the task lives behind a shared_ptr
+			auto task = std::make_shared<std::packaged_task<std::invoke_result_t<Function>()>>(std::forward<Function>(function));
+			std::future<std::invoke_result_t<Function>> result = task->get_future();
+
+			{
+				std::lock_guard<std::mutex> lock{ mutex };
+				jobs.push([task]() { (*task)(); });
+
+			} // lock is released before waking a worker so it does not wake up just to block on it
+
+			jobAvailable.notify_one();
+			return result;
+
+		} // submit
+
+		uint32_t getThreadCount() const { return static_cast<uint32_t>(threads.size()); } // getThreadCount
+
+	private:
+		void workerLoop();
+
+		std::vector<std::thread> threads{};
+		std::queue<std::function<void()>> jobs{};
+		std::mutex mutex;
+		std::condition_variable jobAvailable;
+		bool stopping = false;
+
+	}; // LveThreadPool
+
+} // lve
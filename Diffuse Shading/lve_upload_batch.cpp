@@ -0,0 +1,143 @@
+#include "lve_upload_batch.hpp"
+
+// std
+#include <algorithm>
+
+namespace lve {
+
+	LveUploadBatch::LveUploadBatch(LveDevice& device) : lveDevice{ device } {
+
+	} // LveUploadBatch
+
+	LveUploadBatch::~LveUploadBatch() {
+		wait();
+
+	} // ~LveUploadBatch
+
+	void LveUploadBatch::copyBuffer(const LveStagingRegion& staging, VkBuffer dstBuffer, VkDeviceSize dstOffset) {
+		VkBufferCopy region{};
+		region.srcOffset = staging.offset;
+		region.dstOffset = dstOffset;
+		region.size = staging.size;
+		bufferCopies.push_back({ staging.buffer, dstBuffer, region });
+		stagingRegions.push_back(staging);
+
+	} // copyBuffer
+
+	void LveUploadBatch::copyBufferToImage(const LveStagingRegion& staging, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount) {
+		VkBufferImageCopy region{};
+		region.bufferOffset = staging.offset;
+		region.bufferRowLength = 0;
+		region.bufferImageHeight = 0;
+
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel = 0;
+		region.imageSubresource.baseArrayLayer = 0;
+		region.imageSubresource.layerCount = layerCount;
+
+		region.imageOffset = { 0, 0, 0 };
+		region.imageExtent = { width, height, 1 };
+
+		imageCopies.push_back({ staging.buffer, image, region });
+		stagingRegions.push_back(staging);
+
+	} // copyBufferToImage
+
+	void LveUploadBatch::onComplete(std::function<void()> callback) {
+		callbacks.push_back(std::move(callback));
+
+	} // onComplete
+
+	void LveUploadBatch::submit() {
+		if (empty() && callbacks.empty())
+			return;
+
+		Submission submission{};
+		submission.stagingRegions.swap(stagingRegions);
+		submission.callbacks.swap(callbacks);
+
+		// nothing to copy, the callbacks just run once everything before them is done
+		if (bufferCopies.empty() && imageCopies.empty()) {
+			submission.ticket = submissions.empty() ? 0 : submissions.back().ticket;
+			submissions.push_back(std::move(submission));
+			return;
+
+		} // if
+
+		// copies between the same pair of buffers become one vkCmdCopyBuffer with many regions,
+		// which is the common case now that uploads share the staging ring and models the geometry arena
+		std::stable_sort(bufferCopies.begin(), bufferCopies.end(), [](const BufferCopy& a, const BufferCopy& b) {
+			return a.stagingBuffer != b.stagingBuffer ? a.stagingBuffer < b.stagingBuffer : a.dstBuffer < b.dstBuffer;
+
+		}); // stable_sort
+
+		VkCommandBuffer commandBuffer = lveDevice.beginTransferCommands();
+
+		std::vector<LveDevice::TransferRegion> regions{};
+		std::vector<VkBufferCopy> copyRegions{};
+		for (size_t first = 0; first < bufferCopies.size();) {
+			size_t last = first;
+			copyRegions.clear();
+			while (last < bufferCopies.size() && bufferCopies[last].stagingBuffer == bufferCopies[first].stagingBuffer && bufferCopies[last].dstBuffer == bufferCopies[first].dstBuffer) {
+				copyRegions.push_back(bufferCopies[last].region);
+				regions.push_back({ bufferCopies[last].dstBuffer, bufferCopies[last].region.dstOffset, bufferCopies[last].region.size });
+				last++;
+
+			} // while
+
+			vkCmdCopyBuffer(commandBuffer, bufferCopies[first].stagingBuffer, bufferCopies[first].dstBuffer, static_cast<uint32_t>(copyRegions.size()), copyRegions.data());
+			first = last;
+
+		} // for
+
+		std::vector<LveDevice::TransferImage> images{};
+		for (const auto& copy : imageCopies) {
+			vkCmdCopyBufferToImage(commandBuffer, copy.stagingBuffer, copy.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copy.region);
+			images.push_back({ copy.image, copy.region.imageSubresource.layerCount });
+
+		} // for
+
+		submission.ticket = lveDevice.submitTransfer(commandBuffer, regions, images);
+		submissions.push_back(std::move(submission));
+
+		bufferCopies.clear();
+		imageCopies.clear();
+
+	} // submit
+
+	bool LveUploadBatch::isComplete() {
+		submit();
+		retire();
+		return submissions.empty();
+
+	} // isComplete
+
+	void LveUploadBatch::wait() {
+		submit();
+		if (submissions.empty())
+			return;
+
+		lveDevice.waitForTransfer(submissions.back().ticket);
+		retire();
+
+	} // wait
+
+	void LveUploadBatch::retire() {
+		// tickets complete in order, the first busy one means everything after it is busy too
+		size_t finished = 0;
+		while (finished < submissions.size() && lveDevice.isTransferComplete(submissions[finished].ticket)) {
+			for (const auto& staging : submissions[finished].stagingRegions)
+				lveDevice.stagingRing().release(staging);
+
+			for (const auto& callback : submissions[finished].callbacks)
+				callback();
+
+			finished++;
+
+		} // while
+
+		submissions.erase(submissions.begin(), submissions.begin() + finished);
+
+	} // retire
+
+} // lve
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "lve_device.hpp"
+
+// std
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace lve {
+
+	// collects the copies of many uploads and runs them as one command buffer, one submit and one wait
+	// instead of a full round trip to the GPU for every buffer, e.g. a whole scene of models loaded up front
+	// staging regions handed to it belong to the batch and go back to the LveStagingRing once their copy has finished
+	// not thread safe, fill it from one thread
+	class LveUploadBatch {
+	public:
+		explicit LveUploadBatch(LveDevice& device);
+
+		// submits whatever is still recorded and waits for it, so nothing the copies use is destroyed under them
+		~LveUploadBatch();
+
+		LveUploadBatch(const LveUploadBatch&) = delete;
+		LveUploadBatch& operator=(const LveUploadBatch&) = delete;
+
+		// copies the whole staging region
+		void copyBuffer(const LveStagingRegion& staging, VkBuffer dstBuffer, VkDeviceSize dstOffset = 0);
+
+		// the image has to be in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL already and stays in it
+		void copyBufferToImage(const LveStagingRegion& staging, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount);
+
+		// runs on the thread that sees the batch finish in isComplete or wait
+		void onComplete(std::function<void()> callback);
+
+		// records and submits every copy so far on the transfer queue, returns straight away
+		// copies added afterwards go into the next submission
+		void submit();
+
+		// submits first if needed
+		bool isComplete();
+		void wait();
+
+		bool empty() const { return bufferCopies.empty() && imageCopies.empty() && stagingRegions.empty(); } // empty
+
+	private:
+		struct BufferCopy {
+			VkBuffer stagingBuffer;
+			VkBuffer dstBuffer;
+			VkBufferCopy region;
+
+		}; // BufferCopy
+
+		struct ImageCopy {
+			VkBuffer stagingBuffer;
+			VkImage image;
+			VkBufferImageCopy region;
+
+		}; // ImageCopy
+
+		// what one submission has to clean up once its ticket is complete
+		struct Submission {
+			uint64_t ticket;
+			std::vector<LveStagingRegion> stagingRegions;
+			std::vector<std::function<void()>> callbacks;
+
+		}; // Submission
+
+		void retire();
+
+		LveDevice& lveDevice;
+
+		std::vector<BufferCopy> bufferCopies{};
+		std::vector<ImageCopy> imageCopies{};
+		std::vector<LveStagingRegion> stagingRegions{};
+		std::vector<std::function<void()>> callbacks{};
+
+		std::vector<Submission> submissions{};
+
+	}; // LveUploadBatch
+
+} // lve
@@ -0,0 +1,262 @@
+#include "lve_vertex_weld.hpp"
+
+//libs
+#include "lve_utils.hpp"
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/hash.hpp>
+
+// std
+#include <array>
+#include <bit>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace std {
+	template<>
+	struct hash<lve::LveModel::Vertex> {
+		size_t operator() (lve::LveModel::Vertex const& vertex) const {
+				size_t seed = 0; // this will store the final hash value
+				lve::hashCombine(seed, vertex.position, vertex.color, vertex.normal, vertex.uv);
+				return seed;
+
+		} // size_t operator
+
+ 	}; //struct hash <lve::LveModel::Vertex>
+
+} // namespace std
+
+namespace lve {
+
+	namespace {
+
+		// Vertex is nothing but floats, so we can hash it as a flat array of 32 bit words
+		constexpr size_t VERTEX_WORDS = sizeof(LveModel::Vertex) / sizeof(uint32_t);
+		static_assert(sizeof(LveModel::Vertex) == VERTEX_WORDS * sizeof(uint32_t), "Vertex must be tightly packed floats");
+
+		constexpr uint32_t EMPTY_SLOT = std::numeric_limits<uint32_t>::max();
+
+		// one multiply and shift per word then a murmur3 finalizer, much cheaper than hashCombine over std::hash<glm::vec3>
+		inline uint64_t hashVertex(const LveModel::Vertex& vertex) {
+			std::array<uint32_t, VERTEX_WORDS> words;
+			std::memcpy(words.data(), &vertex, sizeof(vertex));
+
+			uint64_t hash = 0x9e3779b97f4a7c15ull;
+			for (uint32_t word : words) {
+				// -0.0f == 0.0f, so they have to hash the same
+				if (word == 0x80000000u)
+					word = 0;
+
+				hash = (hash ^ word) * 0x100000001b3ull;
+				hash ^= hash >> 29;
+
+			} // for
+
+			hash ^= hash >> 33;
+			hash *= 0xff51afd7ed558ccdull;
+			hash ^= hash >> 33;
+			hash *= 0xc4ceb9fe1a85ec53ull;
+			hash ^= hash >> 33;
+			return hash;
+
+		} // hashVertex
+
+		inline void checkCornerCount(size_t cornerCount) {
+			if (cornerCount >= EMPTY_SLOT)
+				throw std::runtime_error("too many vertices for 32 bit indices");
+
+		} // checkCornerCount
+
+	} // namespace
+
+	void LveVertexWeld::weld(
+		std::span<const LveModel::Vertex> corners,
+		LveModel::WeldMethod method,
+		std::vector<LveModel::Vertex>& vertices,
+		std::vector<uint32_t>& indices) {
+
+		switch (method) {
+			case LveModel::WeldMethod::UnorderedMap:
+				weldUnorderedMap(corners, vertices, indices);
+				break;
+
+			case LveModel::WeldMethod::FlatHash:
+				weldFlatHash(corners, vertices, indices);
+				break;
+
+			case LveModel::WeldMethod::RadixSort:
+				weldRadixSort(corners, vertices, indices);
+				break;
+
+		} // switch
+
+	} // weld
+
+	void LveVertexWeld::weldUnorderedMap(std::span<const LveModel::Vertex> corners, std::vector<LveModel::Vertex>& vertices, std::vector<uint32_t>& indices) {
+		vertices.clear();
+		indices.clear();
+		indices.reserve(corners.size());
+
+		std::unordered_map<LveModel::Vertex, uint32_t> uniqueVertices{};
+
+		for (const auto& vertex : corners) {
+			if (uniqueVertices.count(vertex) == 0) {
+				uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
+				vertices.push_back(vertex);
+
+			} // if (uniqueVertices.count(vertex) == 0)
+
+			indices.push_back(uniqueVertices[vertex]);
+
+		} // for (const auto& vertex : corners)
+
+	} // weldUnorderedMap
+
+	void LveVertexWeld::weldFlatHash(std::span<const LveModel::Vertex> corners, std::vector<LveModel::Vertex>& vertices, std::vector<uint32_t>& indices) {
+		checkCornerCount(corners.size());
+
+		vertices.clear();
+		indices.clear();
+		indices.resize(corners.size());
+
+		// at most every corner is unique, so twice the corner count keeps the load factor at or below 50%
+		const size_t capacity = std::bit_ceil(std::max<size_t>(corners.size() * 2, 16));
+		const size_t mask = capacity - 1;
+
+		// the upper half of the hash is kept next to the vertex index so most mismatches never touch the vertex itself
+		struct Slot {
+			uint32_t hash;
+			uint32_t vertex;
+
+		}; // Slot
+
+		std::vector<Slot> slots(capacity, Slot{ 0, EMPTY_SLOT });
+
+		for (size_t i = 0; i < corners.size(); i++) {
+			const LveModel::Vertex& corner = corners[i];
+			const uint64_t hash = hashVertex(corner);
+			const uint32_t tag = static_cast<uint32_t>(hash >> 32);
+
+			size_t slot = static_cast<size_t>(hash) & mask;
+			while (true) {
+				Slot& entry = slots[slot];
+				if (entry.vertex == EMPTY_SLOT) {
+					entry = { tag, static_cast<uint32_t>(vertices.size()) };
+					vertices.push_back(corner);
+					indices[i] = entry.vertex;
+					break;
+
+				} // if
+
+				if (entry.hash == tag && vertices[entry.vertex] == corner) {
+					indices[i] = entry.vertex;
+					break;
+
+				} // if
+
+				slot = (slot + 1) & mask;
+
+			} // while
+
+		} // for
+
+	} // weldFlatHash
+
+	void LveVertexWeld::weldRadixSort(std::span<const LveModel::Vertex> corners, std::vector<LveModel::Vertex>& vertices, std::vector<uint32_t>& indices) {
+		checkCornerCount(corners.size());
+
+		vertices.clear();
+		indices.clear();
+
+		const size_t count = corners.size();
+		if (count == 0)
+			return;
+
+		struct Key {
+			uint64_t hash;
+			uint32_t corner;
+
+		}; // Key
+
+		std::vector<Key> keys(count);
+		std::vector<Key> scratch(count);
+		for (size_t i = 0; i < count; i++)
+			keys[i] = { hashVertex(corners[i]), static_cast<uint32_t>(i) };
+
+		// 8 passes of 8 bits, a pass where every key has the same digit would not move anything so it is skipped
+		for (uint32_t shift = 0; shift < 64; shift += 8) {
+			std::array<size_t, 256> offsets{};
+			for (const Key& key : keys)
+				offsets[(key.hash >> shift) & 0xff]++;
+
+			if (offsets[(keys[0].hash >> shift) & 0xff] == count)
+				continue;
+
+			size_t sum = 0;
+			for (size_t& offset : offsets) {
+				size_t bucketSize = offset;
+				offset = sum;
+				sum += bucketSize;
+
+			} // for
+
+			for (const Key& key : keys)
+				scratch[offsets[(key.hash >> shift) & 0xff]++] = key;
+
+			keys.swap(scratch);
+
+		} // for
+
+		// every corner points at the first corner it is equal to
+		// equal hashes can still be different vertices, so within a run we compare against every distinct vertex seen so far in it,
+		// runs are a handful of corners at most so this stays cheap
+		std::vector<uint32_t> firstEqual(count);
+		std::vector<uint32_t> distinct{};
+		for (size_t runBegin = 0; runBegin < count;) {
+			size_t runEnd = runBegin + 1;
+			while (runEnd < count && keys[runEnd].hash == keys[runBegin].hash)
+				runEnd++;
+
+			distinct.clear();
+			for (size_t k = runBegin; k < runEnd; k++) {
+				const uint32_t corner = keys[k].corner;
+				uint32_t match = corner;
+				for (uint32_t candidate : distinct) {
+					if (corners[candidate] == corners[corner]) {
+						match = candidate;
+						break;
+
+					} // if
+
+				} // for
+
+				if (match == corner)
+					distinct.push_back(corner);
+
+				firstEqual[corner] = match;
+
+			} // for
+
+			runBegin = runEnd;
+
+		} // for
+
+		// walk the corners in file order handing out vertex indices, a first occurrence always comes before its duplicates
+		indices.resize(count);
+		for (size_t i = 0; i < count; i++) {
+			if (firstEqual[i] == i) {
+				indices[i] = static_cast<uint32_t>(vertices.size());
+				vertices.push_back(corners[i]);
+
+			} else {
+				indices[i] = indices[firstEqual[i]];
+
+			} // else
+
+		} // for
+
+	} // weldRadixSort
+
+} // lve
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "lve_model.hpp"
+
+// std
+#include <span>
+#include <vector>
+
+namespace lve {
+
+	// turns one expanded vertex per triangle corner into unique vertices + indices
+	// every method produces the exact same output: vertices in order of first appearance, bit identical indices
+	// (positive and negative zero weld together, just like they compare equal with operator==)
+	class LveVertexWeld {
+	public:
+		static void weld(
+			std::span<const LveModel::Vertex> corners,
+			LveModel::WeldMethod method,
+			std::vector<LveModel::Vertex>& vertices,
+			std::vector<uint32_t>& indices);
+
+		// what loadModel used to do, a node based std::unordered_map, only kept as the benchmark baseline
+		static void weldUnorderedMap(std::span<const LveModel::Vertex> corners, std::vector<LveModel::Vertex>& vertices, std::vector<uint32_t>& indices);
+
+		// open addressing with linear probing, sized up front from the corner count so it never rehashes
+		// one probe sequence per corner and the slots are 8 bytes each, so a probe is usually a single cache line
+		static void weldFlatHash(std::span<const LveModel::Vertex> corners, std::vector<LveModel::Vertex>& vertices, std::vector<uint32_t>& indices);
+
+		// sorts (hash, corner) pairs with a LSD radix sort so duplicates end up next to each other, no random access table at all
+		// the sort is stable, so the first corner of every run is also the first occurrence in the file
+		static void weldRadixSort(std::span<const LveModel::Vertex> corners, std::vector<LveModel::Vertex>& vertices, std::vector<uint32_t>& indices);
+
+	}; // LveVertexWeld
+
+} // lve
@@ -27,6 +27,9 @@ namespace lve {
 
 		GLFWwindow* getGLFWwindow() const { return window; } // getGLFWwindow
 
+		// shown after the name the window was created with
+		void setTitleStatus(const std::string& status) { glfwSetWindowTitle(window, (windowName + " | " + status).c_str()); } // setTitleStatus
+
 	private:
 		static void frameBufferResizedCallback(GLFWwindow *window, int width, int height);
 		GLFWwindow *window;
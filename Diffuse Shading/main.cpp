@@ -1,11 +1,55 @@
 #include "first_app.hpp"
+#include "lve_benchmark.hpp"
 
 // ideally all we will need for now
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <stdexcept>
+#include <string>
+
+int main(int argc, char** argv) {
+	// benchmarks run without a window, so check for them before the app is created
+	if (argc > 1 && std::strcmp(argv[1], "--benchmark-models") == 0) {
+		try {
+			const std::string modelDirectory = argc > 2 ? argv[2] : "models";
+			lve::LveBenchmark::objParsing(modelDirectory);
+			lve::LveBenchmark::vertexWelding(modelDirectory);
+			lve::LveBenchmark::vertexCacheOptimization(modelDirectory);
+			lve::LveBenchmark::vertexPacking(modelDirectory);
+			lve::LveBenchmark::lodGeneration(modelDirectory);
+			lve::LveBenchmark::modelLoading(modelDirectory);
+
+		} // try
+		catch (const std::exception& e) {
+			std::cerr << e.what() << "\n";
+			return EXIT_FAILURE;
+
+		} // catch
+
+		return EXIT_SUCCESS;
+
+	} // if
+
+	// no window and no display, so it also runs on CI machines with a software driver
+	if (argc > 1 && std::strcmp(argv[1], "--benchmark-headless") == 0) {
+		try {
+			const std::string modelPath = argc > 2 ? argv[2] : "models/Snorlax.obj";
+			const int frames = argc > 3 ? std::atoi(argv[3]) : 1000;
+			const int objects = argc > 4 ? std::atoi(argv[4]) : 1;
+			lve::LveBenchmark::headlessRendering(modelPath, frames, objects);
+
+		} // try
+		catch (const std::exception& e) {
+			std::cerr << e.what() << "\n";
+			return EXIT_FAILURE;
+
+		} // catch
+
+		return EXIT_SUCCESS;
+
+	} // if
 
-int main() {
 	// calling the function 
 	lve::FirstApp app{};
 
@@ -22,4 +66,4 @@ int main() {
 
 	return EXIT_SUCCESS;
 	 
-} // main
\ No newline at end of file
+} // main
@@ -2,10 +2,15 @@
 
 // std
 #include <stdexcept>
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <iostream>
 #include <chrono>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <future>
 
 // libs
 #define GLM_FORCE_RADIANS // forces in radians and not degrees
@@ -15,12 +20,18 @@
 
 namespace lve {
 
-	struct SimplePushConstantData {
-		// this is temporary and will be restructured
-		glm::mat4 transform{ 1.f };
-		glm::mat4 modelMatrix{ 1.f };
+	namespace {
 
-	}; // SimplePushConstantData
+		// bounds are in model units, a non uniform scale takes its largest axis so they still cover the mesh
+		float maxAxisScale(const glm::mat4& modelMatrix) {
+			return std::max({
+				glm::length(glm::vec3{ modelMatrix[0] }),
+				glm::length(glm::vec3{ modelMatrix[1] }),
+				glm::length(glm::vec3{ modelMatrix[2] }) });
+
+		} // maxAxisScale
+
+	} // namespace
 
 	SimpleRenderSystem::SimpleRenderSystem(LveDevice& device, VkRenderPass renderPass) : lveDevice{device} {
 		createPipelineLayout();
@@ -30,11 +41,6 @@ namespace lve {
 
 
 	void SimpleRenderSystem::createPipelineLayout() {
-		VkPushConstantRange pushConstantRange{};
-		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-		pushConstantRange.offset = 0; // mainly used for if you are using separate ranges for the vertex and fragment shaders
-		pushConstantRange.size = sizeof(SimplePushConstantData);
-
 		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
 		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 		/// a pipeline set layout to send data other than our vertex data to our vertex and fragment shaders
@@ -42,9 +48,9 @@ namespace lve {
 		pipelineLayoutInfo.pSetLayouts = 0;
 		pipelineLayoutInfo.pSetLayouts = nullptr;
 
-		// push constants are a way to send efficiently a very small amount of data through to our shader programs
-		pipelineLayoutInfo.pushConstantRangeCount = 1;
-		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+		// no push constants, every draw is instanced and the transforms come in with the instance data
+		pipelineLayoutInfo.pushConstantRangeCount = 0;
+		pipelineLayoutInfo.pPushConstantRanges = nullptr;
 
 		if (vkCreatePipelineLayout(lveDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
 			throw std::runtime_error("failed to create pipeline layout!");
@@ -54,6 +60,12 @@ namespace lve {
 	} // createPipelineLayout
 
 	void SimpleRenderSystem::createPipeline(VkRenderPass renderPass) {
+		lvePipeline = createPipeline(renderPass, LveModel::VertexFormat::Full);
+		packedLvePipeline = createPipeline(renderPass, LveModel::VertexFormat::Packed);
+
+	} // createPipeline
+
+	std::unique_ptr<LvePipeline> SimpleRenderSystem::createPipeline(VkRenderPass renderPass, LveModel::VertexFormat vertexFormat) {
 
 		assert(pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
 
@@ -61,9 +73,29 @@ namespace lve {
 
 		LvePipeline::defaultPipelineConfigInfo(pipelineConfig);
 
+		// the packed layout needs different vertex input state and flips PACKED_VERTICES in the vertex shader
+		const VkBool32 packedVertices = vertexFormat == LveModel::VertexFormat::Packed ? VK_TRUE : VK_FALSE;
+		VkSpecializationMapEntry specializationEntry{ 0, 0, sizeof(VkBool32) };
+		VkSpecializationInfo specializationInfo{ 1, &specializationEntry, sizeof(VkBool32), &packedVertices };
+
+		if (packedVertices) {
+			pipelineConfig.bindingDescriptions = LveModel::PackedVertex::getBindingDescriptions();
+			pipelineConfig.attributeDescriptions = LveModel::PackedVertex::getAttributeDescriptions();
+
+		} // if
+
+		// the second binding steps once per instance, InstanceData goes after whatever the vertex format uses
+		pipelineConfig.bindingDescriptions.push_back({ 1, sizeof(InstanceData), VK_VERTEX_INPUT_RATE_INSTANCE });
+		for (uint32_t column = 0; column < 4; column++) {
+			pipelineConfig.attributeDescriptions.push_back({ 4 + column, 1, VK_FORMAT_R32G32B32A32_SFLOAT, static_cast<uint32_t>(offsetof(InstanceData, transform) + column * sizeof(glm::vec4)) });
+			pipelineConfig.attributeDescriptions.push_back({ 8 + column, 1, VK_FORMAT_R32G32B32A32_SFLOAT, static_cast<uint32_t>(offsetof(InstanceData, modelMatrix) + column * sizeof(glm::vec4)) });
+
+		} // for
+
+		pipelineConfig.vertSpecializationInfo = &specializationInfo;
 		pipelineConfig.renderPass = renderPass;
 		pipelineConfig.pipelineLayout = pipelineLayout;
-		lvePipeline = std::make_unique<LvePipeline>(
+		return std::make_unique<LvePipeline>(
 			lveDevice,
 			"C:\\Users\\suraj\\OneDrive\\Documents\\Visual Studio Projects\\Vulkan Notes\\Diffuse Shading\\simple_shader.vert.spv",
 			"C:\\Users\\suraj\\OneDrive\\Documents\\Visual Studio Projects\\Vulkan Notes\\Diffuse Shading\\simple_shader.frag.spv",
@@ -71,36 +103,451 @@ namespace lve {
 
 	}// createPipeline
 
-	void SimpleRenderSystem::renderGameObjects(VkCommandBuffer commandBuffer, std::vector<LveGameObject>& gameObjects, const LveCamera& camera) {
-		lvePipeline->bind(commandBuffer);
+	void SimpleRenderSystem::renderGameObjects(VkCommandBuffer commandBuffer, uint32_t frameIndex, std::vector<LveGameObject>& gameObjects, const LveCamera& camera) {
 		auto projectionView = camera.getProjection() * camera.getView(); // every rendered object will used the same projection and view matrix, so this way we can avoid doing the calculation for each iterated view function
+		const FrameBuffer& instances = instancesFor(frameIndex, gameObjects.size());
+		resetCullStats();
+		recordGameObjects(commandBuffer, gameObjects, instances, 0, projectionView, camera, LveFrustum::fromMatrix(projectionView));
+
+	} // renderGameObjects
+
+	void SimpleRenderSystem::renderGameObjectsIndirect(VkCommandBuffer commandBuffer, uint32_t frameIndex, std::vector<LveGameObject>& gameObjects, const LveCamera& camera) {
+		const VkPhysicalDeviceFeatures& features = lveDevice.enabledFeatures();
+		// every command starts at its own instance slots, without firstInstance in indirect commands they would all read slot 0
+		if (!features.drawIndirectFirstInstance) {
+			renderGameObjects(commandBuffer, frameIndex, gameObjects, camera);
+			return;
+
+		} // if
+
+		const PFN_vkCmdDrawIndexedIndirectCountKHR drawIndexedIndirectCount = features.multiDrawIndirect ? lveDevice.cmdDrawIndexedIndirectCount() : nullptr;
+		const glm::mat4 projectionView = camera.getProjection() * camera.getView();
+		resetCullStats();
+		const std::vector<VisibleObject> visible = collectVisible(gameObjects, camera, LveFrustum::fromMatrix(projectionView));
+
+		// never more commands than objects, so sizing for the objects leaves room for a culling pass that splits draws up later
+		const FrameBuffer& instances = instancesFor(frameIndex, gameObjects.size());
+		FrameResources& frame = frameFor(frameIndex);
+		reserve(frame.drawCommands, std::max<size_t>(gameObjects.size(), 1) * sizeof(VkDrawIndexedIndirectCommand), VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
+
+		InstanceData* instanceData = static_cast<InstanceData*>(instances.memory.mapped);
+		VkDrawIndexedIndirectCommand* drawCommands = static_cast<VkDrawIndexedIndirectCommand*>(frame.drawCommands.memory.mapped);
+
+		// commands next to each other that use the same pipeline and buffers, one indirect draw each
+		struct DrawBatch {
+			LvePipeline* pipeline;
+			LveModel* model; // any model of the batch, they all bind the same buffers
+			uint32_t firstCommand;
+			uint32_t commandCount;
+
+		}; // DrawBatch
+
+		std::vector<DrawBatch> batches{};
+		uint32_t commandCount = 0;
+
+		VkDeviceSize instanceOffset = 0;
+		vkCmdBindVertexBuffers(commandBuffer, 1, 1, &instances.buffer, &instanceOffset);
+
+		LvePipeline* boundPipeline = nullptr;
+		VkBuffer boundVertexBuffer = VK_NULL_HANDLE;
+		VkBuffer boundIndexBuffer = VK_NULL_HANDLE;
+		auto bind = [&](LvePipeline* pipeline, LveModel& model) {
+			if (pipeline != boundPipeline) {
+				pipeline->bind(commandBuffer);
+				boundPipeline = pipeline;
+
+			} // if
+
+			if (model.getVertexBuffer() != boundVertexBuffer || model.getIndexBuffer() != boundIndexBuffer) {
+				model.bind(commandBuffer);
+				boundVertexBuffer = model.getVertexBuffer();
+				boundIndexBuffer = model.getIndexBuffer();
+
+			} // if
+
+		}; // bind
+
+		size_t first = 0;
+		while (first < visible.size()) {
+			LveModel& model = *visible[first].model;
+			const uint32_t lod = visible[first].lod;
+
+			const glm::mat4 dequantize = model.getQuantization().matrix();
+			size_t last = first;
+			for (; last < visible.size() && visible[last].model == &model && visible[last].lod == lod; last++)
+				instanceData[last] = { projectionView * visible[last].modelMatrix * dequantize, visible[last].modelMatrix };
+
+			const uint32_t instanceCount = static_cast<uint32_t>(last - first);
+			LvePipeline* pipeline = pipelineFor(model);
+			if (!model.isIndexed()) {
+				// there is no index buffer to point a VkDrawIndexedIndirectCommand at, these are rare enough to draw directly
+				bind(pipeline, model);
+				model.draw(commandBuffer, lod, instanceCount, static_cast<uint32_t>(first));
+
+			} else {
+
+				const bool sameBatch = !batches.empty() && batches.back().pipeline == pipeline &&
+					batches.back().model->getVertexBuffer() == model.getVertexBuffer() &&
+					batches.back().model->getIndexBuffer() == model.getIndexBuffer();
+				if (!sameBatch)
+					batches.push_back({ pipeline, &model, commandCount, 0 });
+
+				drawCommands[commandCount++] = model.getDrawCommand(lod, instanceCount, static_cast<uint32_t>(first));
+				batches.back().commandCount++;
+
+			} // else
+
+			first = last;
+
+		} // while
+
+		uint32_t* drawCounts = nullptr;
+		if (drawIndexedIndirectCount != nullptr && !batches.empty()) {
+			reserve(frame.drawCounts, batches.size() * sizeof(uint32_t), VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
+			drawCounts = static_cast<uint32_t*>(frame.drawCounts.memory.mapped);
+
+		} // if
+
+		constexpr uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+		for (size_t i = 0; i < batches.size(); i++) {
+			const DrawBatch& batch = batches[i];
+			bind(batch.pipeline, *batch.model);
+
+			const VkDeviceSize offset = static_cast<VkDeviceSize>(batch.firstCommand) * stride;
+			if (drawCounts != nullptr) {
+				// the count is read from the buffer, the batch's slots are the most a culling pass could ever fill
+				drawCounts[i] = batch.commandCount;
+				drawIndexedIndirectCount(commandBuffer, frame.drawCommands.buffer, offset, frame.drawCounts.buffer, i * sizeof(uint32_t), batch.commandCount, stride);
+
+			} else if (features.multiDrawIndirect) {
+				vkCmdDrawIndexedIndirect(commandBuffer, frame.drawCommands.buffer, offset, batch.commandCount, stride);
+
+			} else {
+
+				// drawCount has to be 0 or 1 without multiDrawIndirect
+				for (uint32_t command = 0; command < batch.commandCount; command++)
+					vkCmdDrawIndexedIndirect(commandBuffer, frame.drawCommands.buffer, offset + command * stride, 1, stride);
+
+			} // else
+
+		} // for
+
+	} // renderGameObjectsIndirect
+
+	void SimpleRenderSystem::renderGameObjectsGpuCulled(VkCommandBuffer commandBuffer, uint32_t frameIndex, const LveGpuCulling& gpuCulling) {
+		const VkPhysicalDeviceFeatures& features = lveDevice.enabledFeatures();
+		const PFN_vkCmdDrawIndexedIndirectCountKHR drawIndexedIndirectCount = features.multiDrawIndirect ? lveDevice.cmdDrawIndexedIndirectCount() : nullptr;
+
+		const VkBuffer instances = gpuCulling.getInstanceBuffer(frameIndex);
+		const VkBuffer drawCommands = gpuCulling.getDrawCommandBuffer(frameIndex);
+		const VkBuffer drawCounts = gpuCulling.getDrawCountBuffer(frameIndex);
+
+		VkDeviceSize instanceOffset = 0;
+		vkCmdBindVertexBuffers(commandBuffer, 1, 1, &instances, &instanceOffset);
+
+		LvePipeline* boundPipeline = nullptr;
+		constexpr uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+		const std::vector<LveGpuCulling::DrawBatch>& batches = gpuCulling.getDrawBatches();
+		for (size_t i = 0; i < batches.size(); i++) {
+			const LveGpuCulling::DrawBatch& batch = batches[i];
+
+			// batches differ in their buffers, so only the pipeline is worth checking
+			LvePipeline* pipeline = pipelineFor(*batch.model);
+			if (pipeline != boundPipeline) {
+				pipeline->bind(commandBuffer);
+				boundPipeline = pipeline;
+
+			} // if
+
+			batch.model->bind(commandBuffer);
+
+			// the compact pass fills the batch's slots from the front, the rest stay zeroed and draw nothing
+			const VkDeviceSize offset = static_cast<VkDeviceSize>(batch.firstCommand) * stride;
+			if (drawIndexedIndirectCount != nullptr) {
+				drawIndexedIndirectCount(commandBuffer, drawCommands, offset, drawCounts, i * sizeof(uint32_t), batch.maxCommandCount, stride);
+
+			} else if (features.multiDrawIndirect) {
+				vkCmdDrawIndexedIndirect(commandBuffer, drawCommands, offset, batch.maxCommandCount, stride);
+
+			} else {
+
+				// drawCount has to be 0 or 1 without multiDrawIndirect
+				for (uint32_t command = 0; command < batch.maxCommandCount; command++)
+					vkCmdDrawIndexedIndirect(commandBuffer, drawCommands, offset + command * stride, 1, stride);
+
+			} // else
+
+		} // for
+
+	} // renderGameObjectsGpuCulled
+
+	void SimpleRenderSystem::renderGameObjectsParallel(
+		LveRenderer& renderer, VkCommandBuffer commandBuffer, std::vector<LveGameObject>& gameObjects, const LveCamera& camera, LveThreadPool& workers) {
+		const glm::mat4 projectionView = camera.getProjection() * camera.getView();
+		// sized on this thread before any worker starts writing into it
+		const FrameBuffer& instances = instancesFor(static_cast<uint32_t>(renderer.getFrameIndex()), gameObjects.size());
+		const LveFrustum frustum = LveFrustum::fromMatrix(projectionView);
+		resetCullStats();
+
+		// a slice per worker plus one for this thread, but never so small that beginning a command buffer costs more than recording it
+		const size_t maxSlices = (gameObjects.size() + MIN_OBJECTS_PER_SLICE - 1) / MIN_OBJECTS_PER_SLICE;
+		const size_t sliceCount = std::max<size_t>(1, std::min<size_t>(workers.getThreadCount() + 1, maxSlices));
+		const size_t sliceSize = (gameObjects.size() + sliceCount - 1) / sliceCount;
 
+		std::vector<VkCommandBuffer> secondaryCommandBuffers(sliceCount, VK_NULL_HANDLE);
+		auto recordSlice = [&](size_t slice) {
+			const size_t first = std::min(slice * sliceSize, gameObjects.size());
+			const size_t count = std::min(sliceSize, gameObjects.size() - first);
+
+			VkCommandBuffer secondary = renderer.beginSecondaryCommandBuffer();
+			// a slice has no more instances than objects, so the slots of its objects are its own part of the instance buffer
+			recordGameObjects(secondary, std::span<LveGameObject>{ gameObjects }.subspan(first, count), instances, static_cast<uint32_t>(first), projectionView, camera, frustum);
+			if (vkEndCommandBuffer(secondary) != VK_SUCCESS)
+				throw std::runtime_error("failed to record secondary command buffer!");
+
+			secondaryCommandBuffers[slice] = secondary;
+
+		}; // recordSlice
+
+		std::vector<std::future<void>> recorded{};
+		recorded.reserve(sliceCount - 1);
+		for (size_t slice = 1; slice < sliceCount; slice++)
+			recorded.push_back(workers.submit([&recordSlice, slice]() { recordSlice(slice); }));
+
+		// this thread records the first slice instead of just waiting
+		std::exception_ptr error{};
+		try {
+			recordSlice(0);
+
+		} // try
+		catch (...) {
+			error = std::current_exception();
+
+		} // catch
+
+		// every job has to be done before anything they reference goes out of scope, even when one of them threw
+		for (auto& slice : recorded) {
+			try {
+				slice.get();
+
+			} // try
+			catch (...) {
+				if (!error)
+					error = std::current_exception();
+
+			} // catch
+
+		} // for
+
+		if (error)
+			std::rethrow_exception(error);
+
+		// in slice order, each slice sorts its own objects into instanced draws
+		vkCmdExecuteCommands(commandBuffer, static_cast<uint32_t>(secondaryCommandBuffers.size()), secondaryCommandBuffers.data());
+
+	} // renderGameObjectsParallel
+
+	void SimpleRenderSystem::recordGameObjects(
+		VkCommandBuffer commandBuffer,
+		std::span<LveGameObject> gameObjects,
+		const FrameBuffer& instances,
+		uint32_t firstInstance,
+		const glm::mat4& projectionView,
+		const LveCamera& camera,
+		const LveFrustum& frustum) {
+		const std::vector<VisibleObject> visible = collectVisible(gameObjects, camera, frustum);
+
+		VkDeviceSize instanceOffset = 0;
+		vkCmdBindVertexBuffers(commandBuffer, 1, 1, &instances.buffer, &instanceOffset);
+		InstanceData* instanceData = static_cast<InstanceData*>(instances.memory.mapped) + firstInstance;
+
+		LvePipeline* boundPipeline = nullptr;
+
+		// models in the geometry arena share their buffers, so usually this binds once per vertex format for the whole frame
+		VkBuffer boundVertexBuffer = VK_NULL_HANDLE;
+		VkBuffer boundIndexBuffer = VK_NULL_HANDLE;
+
+		size_t first = 0;
+		while (first < visible.size()) {
+			LveModel& model = *visible[first].model;
+			const uint32_t lod = visible[first].lod;
+
+			// packed positions are 0..1 inside the mesh bounds, the dequantize matrix maps them back to model space (identity for full vertices)
+			const glm::mat4 dequantize = model.getQuantization().matrix();
+			size_t last = first;
+			for (; last < visible.size() && visible[last].model == &model && visible[last].lod == lod; last++)
+				instanceData[last] = { projectionView * visible[last].modelMatrix * dequantize, visible[last].modelMatrix };
+
+			// only switch pipelines when the vertex layout actually changes
+			LvePipeline* pipeline = pipelineFor(model);
+			if (pipeline != boundPipeline) {
+				pipeline->bind(commandBuffer);
+				boundPipeline = pipeline;
+
+			} // if
+
+			if (model.getVertexBuffer() != boundVertexBuffer || model.getIndexBuffer() != boundIndexBuffer) {
+				model.bind(commandBuffer);
+				boundVertexBuffer = model.getVertexBuffer();
+				boundIndexBuffer = model.getIndexBuffer();
+
+			} // if
+
+			model.draw(commandBuffer, lod, static_cast<uint32_t>(last - first), firstInstance + static_cast<uint32_t>(first));
+			first = last;
+
+		} // while
+
+	} // recordGameObjects
+
+	std::vector<SimpleRenderSystem::VisibleObject> SimpleRenderSystem::collectVisible(
+		std::span<LveGameObject> gameObjects, const LveCamera& camera, const LveFrustum& frustum) {
+		// world space spheres go into one contiguous array, so the frustum test runs over them four at a time
+		std::vector<VisibleObject> candidates{};
+		LveBoundingSpheres spheres{};
+		candidates.reserve(gameObjects.size());
+		spheres.reserve(gameObjects.size());
 		for (auto& obj : gameObjects) {
-			SimplePushConstantData push{};
+			// still loading in the background, it just pops in once it is ready
+			if (obj.model == nullptr || !obj.model->isResident())
+				continue;
 
-			auto modelMatrix = obj.transform.mat4();
-			push.transform = projectionView * modelMatrix;
-			push.modelMatrix = modelMatrix;
+			const glm::mat4 modelMatrix = obj.transform.mat4();
+			candidates.push_back({ obj.model.get(), 0, modelMatrix });
+			spheres.push_back(modelMatrix * glm::vec4{ obj.model->getBoundsCenter(), 1.f }, obj.model->getBoundsRadius() * maxAxisScale(modelMatrix));
 
+		} // for
 
-			vkCmdPushConstants(
-				commandBuffer,
-				pipelineLayout,
-				VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-				0,
-				sizeof(SimplePushConstantData),
-				&push
+		std::vector<uint8_t> inside{};
+		const size_t insideCount = frustum.cullSpheres(spheres, inside);
+		visibleCount.fetch_add(static_cast<uint32_t>(insideCount), std::memory_order_relaxed);
+		culledCount.fetch_add(static_cast<uint32_t>(candidates.size() - insideCount), std::memory_order_relaxed);
 
-			); // vkCmdPushConstants
+		// only what is left needs a LOD
+		std::vector<VisibleObject> visible{};
+		visible.reserve(insideCount);
+		for (size_t i = 0; i < candidates.size(); i++) {
+			if (!inside[i])
+				continue;
 
-			obj.model->bind(commandBuffer);
-			obj.model->draw(commandBuffer);
+			visible.push_back(candidates[i]);
+			visible.back().lod = selectLod(*candidates[i].model, candidates[i].modelMatrix, camera);
 
 		} // for
 
-	} // renderGameObjects
+		// objects sharing a model and LOD end up next to each other and become one draw, and sorting on the vertex format
+		// first keeps pipeline switches down to one per format
+		std::sort(visible.begin(), visible.end(), [](const VisibleObject& a, const VisibleObject& b) {
+			if (a.model->getVertexFormat() != b.model->getVertexFormat())
+				return a.model->getVertexFormat() < b.model->getVertexFormat();
+
+			if (a.model != b.model)
+				return std::less<LveModel*>{}(a.model, b.model);
+
+			return a.lod < b.lod;
+
+		}); // sort
+
+		return visible;
+
+	} // collectVisible
+
+	void SimpleRenderSystem::resetCullStats() {
+		visibleCount.store(0, std::memory_order_relaxed);
+		culledCount.store(0, std::memory_order_relaxed);
+
+	} // resetCullStats
+
+	LvePipeline* SimpleRenderSystem::pipelineFor(const LveModel& model) const {
+		return model.getVertexFormat() == LveModel::VertexFormat::Packed ? packedLvePipeline.get() : lvePipeline.get();
+
+	} // pipelineFor
+
+	uint32_t SimpleRenderSystem::selectLod(const LveModel& model, const glm::mat4& modelMatrix, const LveCamera& camera) {
+		if (model.getLodCount() <= 1)
+			return 0;
+
+		// the error is in model units, so scale it like the model
+		const float worldScale = maxAxisScale(modelMatrix);
+
+		const glm::mat4& projection = camera.getProjection();
+		float screenPerWorld; // fraction of the screen height covered by one world unit at the nearest point of the bounds
+		if (projection[2][3] == 0.f) {
+			// orthographic, the size on screen does not depend on distance
+			screenPerWorld = std::abs(projection[1][1]) * 0.5f;
+
+		} else {
+			const glm::vec3 center = modelMatrix * glm::vec4{ model.getBoundsCenter(), 1.f };
+			const float radius = model.getBoundsRadius() * worldScale;
+			const float depth = (camera.getView() * glm::vec4{ center, 1.f }).z;
+
+			// the camera is inside the bounds or right at them, nothing is far enough away to simplify
+			if (depth - radius <= 0.f)
+				return 0;
+
+			screenPerWorld = projection[1][1] * 0.5f / (depth - radius);
+
+		} // else
+
+		uint32_t lod = 0;
+		for (uint32_t i = 1; i < model.getLodCount(); i++) {
+			if (model.getLod(i).error * worldScale * screenPerWorld > LOD_ERROR_THRESHOLD)
+				break;
+
+			lod = i;
+
+		} // for
+
+		return lod;
+
+	} // selectLod
+
+	SimpleRenderSystem::FrameResources& SimpleRenderSystem::frameFor(uint32_t frameIndex) {
+		if (frames.size() <= frameIndex)
+			frames.resize(frameIndex + 1);
+
+		return frames[frameIndex];
+
+	} // frameFor
+
+	void SimpleRenderSystem::reserve(FrameBuffer& frameBuffer, VkDeviceSize size, VkBufferUsageFlags usage) {
+		if (frameBuffer.capacity >= size)
+			return;
+
+		// the fence of the last frame with this index has signalled, so nothing on the GPU reads the old buffer any more
+		if (frameBuffer.buffer != VK_NULL_HANDLE)
+			lveDevice.destroyBuffer(frameBuffer.buffer, frameBuffer.memory);
+
+		// doubling keeps a growing scene from reallocating every frame
+		frameBuffer.capacity = std::max(size, frameBuffer.capacity * 2);
+
+		// written by the CPU every frame and read once by the GPU, so it stays in host visible memory
+		lveDevice.createBuffer(
+			frameBuffer.capacity,
+			usage,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			frameBuffer.buffer,
+			frameBuffer.memory);
+
+	} // reserve
+
+	const SimpleRenderSystem::FrameBuffer& SimpleRenderSystem::instancesFor(uint32_t frameIndex, size_t instanceCount) {
+		FrameBuffer& instances = frameFor(frameIndex).instances;
+		reserve(instances, std::max<size_t>(instanceCount, MIN_OBJECTS_PER_SLICE) * sizeof(InstanceData), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+		return instances;
+
+	} // instancesFor
 
 	SimpleRenderSystem::~SimpleRenderSystem() {
+		for (auto& frame : frames) {
+			for (FrameBuffer* frameBuffer : { &frame.instances, &frame.drawCommands, &frame.drawCounts }) {
+				if (frameBuffer->buffer != VK_NULL_HANDLE)
+					lveDevice.destroyBuffer(frameBuffer->buffer, frameBuffer->memory);
+
+			} // for
+
+		} // for
+
 		vkDestroyPipelineLayout(lveDevice.device(), pipelineLayout, nullptr);
 
 	} // ~SimpleRenderSystem
@@ -4,32 +4,134 @@
 #include "lve_device.hpp"
 #include "lve_game_object.hpp"
 #include "lve_camera.hpp"
+#include "lve_renderer.hpp"
+#include "lve_thread_pool.hpp"
+#include "lve_gpu_culling.hpp"
 
 // std
+#include <atomic>
+#include <cstddef>
 #include <memory>
+#include <span>
 #include <vector>
 
 namespace lve {
 
     class SimpleRenderSystem {
     public:
+        // scenes smaller than this record faster on one thread than it takes to hand slices to workers
+        static constexpr size_t MIN_OBJECTS_PER_SLICE = 256;
+
+        // a LOD is good enough once its error covers less than this fraction of the screen height, about one pixel at 1080p
+        static constexpr float LOD_ERROR_THRESHOLD = 1.f / 1080.f;
+
+        // per instance vertex input, binding 1, locations 4 to 11, also written by gpu_cull.comp
+        struct InstanceData {
+            glm::mat4 transform; // proj * view * model * dequantize
+            glm::mat4 modelMatrix;
+
+        }; // InstanceData
+
+        // resident objects the last render call looked at, the ones still loading are in neither
+        struct CullStats {
+            uint32_t visible = 0;
+            uint32_t culled = 0; // bounding sphere completely outside the view frustum
+
+        }; // CullStats
 
         SimpleRenderSystem(LveDevice &device, VkRenderPass renderPass);
         ~SimpleRenderSystem();
-        void renderGameObjects(VkCommandBuffer commandBuffer, std::vector<LveGameObject>& gameObjects, const LveCamera &camera);
+        // objects whose bounding sphere is outside the camera's frustum are skipped, the rest that share a model and LOD
+        // are drawn with one instanced draw, their transforms go into an instance buffer
+        // kept per frame index, frameIndex is LveRenderer::getFrameIndex
+        void renderGameObjects(VkCommandBuffer commandBuffer, uint32_t frameIndex, std::vector<LveGameObject>& gameObjects, const LveCamera &camera);
+
+        // the same instanced draws, but written as VkDrawIndexedIndirectCommands into a per frame buffer and issued with one
+        // indirect draw per pipeline and buffer binding, so a culling pass on the GPU can rewrite the commands and counts later
+        // falls back to renderGameObjects when the device has no drawIndirectFirstInstance
+        void renderGameObjectsIndirect(VkCommandBuffer commandBuffer, uint32_t frameIndex, std::vector<LveGameObject>& gameObjects, const LveCamera& camera);
+
+        // draws what LveGpuCulling::cull wrote for frameIndex, culling, LOD selection and the instance data all happened on the GPU
+        // so this records a few commands per batch however big the scene is, the cull stats are not updated
+        void renderGameObjectsGpuCulled(VkCommandBuffer commandBuffer, uint32_t frameIndex, const LveGpuCulling& gpuCulling);
+
+        // splits the objects into slices that the workers and the calling thread record into secondary command buffers
+        // at the same time, then executes them from commandBuffer in order
+        // the swap chain render pass has to be begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
+        void renderGameObjectsParallel(
+            LveRenderer& renderer, VkCommandBuffer commandBuffer, std::vector<LveGameObject>& gameObjects, const LveCamera& camera, LveThreadPool& workers);
+
+        CullStats getCullStats() const { return { visibleCount.load(std::memory_order_relaxed), culledCount.load(std::memory_order_relaxed) }; } // getCullStats
 
         SimpleRenderSystem(const SimpleRenderSystem&) = delete;
         SimpleRenderSystem& operator=(const SimpleRenderSystem&) = delete;
 
     private:
+        // an object that is resident and about to be drawn
+        struct VisibleObject {
+            LveModel* model;
+            uint32_t lod;
+            glm::mat4 modelMatrix;
+
+        }; // VisibleObject
+
+        // a host visible buffer kept per frame index, written by the CPU every frame and read once by the GPU
+        struct FrameBuffer {
+            VkBuffer buffer = VK_NULL_HANDLE;
+            LveAllocation memory{}; // stays mapped
+            VkDeviceSize capacity = 0; // in bytes
+
+        }; // FrameBuffer
+
+        struct FrameResources {
+            FrameBuffer instances{}; // InstanceData
+            FrameBuffer drawCommands{}; // VkDrawIndexedIndirectCommand, indirect path only
+            FrameBuffer drawCounts{}; // a uint32_t per indirect draw, only with VK_KHR_draw_indirect_count
+
+        }; // FrameResources
+
+        // only between beginFrame and the first draw that uses the buffers of frameIndex
+        FrameResources& frameFor(uint32_t frameIndex);
+        void reserve(FrameBuffer& frameBuffer, VkDeviceSize size, VkBufferUsageFlags usage);
+        // grows the instance buffer of frameIndex to hold instanceCount
+        const FrameBuffer& instancesFor(uint32_t frameIndex, size_t instanceCount);
+
+        // the resident objects whose bounding sphere is inside the frustum, with their LOD,
+        // sorted so objects sharing a model and LOD are next to each other, adds to the cull stats
+        std::vector<VisibleObject> collectVisible(std::span<LveGameObject> gameObjects, const LveCamera& camera, const LveFrustum& frustum);
+        void resetCullStats();
+        // the pipeline for the model's vertex format
+        LvePipeline* pipelineFor(const LveModel& model) const;
+
+        // coarsest LOD whose simplification error stays under LOD_ERROR_THRESHOLD of the screen height at this distance
+        static uint32_t selectLod(const LveModel& model, const glm::mat4& modelMatrix, const LveCamera& camera);
+
+        // groups, binds and draws, only reads the objects and writes instance slots firstInstance up to firstInstance + the object count,
+        // so slices of one vector can be recorded on several threads
+        void recordGameObjects(
+            VkCommandBuffer commandBuffer,
+            std::span<LveGameObject> gameObjects,
+            const FrameBuffer& instances,
+            uint32_t firstInstance,
+            const glm::mat4& projectionView,
+            const LveCamera& camera,
+            const LveFrustum& frustum);
+
         void createPipelineLayout();
         void createPipeline(VkRenderPass renderPass);
+        std::unique_ptr<LvePipeline> createPipeline(VkRenderPass renderPass, LveModel::VertexFormat vertexFormat);
 
         LveDevice& lveDevice;
 
         std::unique_ptr<LvePipeline> lvePipeline;
+        std::unique_ptr<LvePipeline> packedLvePipeline; // same shaders, reads LveModel::PackedVertex
         VkPipelineLayout pipelineLayout;
         std::unique_ptr<LveModel> lveModel;
+        std::vector<FrameResources> frames{}; // by frame index, grown on demand
+
+        // slices recorded on several threads add to these at the same time
+        std::atomic<uint32_t> visibleCount{ 0 };
+        std::atomic<uint32_t> culledCount{ 0 };
 
     }; // SimpleRenderSystem
 
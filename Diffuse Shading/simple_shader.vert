@@ -1,28 +1,43 @@
 #version 450
 
+// with packed vertices (LveModel::PackedVertex) the vertex fetch already turns everything into floats:
+// position comes in as 0..1 inside the mesh bounds and is dequantized by instanceTransform,
+// normal comes in as an octahedral encoded xy with z = 0 and is decoded below
+layout(constant_id = 0) const bool PACKED_VERTICES = false;
+
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec3 color;
 layout(location = 2) in vec3 normal;
 layout(location = 3) in vec2 uv;
 
-layout(location = 0) out vec3 fragColor;
-
-layout(push_constant) uniform Push {
-	mat4 transform; // proj * view * model
-	mat4 modelMatrix;
+// per instance, every draw is instanced (SimpleRenderSystem::InstanceData), a mat4 takes four locations
+layout(location = 4) in mat4 instanceTransform; // proj * view * model * dequantize
+layout(location = 8) in mat4 instanceModelMatrix;
 
-} push;
+layout(location = 0) out vec3 fragColor;
 
 const vec3 DIRECTION_TO_LIGHT = normalize(vec3(1.0, -3.0, -1.0));
 const float AMBIENT = 0.02;
 
+vec3 octDecode(vec2 encoded) {
+	vec3 n = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+	// unfold the lower half of the octahedron
+	float t = max(-n.z, 0.0);
+	n.x += n.x >= 0.0 ? -t : t;
+	n.y += n.y >= 0.0 ? -t : t;
+	return normalize(n);
+
+} // octDecode
+
 void main() {
-	gl_Position = push.transform * vec4(position, 1.0);
+	gl_Position = instanceTransform * vec4(position, 1.0);
+
+	vec3 vertexNormal = PACKED_VERTICES ? octDecode(normal.xy) : normal;
 
 	// temporary: this is only correct in certain conditions
 	// only works correctly if scale is uniform (Sx == Sy == Sz)
-	vec3 normalWorldSpace = normalize(mat3(push.modelMatrix) * normal);
-	// this also works: vec3 normalWorldSpace = normalize(push.modelMatrix * vec4(normal, 0.0).xyz);
+	vec3 normalWorldSpace = normalize(mat3(instanceModelMatrix) * vertexNormal);
+	// this also works: vec3 normalWorldSpace = normalize(instanceModelMatrix * vec4(normal, 0.0).xyz);
 
 	float lightIntensity = AMBIENT + max(dot(normalWorldSpace, DIRECTION_TO_LIGHT), 0);
 	fragColor = lightIntensity * color;
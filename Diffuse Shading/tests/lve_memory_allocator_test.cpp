@@ -0,0 +1,285 @@
+// standalone, LveMemoryAllocator runs against a fake Backend and a made up memory type table, so no GPU is needed
+// it still links against the Vulkan loader for vulkanBackend, which is never called:
+// cl /std:c++20 /EHsc /I"%VULKAN_SDK%\Include" tests\lve_memory_allocator_test.cpp lve_memory_allocator.cpp lve_range_allocator.cpp "%VULKAN_SDK%\Lib\vulkan-1.lib"
+// g++ -std=c++20 tests/lve_memory_allocator_test.cpp lve_memory_allocator.cpp lve_range_allocator.cpp -lvulkan
+#include "../lve_memory_allocator.hpp"
+
+// std
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+
+namespace {
+
+	constexpr VkDeviceSize MB = 1024ull * 1024;
+	constexpr VkDeviceSize GB = 1024 * MB;
+
+	int failures = 0;
+
+	void check(bool condition, const char* what) {
+		if (!condition) {
+			std::cerr << "FAILED: " << what << "\n";
+			failures++;
+
+		} // if
+
+	} // check
+
+	// hands out numbered handles instead of memory, nothing is ever dereferenced
+	struct FakeDevice {
+		struct Memory {
+			uint32_t memoryType;
+			VkDeviceSize size;
+
+		}; // Memory
+
+		std::map<VkDeviceMemory, Memory> live{};
+		uint64_t nextHandle = 1;
+		uint32_t allocateCalls = 0;
+		uint32_t freeCalls = 0;
+		uint32_t mapCalls = 0;
+
+		lve::LveMemoryAllocator::Backend backend() {
+			lve::LveMemoryAllocator::Backend backend{};
+			backend.allocateMemory = [this](uint32_t memoryType, VkDeviceSize size, VkDeviceMemory& memory) {
+				memory = reinterpret_cast<VkDeviceMemory>(static_cast<uintptr_t>(nextHandle++));
+				live[memory] = { memoryType, size };
+				allocateCalls++;
+				return VK_SUCCESS;
+
+			}; // allocateMemory
+
+			backend.freeMemory = [this](VkDeviceMemory memory) {
+				check(live.erase(memory) == 1, "only memory the backend handed out is freed, and only once");
+				freeCalls++;
+
+			}; // freeMemory
+
+			backend.mapMemory = [this](VkDeviceMemory memory) {
+				mapCalls++;
+				return reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(memory) << 32);
+
+			}; // mapMemory
+
+			return backend;
+
+		} // backend
+
+	}; // FakeDevice
+
+	// a discrete GPU: device local VRAM, host memory, and the 256 MB window of VRAM the CPU can see
+	VkPhysicalDeviceMemoryProperties discreteGpu() {
+		VkPhysicalDeviceMemoryProperties properties{};
+		properties.memoryHeapCount = 3;
+		properties.memoryHeaps[0] = { 8 * GB, VK_MEMORY_HEAP_DEVICE_LOCAL_BIT };
+		properties.memoryHeaps[1] = { 16 * GB, 0 };
+		properties.memoryHeaps[2] = { 256 * MB, VK_MEMORY_HEAP_DEVICE_LOCAL_BIT };
+
+		properties.memoryTypeCount = 3;
+		properties.memoryTypes[0] = { VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0 };
+		properties.memoryTypes[1] = { VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 1 };
+		properties.memoryTypes[2] = { VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 2 };
+		return properties;
+
+	} // discreteGpu
+
+	VkMemoryRequirements requirements(VkDeviceSize size, VkDeviceSize alignment, uint32_t memoryTypeBits = 0b111) {
+		return VkMemoryRequirements{ size, alignment, memoryTypeBits };
+
+	} // requirements
+
+	void picksMemoryTypes() {
+		FakeDevice fake{};
+		lve::LveMemoryAllocator allocator{ discreteGpu(), fake.backend() };
+
+		check(allocator.findMemoryType(0b111, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) == 0, "first type with the flags wins");
+		check(allocator.findMemoryType(0b110, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) == 2, "types outside memoryTypeBits are skipped");
+		check(allocator.findMemoryType(0b111, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) == 1, "host visible finds host memory");
+
+		bool threw = false;
+		try {
+			allocator.allocate(requirements(256, 16, 0b001), VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, true);
+
+		} // try
+		catch (const std::runtime_error&) {
+			threw = true;
+
+		} // catch
+
+		check(threw, "no matching type throws");
+		check(fake.allocateCalls == 0, "nothing is allocated when no type matches");
+
+		const lve::LveAllocation hostVisible = allocator.allocate(requirements(256, 16), VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, true);
+		check(hostVisible.memoryType == 1, "allocation lands in the chosen type");
+		check(fake.live[hostVisible.memory].memoryType == 1, "the block is allocated from the chosen type");
+		check(hostVisible.mapped != nullptr && fake.mapCalls == 1, "host visible blocks are mapped once");
+
+		const lve::LveAllocation deviceLocal = allocator.allocate(requirements(256, 16), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+		check(deviceLocal.mapped == nullptr && fake.mapCalls == 1, "device local blocks are not mapped");
+
+		allocator.free(hostVisible);
+		allocator.free(deviceLocal);
+
+	} // picksMemoryTypes
+
+	void alignsRanges() {
+		FakeDevice fake{};
+		lve::LveMemoryAllocator allocator{ discreteGpu(), fake.backend() };
+
+		const lve::LveAllocation a = allocator.allocate(requirements(100, 256), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+		const lve::LveAllocation b = allocator.allocate(requirements(100, 256), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+		check(a.memory == b.memory, "small allocations share a block");
+		check(a.offset == 0 && b.offset == 256, "sizes are rounded up to the alignment");
+		check(a.size == 100 && a.rangeSize == 256, "the allocation keeps the asked size and the reserved range");
+
+		const lve::LveAllocation c = allocator.allocate(requirements(10, 4096), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+		check(c.offset == 4096, "a bigger alignment skips ahead to its next multiple");
+
+		const lve::LveAllocation mapped = allocator.allocate(requirements(64, 64), VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, true);
+		const lve::LveAllocation mappedNext = allocator.allocate(requirements(64, 64), VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, true);
+		check(static_cast<char*>(mappedNext.mapped) - static_cast<char*>(mapped.mapped) == 64, "mapped pointers are offset into the block");
+
+		for (const auto& allocation : { a, b, c, mapped, mappedNext })
+			allocator.free(allocation);
+
+	} // alignsRanges
+
+	void separatesLinearAndOptimal() {
+		FakeDevice fake{};
+		lve::LveMemoryAllocator allocator{ discreteGpu(), fake.backend() };
+
+		const lve::LveAllocation buffer = allocator.allocate(requirements(1024, 16), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+		const lve::LveAllocation image = allocator.allocate(requirements(1024, 16), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false);
+		const lve::LveAllocation otherImage = allocator.allocate(requirements(1024, 16), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false);
+		check(buffer.memory != image.memory, "linear and optimal resources never share a block");
+		check(image.memory == otherImage.memory, "optimal resources share their own block");
+		check(allocator.getStats().blockCount == 2, "one block per memory type and tiling");
+
+		allocator.free(buffer);
+		allocator.free(image);
+		allocator.free(otherImage);
+
+	} // separatesLinearAndOptimal
+
+	void dedicatesLargeAllocations() {
+		FakeDevice fake{};
+		lve::LveMemoryAllocator allocator{ discreteGpu(), fake.backend() };
+
+		// the 256 MB heap is small, its blocks are an eighth of it instead of the preferred 64 MB
+		const lve::LveAllocation small = allocator.allocate(requirements(15 * MB, 256, 0b100), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+		check(small.block != nullptr, "below half a block goes into a block");
+		check(fake.live[small.memory].size == 32 * MB, "blocks on a heap of 1 GB or less are an eighth of it");
+
+		const lve::LveAllocation large = allocator.allocate(requirements(17 * MB, 256, 0b100), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+		check(large.block == nullptr && large.offset == 0, "above half a block gets memory of its own");
+		check(fake.live[large.memory].size == 17 * MB, "a dedicated allocation is exactly the asked size");
+		check(large.mapped != nullptr, "dedicated host visible memory is mapped too");
+
+		const lve::LveAllocation big = allocator.allocate(requirements(17 * MB, 256, 0b001), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+		check(big.block != nullptr && fake.live[big.memory].size == 64 * MB, "the large heap still uses the preferred block size");
+
+		lve::LveMemoryAllocator::Stats stats = allocator.getStats();
+		check(stats.dedicatedCount == 1 && stats.dedicatedBytes == 17 * MB, "dedicated allocations are counted on their own");
+
+		allocator.free(large);
+		check(!fake.live.contains(large.memory), "freeing a dedicated allocation frees its memory right away");
+		check(allocator.getStats().dedicatedCount == 0, "and takes it out of the stats");
+
+		allocator.free(small);
+		allocator.free(big);
+
+	} // dedicatesLargeAllocations
+
+	void reusesBlocks() {
+		FakeDevice fake{};
+		lve::LveMemoryAllocator allocator{ discreteGpu(), fake.backend() };
+
+		const lve::LveAllocation first = allocator.allocate(requirements(1024, 16), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+		allocator.free(first);
+		check(fake.freeCalls == 0 && allocator.getStats().blockCount == 1, "the last empty block of a pool is kept");
+
+		const lve::LveAllocation second = allocator.allocate(requirements(1024, 16), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+		check(second.memory == first.memory && second.offset == 0, "the kept block is used again");
+		check(fake.allocateCalls == 1, "without asking the driver again");
+
+		// two blocks of 64 MB, emptying both only keeps one of them
+		const lve::LveAllocation fill = allocator.allocate(requirements(30 * MB, 16), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+		const lve::LveAllocation moreFill = allocator.allocate(requirements(30 * MB, 16), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+		check(moreFill.memory == second.memory, "the block is filled before another is made");
+		const lve::LveAllocation overflow = allocator.allocate(requirements(30 * MB, 16), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+		check(overflow.memory != second.memory && fake.allocateCalls == 2, "a full block makes another one");
+
+		allocator.free(second);
+		allocator.free(fill);
+		allocator.free(moreFill);
+		allocator.free(overflow);
+		check(fake.freeCalls == 1 && allocator.getStats().blockCount == 1, "a second empty block goes back to the driver");
+
+	} // reusesBlocks
+
+	void countsStats() {
+		FakeDevice fake{};
+		lve::LveMemoryAllocator allocator{ discreteGpu(), fake.backend() };
+
+		const lve::LveAllocation a = allocator.allocate(requirements(100, 256), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+		const lve::LveAllocation b = allocator.allocate(requirements(1000, 512), VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, true);
+
+		lve::LveMemoryAllocator::Stats stats = allocator.getStats();
+		check(stats.blockCount == 2 && stats.blockBytes == 2 * lve::LveMemoryAllocator::DEFAULT_BLOCK_SIZE, "blocks and their bytes");
+		check(stats.allocationCount == 2, "live allocations");
+		check(stats.usedBytes == 1100, "used is what the resources asked for");
+		check(stats.wastedBytes == (256 - 100) + (1024 - 1000), "wasted is the rounding up to the alignment");
+
+		allocator.free(a);
+		stats = allocator.getStats();
+		check(stats.allocationCount == 1 && stats.usedBytes == 1000 && stats.wastedBytes == 24, "freeing takes both back out");
+
+		allocator.free(b);
+		stats = allocator.getStats();
+		check(stats.allocationCount == 0 && stats.usedBytes == 0 && stats.wastedBytes == 0, "nothing is used once everything is freed");
+		check(stats.blockCount == 2, "empty blocks are still counted while they are kept");
+
+	} // countsStats
+
+	void releasesBlocksOnDestruction() {
+		FakeDevice fake{};
+
+		{
+			lve::LveMemoryAllocator allocator{ discreteGpu(), fake.backend() };
+			const lve::LveAllocation a = allocator.allocate(requirements(1024, 16), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+			const lve::LveAllocation b = allocator.allocate(requirements(1024, 16), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false);
+			const lve::LveAllocation c = allocator.allocate(requirements(1024, 16), VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, true);
+			allocator.free(a);
+			allocator.free(b);
+			allocator.free(c);
+			check(fake.live.size() == 3, "empty blocks are kept until the allocator goes");
+
+		}
+
+		check(fake.live.empty(), "the destructor hands every block back");
+		check(fake.freeCalls == fake.allocateCalls, "every allocation from the backend is freed exactly once");
+
+	} // releasesBlocksOnDestruction
+
+} // namespace
+
+int main() {
+	picksMemoryTypes();
+	alignsRanges();
+	separatesLinearAndOptimal();
+	dedicatesLargeAllocations();
+	reusesBlocks();
+	countsStats();
+	releasesBlocksOnDestruction();
+
+	if (failures > 0) {
+		std::cerr << failures << " checks failed\n";
+		return 1;
+
+	} // if
+
+	std::cout << "all memory allocator checks passed\n";
+	return 0;
+
+} // main
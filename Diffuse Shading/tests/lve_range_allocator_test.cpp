@@ -0,0 +1,94 @@
+// standalone, LveRangeAllocator has no Vulkan in it so it builds on its own
+// cl /std:c++20 /EHsc tests\lve_range_allocator_test.cpp lve_range_allocator.cpp
+// g++ -std=c++20 tests/lve_range_allocator_test.cpp lve_range_allocator.cpp
+#include "../lve_range_allocator.hpp"
+
+// std
+#include <cstdint>
+#include <iostream>
+
+namespace {
+
+	int failures = 0;
+
+	void check(bool condition, const char* what) {
+		if (!condition) {
+			std::cerr << "FAILED: " << what << "\n";
+			failures++;
+
+		} // if
+
+	} // check
+
+	void allocatesInOrder() {
+		lve::LveRangeAllocator allocator{ 100 };
+		check(allocator.allocate(10) == 0, "first range starts at 0");
+		check(allocator.allocate(20) == 10, "second range follows the first");
+		check(allocator.getFreeSize() == 70, "free size drops by what was handed out");
+		check(allocator.allocate(71) == lve::LveRangeAllocator::INVALID_OFFSET, "too big a request fails");
+		check(allocator.allocate(70) == 30, "the rest still fits exactly");
+		check(allocator.getFreeSize() == 0, "nothing is left");
+
+	} // allocatesInOrder
+
+	void coalescesOutOfOrder() {
+		lve::LveRangeAllocator allocator{ 40 };
+		const uint64_t a = allocator.allocate(10);
+		const uint64_t b = allocator.allocate(10);
+		const uint64_t c = allocator.allocate(10);
+		const uint64_t d = allocator.allocate(10);
+
+		// b and d are apart, so neither can hold 20
+		allocator.free(b, 10);
+		allocator.free(d, 10);
+		check(allocator.allocate(20) == lve::LveRangeAllocator::INVALID_OFFSET, "separate free ranges do not merge");
+
+		// c has free neighbours on both sides, b through d become one range
+		allocator.free(c, 10);
+		const uint64_t merged = allocator.allocate(30);
+		check(merged == b, "freeing between two free ranges merges all three");
+		allocator.free(merged, 30);
+
+		// a merges with the range after it
+		allocator.free(a, 10);
+		check(allocator.isEmpty(), "everything is free again");
+		check(allocator.allocate(40) == 0, "the whole capacity is one range again");
+
+	} // coalescesOutOfOrder
+
+	void padsForAlignment() {
+		lve::LveRangeAllocator allocator{ 64 };
+		check(allocator.allocate(3) == 0, "unaligned range starts at 0");
+		check(allocator.allocate(16, 16) == 16, "aligned range skips to the next multiple");
+		check(allocator.getFreeSize() == 64 - 3 - 16, "the padding is not counted as used");
+
+		// best fit, the 13 bytes of padding are the smallest free range that holds 13
+		check(allocator.allocate(13) == 3, "the padding in front stays free");
+		check(allocator.allocate(8, 8) == 32, "aligned range after the others");
+
+		allocator.free(16, 16);
+		allocator.free(0, 3);
+		allocator.free(3, 13);
+		allocator.free(32, 8);
+		check(allocator.isEmpty(), "padding merges back once its neighbours are free");
+		check(allocator.allocate(64) == 0, "the whole capacity is one range again");
+
+	} // padsForAlignment
+
+} // namespace
+
+int main() {
+	allocatesInOrder();
+	coalescesOutOfOrder();
+	padsForAlignment();
+
+	if (failures > 0) {
+		std::cerr << failures << " checks failed\n";
+		return 1;
+
+	} // if
+
+	std::cout << "all range allocator checks passed\n";
+	return 0;
+
+} // main